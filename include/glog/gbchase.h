@@ -12,8 +12,31 @@
 
 #include <chrono>
 
+//Max number of execution plans per thread which are executed in parallel
+//before their derivations are added to the graph
+#define GBCHASE_PARALLEL_WINDOW 4
+//Fraction of the memory budget above which the nodes are compressed
+#define GBCHASE_MEMBUDGET_COMPRESS_RATIO 0.8
+
 typedef enum { GBCHASE, TGCHASE_STATIC, TGCHASE_DYNAMIC,TGCHASE_DYNAMIC_FULLPROV, PROBTGCHASE } GBChaseAlgorithm;
 
+//Stores the output of the execution of a rule before it is added to the graph
+struct GBRuleExecution {
+    std::vector<GBRuleOutput> outputs;
+    std::chrono::duration<double, std::milli> durationExec;
+    std::chrono::duration<double, std::milli> durationFirst;
+    std::chrono::duration<double, std::milli> durationMerge;
+    std::chrono::duration<double, std::milli> durationJoin;
+    std::chrono::duration<double, std::milli> durationHead;
+    std::string bdyAtoms;
+    GBRuleExecutionStats stats;
+    std::chrono::system_clock::time_point start;
+    int thread; //0 is the main thread
+
+    GBRuleExecution() : durationExec(0), durationFirst(0), durationMerge(0),
+    durationJoin(0), durationHead(0), thread(0) {}
+};
+
 class GBChase : public Chase {
     protected:
         const GBGraph::ProvenanceType provenanceType;
@@ -24,11 +47,24 @@ class GBChase : public Chase {
         GBGraph g; //Stores the derivations
         std::vector<Rule> rules;
         std::unique_ptr<GBRuleExecutor> executor; //Object that executes rules
+        std::vector<std::unique_ptr<GBRuleExecutor>> workers; //Used by threads
 
         //Used for statistics
         size_t triggers;
         std::chrono::duration<double, std::milli> durationRuleExec;
 
+        //Number of threads used to execute the rules of a step
+        size_t nthreads;
+        //Compress the nodes that are no longer used as delta
+        bool compressNodes;
+        //Max n. bytes used by the graph and the caches (0 = no limit)
+        size_t memoryBudget;
+        size_t segmentCacheMaxSize;
+        //Nodes are spilled after they are not used for so many steps
+        size_t spillColdSteps;
+
+        void checkMemoryBudget(size_t step);
+
 
     private:
         std::vector<int> stratification;
@@ -64,6 +100,13 @@ class GBChase : public Chase {
 
         bool shouldRetainAtEnd(PredId_t pred);
 
+        bool isParallelizable(const GBRuleInput &node) const;
+
+        void executeRulesInParallel(
+                std::vector<GBRuleInput> &nodes,
+                const size_t start,
+                const size_t end);
+
     protected:
         bool shouldTrackProvenance() const {
             return provenanceType != GBGraph::ProvenanceType::NOPROV;
@@ -88,7 +131,20 @@ class GBChase : public Chase {
                 const size_t step,
                 std::vector<GBRuleInput> &newnodes);
 
-        virtual bool executeRule(GBRuleInput &node, bool cleanDuplicates = true);
+        void computeRuleExecution(GBRuleExecutor &e,
+                GBRuleInput &node,
+                GBRuleExecution &out);
+
+        virtual bool commitRuleExecution(GBRuleInput &node,
+                GBRuleExecution &execution,
+                bool cleanDuplicates = true);
+
+        //Fill the statistics of an execution which are common to all chases
+        void fillStatsRule(StatsRule &stats, const GBRuleInput &node,
+                const GBRuleExecution &execution,
+                std::chrono::system_clock::time_point startRetain);
+
+        bool executeRule(GBRuleInput &node, bool cleanDuplicates = true);
 
         virtual size_t executeRulesInStratum(
                 const std::vector<size_t> &ruleIdxs,
@@ -107,8 +163,47 @@ class GBChase : public Chase {
 
         void prepareRun(size_t startStep, size_t maxStep);
 
+        //The execution plans of the same step are executed by n threads
+        void setNThreads(size_t n) {
+            nthreads = n > 0 ? n : 1;
+            RadixSort::setNThreads(nthreads);
+        }
+
+        size_t getNThreads() const {
+            return nthreads;
+        }
+
+        void setCompressNodes(bool flag) {
+            compressNodes = flag;
+        }
+
+        //When the memory used exceeds the budget, first the segment cache
+        //is shrunk and then the nodes are compressed and (if enabled)
+        //spilled
+        void setMemoryBudget(size_t bytes) {
+            memoryBudget = bytes;
+        }
+
+        //Write the nodes that are not used for coldSteps steps to a
+        //memory-mapped file. They are loaded again when they are accessed
+        void setSpill(const std::string &path, size_t coldSteps) {
+            g.setSpillFile(path);
+            spillColdSteps = coldSteps;
+        }
+
+        size_t getMemoryUsage() const;
+
+        void printMemoryUsage() const;
+
         VLIBEXP virtual void run();
 
+        //Store the graph computed by run() so that it can be reloaded later
+        void storeSnapshot(const std::string &path) const;
+
+        //Load a graph stored with storeSnapshot(). A following call to run()
+        //resumes the chase from the last step in the snapshot
+        void loadSnapshot(const std::string &path);
+
         Program *getProgram();
 
         EDBLayer &getEDBLayer();
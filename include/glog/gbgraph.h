@@ -8,8 +8,13 @@
 
 #include <map>
 
+//A run of the retain cache is merged with the next one if it is not at
+//least this many times larger
+#define GBGRAPH_RETAIN_MERGE_FACTOR 4
+
 class GBQuerier;
 class GBSegmentInserter;
+class GBSpillFile;
 class GBGraph {
     public:
         typedef enum ProvenanceType {
@@ -91,9 +96,12 @@ class GBGraph {
             size_t step;
         };
 
+        //Sorted runs with the tuples of the first nnodes nodes of a
+        //predicate. Runs are ordered by decreasing size (see updateCacheRetain)
         struct CacheRetainEntry {
             size_t nnodes;
-            std::shared_ptr<const TGSegment> seg;
+            std::vector<std::shared_ptr<const TGSegment>> runs;
+            CacheRetainEntry() : nnodes(0) {}
         };
 
         const ProvenanceType provenanceType;
@@ -109,6 +117,17 @@ class GBGraph {
         std::map<PredId_t, std::vector<GBGraph_TmpPredNode>> mapPredTmpNodes;
         std::map<PredId_t, CacheRetainEntry> cacheRetain;
 
+        //Sorted projection of all the nodes of a predicate, used by the
+        //restricted check (see getRestrictedCheckIndex). The key contains the
+        //predicate, the constants to filter and the projected positions
+        struct RestrictedCheckIndexEntry {
+            size_t nnodes;
+            std::shared_ptr<const TGSegment> seg;
+            RestrictedCheckIndexEntry() : nnodes(0) {}
+        };
+        std::map<std::pair<PredId_t, std::vector<Term_t>>,
+            RestrictedCheckIndexEntry> restrictedCheckIndex;
+
         //Counter variables
         uint64_t counterNullValues;
         uint32_t counterFreshVarsQueryCont;
@@ -125,6 +144,25 @@ class GBGraph {
         std::chrono::duration<double, std::milli> durationQueryContain2;
         std::chrono::duration<double, std::milli> durationEDBCheck;
         std::chrono::duration<double, std::milli> durationCompression;
+        std::chrono::duration<double, std::milli> durationCompressNodes;
+        size_t sizeNodesBeforeCompression;
+        size_t sizeNodesAfterCompression;
+
+        //Stores the data of the cold nodes (see spillNodes)
+        std::shared_ptr<GBSpillFile> spillFile;
+        std::chrono::duration<double, std::milli> durationSpill;
+        size_t nSpilledNodes;
+        size_t nReleasedNodes;
+
+        //Add a run with the tuples of the nodes of p that are not yet in the
+        //cache and merge the runs of similar size
+        void updateCacheRetain(PredId_t p, size_t ncolumns);
+
+        //Merge two sorted segments without provenance
+        static std::shared_ptr<const TGSegment> mergeSortedSegments(
+                std::shared_ptr<const TGSegment> seg1,
+                std::shared_ptr<const TGSegment> seg2,
+                bool removeDuplicates);
 
         std::shared_ptr<const TGSegment> retainVsNodeFast(
                 std::shared_ptr<const TGSegment> existuples,
@@ -371,6 +409,12 @@ class GBGraph {
             durationQueryContain2(0),
             durationEDBCheck(0),
             durationCompression(0),
+            durationCompressNodes(0),
+            sizeNodesBeforeCompression(0),
+            sizeNodesAfterCompression(0),
+            durationSpill(0),
+            nSpilledNodes(0),
+            nReleasedNodes(0),
             allRules(NULL),
             layer(NULL), program(NULL) {
                 counterNullValues = RULE_SHIFT(1);
@@ -454,6 +498,15 @@ class GBGraph {
                 bool replaceOffsets = false,
                 bool removeDuplicates = true) const;
 
+        //Returns the tuples of all the nodes with predId that match
+        //filterConstants, projected to copyVarPos, sorted and without
+        //duplicates. The result is kept and only the nodes added since the
+        //previous call are merged into it
+        std::shared_ptr<const TGSegment> getRestrictedCheckIndex(
+                PredId_t predId,
+                const std::vector<Term_t> &filterConstants,
+                const std::vector<int> &copyVarPos);
+
         std::shared_ptr<const TGSegment> mergeNodes(
                 const std::vector<size_t> &nodeIdxs,
                 const std::vector<int> &copyVarPos,
@@ -547,6 +600,51 @@ class GBGraph {
 
         std::shared_ptr<GBQuerier> getQuerier() const;
 
+        //Replace the data of the nodes derived before maxStep with
+        //compressed segments (see TGSegmentCompressed)
+        void compressNodes(size_t maxStep, size_t nthreads = 1);
+
+        //Drop the decompressed copies of the compressed nodes, once the
+        //operation that needed them is finished
+        void releaseDecompressed(const std::vector<size_t> &nodeIds) const;
+
+        //Approximate number of bytes used by the data of the nodes, by the
+        //temporary nodes and by the caches of retain and of the restricted
+        //check
+        size_t getSizeNodes() const;
+
+        size_t getSizeTmpNodes() const;
+
+        size_t getSizeCacheRetain() const;
+
+        //Drop the index of the restricted check. It is rebuilt when needed
+        void clearRestrictedCheckIndex() {
+            restrictedCheckIndex.clear();
+        }
+
+        //Enable spilling the data of the nodes to the given file
+        void setSpillFile(const std::string &path);
+
+        bool isSpillEnabled() const {
+            return spillFile != NULL;
+        }
+
+        //Write to the spill file the data of the nodes derived at least
+        //coldSteps steps ago, and remove from memory the spilled data that
+        //was not accessed in the last coldSteps steps. Spilled data is
+        //loaded again when it is accessed
+        void spillNodes(size_t step, size_t coldSteps);
+
+        size_t getSizeSpillFile() const;
+
+        /*** Implemented in gbgraph_snapshot.cpp ***/
+        //Store all the nodes in a binary file
+        void store(const std::string &path) const;
+
+        //Load the nodes stored with store(). The graph must be empty. Returns
+        //the last step of the chase that produced the nodes
+        size_t load(const std::string &path);
+
         void printStats() {
             LOG(INFOL) << "Time retain (ms): " << durationRetain.count();
             LOG(INFOL) << "Time query containment (unary) (ms): " <<
@@ -559,6 +657,21 @@ class GBGraph {
             LOG(INFOL) << "Time EDB check (ms): " <<
                 durationEDBCheck.count();
             LOG(INFOL) << "Time compressing lineage (ms): " << durationCompression.count();
+            LOG(INFOL) << "Memory nodes (MB): " << getSizeNodes() / 1024 / 1024;
+            LOG(INFOL) << "Memory tmp nodes (MB): " <<
+                getSizeTmpNodes() / 1024 / 1024;
+            LOG(INFOL) << "Memory cache retain (MB): " <<
+                getSizeCacheRetain() / 1024 / 1024;
+            LOG(INFOL) << "Time compressing nodes (ms): " <<
+                durationCompressNodes.count() << " size before (MB): " <<
+                sizeNodesBeforeCompression / 1024 / 1024 <<
+                " size after (MB): " << sizeNodesAfterCompression / 1024 / 1024;
+            if (isSpillEnabled()) {
+                LOG(INFOL) << "Time spilling nodes (ms): " <<
+                    durationSpill.count() << " spilled: " << nSpilledNodes <<
+                    " released: " << nReleasedNodes << " size spill file (MB): "
+                    << getSizeSpillFile() / 1024 / 1024;
+            }
         }
 
         static std::vector<size_t> postprocessProvenance(
@@ -8,6 +8,8 @@ class TGSegmentLegacy : public TGSegment {
         const size_t nrows;
         const bool f_isSorted;
         const uint8_t sortedField;
+        //Fields used by sort() or sortBy(). Empty if unknown
+        const std::vector<uint8_t> sortedFields;
         const std::vector<std::shared_ptr<Column>> columns;
         const SegProvenanceType provenanceType;
         const size_t nprovcolumns;
@@ -25,10 +27,13 @@ class TGSegmentLegacy : public TGSegment {
         TGSegmentLegacy(const std::vector<std::shared_ptr<Column>> &columns,
                 size_t nrows, bool isSorted=false, uint8_t sortedField = 0,
                 SegProvenanceType provenanceType = SegProvenanceType::SEG_NOPROV,
-                size_t nprovcolumns = 0) :
+                size_t nprovcolumns = 0,
+                const std::vector<uint8_t> &sortedFields =
+                std::vector<uint8_t>()) :
             nrows(nrows),
             f_isSorted(isSorted),
             sortedField(sortedField),
+            sortedFields(sortedFields),
             columns(columns),
             provenanceType(provenanceType),
             nprovcolumns(nprovcolumns)
@@ -96,6 +101,8 @@ class TGSegmentLegacy : public TGSegment {
 
         bool isSortedBy(std::vector<uint8_t> &fields) const;
 
+        static std::vector<uint8_t> getFirstFields(size_t n);
+
         std::shared_ptr<const TGSegment> sort() const;
 
         void argsort(std::vector<size_t> &indices) const;
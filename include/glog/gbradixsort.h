@@ -0,0 +1,294 @@
+#ifndef _GB_RADIXSORT_H
+#define _GB_RADIXSORT_H
+
+#include <vlog/concepts.h>
+
+#include <glog/gbsegmentitr.h>
+
+#include <trident/utils/parallel.h>
+
+#include <vector>
+#include <algorithm>
+
+//Inputs smaller than this are sorted with a comparison sort
+#define RADIXSORT_MIN_SIZE 256
+//Minimum number of rows that each thread should sort
+#define RADIXSORT_MIN_ROWS_THREAD 65536
+#define RADIXSORT_NDIGITS (sizeof(Term_t))
+#define RADIXSORT_NBUCKETS 256
+
+//The key extractors return the i-th key of a row (0 is the most significant
+//one). By default, rows are sorted according to all their fields.
+template<typename K>
+struct RadixKeys;
+
+template<>
+struct RadixKeys<Term_t> {
+    size_t nkeys() const {
+        return 1;
+    }
+    Term_t get(const Term_t &r, const size_t i) const {
+        return r;
+    }
+};
+
+template<>
+struct RadixKeys<std::pair<Term_t,Term_t>> {
+    size_t nkeys() const {
+        return 2;
+    }
+    Term_t get(const std::pair<Term_t,Term_t> &r, const size_t i) const {
+        return i == 0 ? r.first : r.second;
+    }
+};
+
+template<>
+struct RadixKeys<BinWithProv> {
+    size_t nkeys() const {
+        return 3;
+    }
+    Term_t get(const BinWithProv &r, const size_t i) const {
+        return i == 0 ? r.first : (i == 1 ? r.second : r.node);
+    }
+};
+
+template<>
+struct RadixKeys<BinWithOff> {
+    size_t nkeys() const {
+        return 3;
+    }
+    Term_t get(const BinWithOff &r, const size_t i) const {
+        return i == 0 ? r.first : (i == 1 ? r.second : r.off);
+    }
+};
+
+template<>
+struct RadixKeys<UnWithFullProv> {
+    size_t nkeys() const {
+        return 3;
+    }
+    Term_t get(const UnWithFullProv &r, const size_t i) const {
+        return i == 0 ? r.first : (i == 1 ? r.node : r.prov);
+    }
+};
+
+template<>
+struct RadixKeys<BinWithFullProv> {
+    size_t nkeys() const {
+        return 4;
+    }
+    Term_t get(const BinWithFullProv &r, const size_t i) const {
+        switch (i) {
+            case 0:
+                return r.first;
+            case 1:
+                return r.second;
+            case 2:
+                return r.node;
+            default:
+                return r.prov;
+        }
+    }
+};
+
+//Sort by the second field, then by the first one (see invertedSorter)
+template<typename K>
+struct RadixKeysInverted {
+    size_t nkeys() const {
+        return 2;
+    }
+    Term_t get(const K &r, const size_t i) const {
+        return i == 0 ? r.second : r.first;
+    }
+};
+
+//Sort by node, then by the first field and (if any) by the second one
+template<typename K>
+struct RadixKeysNode {
+    size_t nkeys() const {
+        return 3;
+    }
+    Term_t get(const K &r, const size_t i) const {
+        return i == 0 ? r.node : (i == 1 ? r.first : r.second);
+    }
+};
+
+template<>
+struct RadixKeysNode<UnWithFullProv> {
+    size_t nkeys() const {
+        return 2;
+    }
+    Term_t get(const UnWithFullProv &r, const size_t i) const {
+        return i == 0 ? r.node : r.first;
+    }
+};
+
+//Sort row indices by the rows stored in a flat array (see ProvSorter)
+struct RadixKeysRows {
+    const size_t *tuples;
+    const size_t ncols;
+
+    RadixKeysRows(const size_t *tuples, const size_t ncols) :
+        tuples(tuples), ncols(ncols) {
+        }
+
+    size_t nkeys() const {
+        return ncols;
+    }
+    Term_t get(const size_t &r, const size_t i) const {
+        return tuples[r * ncols + i];
+    }
+};
+
+template<typename K, typename Keys>
+struct RadixComparator {
+    const Keys &keys;
+
+    RadixComparator(const Keys &keys) : keys(keys) {}
+
+    bool operator ()(const K &a, const K &b) const {
+        for(size_t i = 0; i < keys.nkeys(); ++i) {
+            auto ka = keys.get(a, i);
+            auto kb = keys.get(b, i);
+            if (ka != kb)
+                return ka < kb;
+        }
+        return false;
+    }
+};
+
+//LSD radix sort on 8-bit digits. It is stable, so it can replace both
+//std::sort and std::stable_sort. Digits that are equal in all rows are
+//skipped, which makes it cheap to sort small integers.
+class RadixSort {
+    private:
+        //Thread-local, so that the sorts invoked by the threads that
+        //execute rules in parallel remain sequential
+        static size_t &defaultNThreads() {
+            static thread_local size_t n = 1;
+            return n;
+        }
+
+        template<typename K, typename Keys>
+        static void scatter(const K *src, K *dst, const size_t start,
+                const size_t end, const Keys &keys, const size_t key,
+                const size_t shift, size_t *offsets) {
+            for(size_t i = start; i < end; ++i) {
+                const auto digit = (keys.get(src[i], key) >> shift) & 0xFF;
+                dst[offsets[digit]++] = src[i];
+            }
+        }
+
+        template<typename K, typename Keys>
+        static void histogram(const K *src, const size_t start,
+                const size_t end, const Keys &keys, const size_t key,
+                size_t *counts) {
+            for(size_t i = start; i < end; ++i) {
+                auto v = keys.get(src[i], key);
+                for(size_t d = 0; d < RADIXSORT_NDIGITS; ++d) {
+                    counts[d * RADIXSORT_NBUCKETS + (v & 0xFF)]++;
+                    v >>= 8;
+                }
+            }
+        }
+
+    public:
+        //Number of threads used by default (set by the chase)
+        static void setNThreads(size_t n) {
+            defaultNThreads() = std::max((size_t)1, n);
+        }
+
+        static size_t getNThreads() {
+            return defaultNThreads();
+        }
+
+        template<typename K, typename Keys>
+        static void sort(std::vector<K> &v, const Keys &keys,
+                size_t nthreads = 0) {
+            const size_t n = v.size();
+            if (n < RADIXSORT_MIN_SIZE) {
+                std::stable_sort(v.begin(), v.end(),
+                        RadixComparator<K, Keys>(keys));
+                return;
+            }
+            if (nthreads == 0)
+                nthreads = getNThreads();
+            nthreads = std::max((size_t)1, std::min(nthreads,
+                        n / RADIXSORT_MIN_ROWS_THREAD));
+
+            std::vector<K> tmp(n);
+            K *src = v.data();
+            K *dst = tmp.data();
+            std::vector<size_t> counts(RADIXSORT_NDIGITS * RADIXSORT_NBUCKETS);
+            std::vector<size_t> threadCounts(nthreads * RADIXSORT_NBUCKETS);
+            for(size_t k = keys.nkeys(); k > 0; --k) {
+                const size_t key = k - 1;
+                //Count the values of all digits of the key with one scan
+                std::fill(counts.begin(), counts.end(), 0);
+                histogram(src, 0, n, keys, key, counts.data());
+                for(size_t d = 0; d < RADIXSORT_NDIGITS; ++d) {
+                    const size_t *c = counts.data() + d * RADIXSORT_NBUCKETS;
+                    const size_t shift = d * 8;
+                    if (c[(keys.get(src[0], key) >> shift) & 0xFF] == n) {
+                        continue; //All rows have the same digit
+                    }
+                    if (nthreads == 1) {
+                        size_t offsets[RADIXSORT_NBUCKETS];
+                        size_t sum = 0;
+                        for(size_t b = 0; b < RADIXSORT_NBUCKETS; ++b) {
+                            offsets[b] = sum;
+                            sum += c[b];
+                        }
+                        scatter(src, dst, 0, n, keys, key, shift, offsets);
+                    } else {
+                        //Each thread counts the digits in its chunk, then
+                        //it copies the rows in its own range of each bucket
+                        const size_t chunk = (n + nthreads - 1) / nthreads;
+                        std::fill(threadCounts.begin(), threadCounts.end(), 0);
+                        ParallelTasks::parallel_for(0, nthreads, 1,
+                                [&](const ParallelRange &r) {
+                            for(size_t t = r.begin(); t < r.end(); ++t) {
+                                size_t *tc = threadCounts.data() +
+                                    t * RADIXSORT_NBUCKETS;
+                                const size_t e = std::min(n, (t + 1) * chunk);
+                                for(size_t i = t * chunk; i < e; ++i) {
+                                    tc[(keys.get(src[i], key) >> shift) & 0xFF]++;
+                                }
+                            }
+                        });
+                        size_t sum = 0;
+                        for(size_t b = 0; b < RADIXSORT_NBUCKETS; ++b) {
+                            for(size_t t = 0; t < nthreads; ++t) {
+                                auto &tc = threadCounts[t * RADIXSORT_NBUCKETS
+                                    + b];
+                                auto count = tc;
+                                tc = sum;
+                                sum += count;
+                            }
+                        }
+                        ParallelTasks::parallel_for(0, nthreads, 1,
+                                [&](const ParallelRange &r) {
+                            for(size_t t = r.begin(); t < r.end(); ++t) {
+                                scatter(src, dst, t * chunk,
+                                        std::min(n, (t + 1) * chunk),
+                                        keys, key, shift,
+                                        threadCounts.data() +
+                                        t * RADIXSORT_NBUCKETS);
+                            }
+                        });
+                    }
+                    std::swap(src, dst);
+                }
+            }
+            if (src != v.data()) {
+                v.swap(tmp);
+            }
+        }
+
+        template<typename K>
+        static void sort(std::vector<K> &v) {
+            sort(v, RadixKeys<K>());
+        }
+};
+
+#endif
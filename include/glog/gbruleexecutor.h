@@ -30,8 +30,25 @@ typedef enum {DUR_FIRST, DUR_MERGE, DUR_JOIN, DUR_HEAD //,DUR_PREP2TO1
 } DurationType;
 typedef enum { N_BDY_ATOMS } StatType;
 
+//Counters of the last execution of a rule, used for profiling
+struct GBRuleExecutionStats {
+    size_t nInput; //Rows in the body nodes
+    size_t nIntermediate; //Rows from which the head is computed
+    size_t nMergeJoins;
+    size_t nHashJoins;
+    size_t nSorts;
+    size_t nCacheHits; //Sorted segments taken from the SegmentCache
+    std::chrono::duration<double, std::milli> durationRestrictedCheck;
+
+    GBRuleExecutionStats() : nInput(0), nIntermediate(0), nMergeJoins(0),
+    nHashJoins(0), nSorts(0), nCacheHits(0), durationRestrictedCheck(0) {}
+};
+
 
 #define N_ATTEMPTS_ENABLE_DUPL_DEL 5
+//Costs (per row) used to choose between a hash join and a merge join
+#define HASHJOIN_BUILD_COST 4
+#define HASHJOIN_PROBE_COST 2
 class DuplManager {
     private:
         bool enabled;
@@ -46,6 +63,9 @@ class DuplManager {
 
 class GBRuleExecutor {
     private:
+        //The micro-benchmarks (make vlog-bench) call the joins directly
+        friend class GBBenchmarks;
+
         const bool retainUnique;
         const bool loadAllEDB;
         std::chrono::duration<double, std::milli> durationFirst;
@@ -57,7 +77,10 @@ class GBRuleExecutor {
         std::chrono::duration<double, std::milli> lastDurationMergeSort;
         std::chrono::duration<double, std::milli> lastDurationJoin;
         std::chrono::duration<double, std::milli> lastDurationCreateHead;
+        size_t nMergeJoins;
+        size_t nHashJoins;
         std::string bdyAtoms;
+        GBRuleExecutionStats lastStats;
 
         Program *program; //used only for debugging purposes
         EDBLayer &layer;
@@ -148,6 +171,23 @@ class GBRuleExecutor {
                 std::vector<int> &copyVarPosRight,
                 std::unique_ptr<GBSegmentInserter> &output);
 
+        bool shouldUseHashJoin(
+                const bool enableCacheLeft,
+                const bool enableCacheRight,
+                std::shared_ptr<const TGSegment> inputLeft,
+                const std::vector<size_t> &nodesLeft,
+                std::shared_ptr<const TGSegment> inputRight,
+                const std::vector<size_t> &nodesRight,
+                std::vector<std::pair<int, int>> &joinVarPos);
+
+        void hashjoin(
+                std::shared_ptr<const TGSegment> inputLeft,
+                std::shared_ptr<const TGSegment> inputRight,
+                std::vector<std::pair<int, int>> &joinVarPos,
+                std::vector<int> &copyVarPosLeft,
+                std::vector<int> &copyVarPosRight,
+                std::unique_ptr<GBSegmentInserter> &output);
+
         void nestedloopjoin(
                 const bool enableCacheLeft,
                 const bool enableCacheRight,
@@ -217,6 +257,8 @@ class GBRuleExecutor {
             lastDurationJoin(0),
             lastDurationCreateHead(0),
             lastDurationFirst(0),
+            nMergeJoins(0),
+            nHashJoins(0),
             bdyAtoms(""),
             program(program),
             provenanceType(g.getProvenanceType()),
@@ -226,10 +268,25 @@ class GBRuleExecutor {
 
         std::vector<GBRuleOutput> executeRule(Rule &rule, GBRuleInput &node);
 
+        //Create an executor with the same configuration. Used to execute
+        //rules in parallel, since the executor keeps some state (e.g.,
+        //statistics and the EDB tables) which cannot be shared among threads
+        std::unique_ptr<GBRuleExecutor> createWorker() const {
+            return std::unique_ptr<GBRuleExecutor>(new GBRuleExecutor(g,
+                        layer, program, retainUnique, loadAllEDB));
+        }
+
+        //Add the statistics collected by a worker to the ones of this executor
+        void addStats(const GBRuleExecutor &worker);
+
         std::chrono::duration<double, std::milli> getDuration(DurationType typ);
 
         std::string getStat(StatType typ);
 
+        const GBRuleExecutionStats &getLastStats() const {
+            return lastStats;
+        }
+
         void printStats();
 };
 
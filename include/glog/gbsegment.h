@@ -6,6 +6,7 @@
 #include <vlog/segment.h>
 
 #include <glog/gbsegmentitr.h>
+#include <glog/gbradixsort.h>
 
 #include <vector>
 #include <map>
@@ -178,6 +179,15 @@ class TGSegment {
             return 0;
         }
 
+        //Approximate number of bytes used by the segment
+        virtual size_t getSizeInBytes() const {
+            size_t ncols = getNColumns() + getNOffsetColumns();
+            if (getProvenanceType() == SEG_DIFFNODES) {
+                ncols++;
+            }
+            return getNRows() * ncols * sizeof(Term_t);
+        }
+
         virtual  size_t getNProofsAtRow(size_t rowIdx) const {
             return 1;
         }
@@ -279,7 +289,7 @@ class TGSegmentImpl : public TGSegment {
             const auto nrows = nodes.size() / ncols;
             idxs.resize(nrows);
             for(size_t i = 0; i < nrows; ++i) idxs[i] = i;
-            std::stable_sort(idxs.begin(), idxs.end(), ProvSorter(nodes.data(), ncols));
+            RadixSort::sort(idxs, RadixKeysRows(nodes.data(), ncols));
             return shuffle(idxs);
         }
 
@@ -353,7 +363,7 @@ class TGSegmentImpl : public TGSegment {
 
         std::shared_ptr<const TGSegment> sort() const {
             auto t = std::vector<K>(*TGSegmentImpl<S,K,I,CP>::tuples.get());
-            std::sort(t.begin(), t.end());
+            RadixSort::sort(t);
             return std::shared_ptr<const TGSegment>(new S(t, TGSegmentImpl<S,K,I,CP>::getNodeId(), true, 0));
         }
 
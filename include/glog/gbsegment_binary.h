@@ -31,10 +31,10 @@ class BinaryTGSegmentImpl : public TGSegmentImpl<S,K,I,CP> {
             uint8_t field = (fields.size() == 0 || fields[0] == 0) ? 0 : 1;
             std::vector<K> sortedTuples(*TGSegmentImpl<S,K,I,CP>::tuples.get());
             if (field == 0) {
-                std::sort(sortedTuples.begin(), sortedTuples.end());
+                RadixSort::sort(sortedTuples);
             } else {
                 assert(field == 1);
-                std::sort(sortedTuples.begin(), sortedTuples.end(), invertedSorter<K>);
+                RadixSort::sort(sortedTuples, RadixKeysInverted<K>());
             }
             return std::shared_ptr<TGSegment>(
                     new S(sortedTuples, TGSegmentImpl<S,K,I,CP>::getNodeId(),
@@ -244,11 +244,6 @@ class BinaryWithProvTGSegment : public BinaryTGSegmentImpl<
                 const BinWithProv &b) {
             return a.first == b.first && a.second == b.second;
         }
-        static bool sortNode(const BinWithProv &a,
-                const BinWithProv &b) {
-            return a.node < b.node || (a.node == b.node && a.first < b.first)
-                || (a.node == b.node && a.first == b.first && a.second < b.second);
-        }
 
     public:
         BinaryWithProvTGSegment(std::vector<BinWithProv> &tuples,
@@ -349,7 +344,7 @@ class BinaryWithProvTGSegment : public BinaryTGSegmentImpl<
                     *TGSegmentImpl<BinaryWithProvTGSegment,
                     BinWithProv, BinaryWithProvTGSegmentItr,
                     SEG_DIFFNODES>::tuples.get());
-            std::sort(t.begin(), t.end(), sortNode);
+            RadixSort::sort(t, RadixKeysNode<BinWithProv>());
             return std::shared_ptr<const TGSegment>(new BinaryWithProvTGSegment(t,
                         TGSegmentImpl<
                         BinaryWithProvTGSegment,
@@ -690,12 +685,6 @@ class BinaryWithFullProvTGSegment : public BinaryTGSegmentImpl<
                 const BinWithFullProv &b) {
             return a.first == b.first && a.second == b.second;
         }
-        static bool sortNode(const BinWithFullProv &a,
-                const BinWithFullProv &b) {
-            return a.node < b.node || (a.node == b.node &&
-                    a.first < b.first) || (a.node == b.node &&
-                        a.first == b.first && a.second < b.second);
-        }
 
     public:
         BinaryWithFullProvTGSegment(std::vector<BinWithFullProv> &tuples,
@@ -809,7 +798,7 @@ class BinaryWithFullProvTGSegment : public BinaryTGSegmentImpl<
                     *TGSegmentImpl<BinaryWithFullProvTGSegment,
                     BinWithFullProv, BinaryWithFullProvTGSegmentItr,
                     SEG_FULLPROV>::tuples.get());
-            std::sort(t.begin(), t.end(), sortNode);
+            RadixSort::sort(t, RadixKeysNode<BinWithFullProv>());
             return std::shared_ptr<const TGSegment>(
                     new BinaryWithFullProvTGSegment(t,
                         TGSegmentImpl<
@@ -22,7 +22,7 @@ class UnaryTGSegmentImpl : public TGSegmentImpl<S,K,I,CP> {
         std::shared_ptr<TGSegment> sortBy(std::vector<uint8_t> &fields) const {
             assert(fields.size() == 0 || (fields.size() == 1 && fields[0] == 0));
             std::vector<K> sortedTuples(*TGSegmentImpl<S,K,I,CP>::tuples.get());
-            std::sort(sortedTuples.begin(), sortedTuples.end());
+            RadixSort::sort(sortedTuples);
             return std::shared_ptr<TGSegment>(
                     new S(sortedTuples, TGSegmentImpl<S,K,I,CP>::getNodeId(), true, 0));
         }
@@ -153,11 +153,6 @@ class UnaryWithProvTGSegment : public UnaryTGSegmentImpl<UnaryWithProvTGSegment,
                 const std::pair<Term_t, Term_t> &b) {
             return a.first == b.first;
         }
-        static bool sortSecondTerm(const std::pair<Term_t,Term_t> &a,
-                const std::pair<Term_t, Term_t> &b) {
-            return a.second < b.second || (a.second == b.second &&
-                    a.first < b.first);
-        }
     public:
         UnaryWithProvTGSegment(std::vector<std::pair<Term_t,Term_t>> &tuples,
                 const size_t nodeId, bool isSorted, uint8_t sortedField) :
@@ -212,7 +207,7 @@ class UnaryWithProvTGSegment : public UnaryTGSegmentImpl<UnaryWithProvTGSegment,
                     *TGSegmentImpl<UnaryWithProvTGSegment,
                     std::pair<Term_t,Term_t>,
                     UnaryWithProvTGSegmentItr, SEG_DIFFNODES>::tuples.get());
-            std::sort(t.begin(), t.end(), sortSecondTerm);
+            RadixSort::sort(t, RadixKeysInverted<std::pair<Term_t,Term_t>>());
             return std::shared_ptr<const TGSegment>(
                     new UnaryWithProvTGSegment(
                         t,
@@ -429,11 +424,6 @@ class UnaryWithFullProvTGSegment : public UnaryTGSegmentImpl<UnaryWithFullProvTG
                 const UnWithFullProv &b) {
             return a.first == b.first;
         }
-        static bool sortByNode(const UnWithFullProv &a,
-                const UnWithFullProv &b) {
-            return a.node < b.node || (a.node == b.node &&
-                    a.first < b.first);
-        }
 
     public:
         UnaryWithFullProvTGSegment(std::vector<UnWithFullProv> &tuples,
@@ -490,7 +480,7 @@ class UnaryWithFullProvTGSegment : public UnaryTGSegmentImpl<UnaryWithFullProvTG
                     *TGSegmentImpl<UnaryWithFullProvTGSegment,
                     UnWithFullProv,
                     UnaryWithFullProvTGSegmentItr, SEG_FULLPROV>::tuples.get());
-            std::sort(t.begin(), t.end(), sortByNode);
+            RadixSort::sort(t, RadixKeysNode<UnWithFullProv>());
             return std::shared_ptr<const TGSegment>(
                     new UnaryWithFullProvTGSegment(
                         t,
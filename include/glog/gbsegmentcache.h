@@ -2,135 +2,128 @@
 #define _TGSEGMENTCACHE_H
 
 #include <vlog/concepts.h>
+#include <vlog/rowhash.h>
 
 #include <glog/gbsegmentitr.h>
 
-#include <map>
+#include <unordered_map>
+#include <list>
 #include <vector>
+#include <mutex>
+#include <future>
+
+//Default memory budget of the cache (in MB). 0 means a quarter of the RAM
+#define SEGMENTCACHE_DEFAULT_SIZE 0
+//Number of least recently used entries considered for eviction
+#define SEGMENTCACHE_EVICTION_WINDOW 8
 
 class CacheEntry {
     private:
         std::vector<size_t> nodes;
+        std::vector<uint8_t> fields;
 
     public:
-        CacheEntry(const std::vector<size_t> &n) : nodes(n) {}
-
-        bool operator <(const CacheEntry& rhs) const {
-            if (nodes.size() != rhs.nodes.size()) {
-                return nodes.size() < rhs.nodes.size();
-            } else {
-                for(int i = 0; i < nodes.size(); ++i) {
-                    if (nodes[i] != rhs.nodes[i]) {
-                        return nodes[i] < rhs.nodes[i];
-                    }
-                }
-            }
-            return false;
+        CacheEntry(const std::vector<size_t> &n,
+                const std::vector<uint8_t> &f) : nodes(n), fields(f) {}
+
+        bool operator ==(const CacheEntry& rhs) const {
+            return nodes == rhs.nodes && fields == rhs.fields;
+        }
+
+        size_t hash() const {
+            return combineHash64(hashRow(fields.data(), fields.size()),
+                    hashRow(nodes.data(), nodes.size()));
+        }
+
+        size_t getNNodes() const {
+            return nodes.size();
         }
 };
 
+struct CacheEntryHasher {
+    size_t operator()(const CacheEntry &e) const {
+        return e.hash();
+    }
+};
+
 class TGSegment;
 class SegmentCache {
     private:
+        struct CacheValue {
+            std::shared_ptr<const TGSegment> seg;
+            size_t size; //estimated n. bytes
+            double cost; //estimated cost of recomputing the entry
+            size_t hits;
+            size_t misses;
+            std::list<CacheEntry>::iterator lruItr;
+        };
+
         static SegmentCache instance;
 
-        std::map<CacheEntry, std::shared_ptr<const TGSegment>> cacheVar0;
-        std::map<CacheEntry, std::shared_ptr<const TGSegment>> cacheVar1;
-        std::map<CacheEntry, std::shared_ptr<const TGSegment>> cacheVar2;
-        std::map<CacheEntry, std::shared_ptr<const TGSegment>> cacheVar3;
-        std::map<CacheEntry, std::shared_ptr<const TGSegment>> cacheVar4;
-        std::map<CacheEntry, std::shared_ptr<const TGSegment>> cacheVar5;
-        std::map<CacheEntry, std::shared_ptr<const TGSegment>> cacheVar6;
+        std::unordered_map<CacheEntry, CacheValue, CacheEntryHasher> entries;
+        std::list<CacheEntry> lru; //the front is the most recently used
+        //Segments that are being sorted by some thread
+        std::unordered_map<CacheEntry,
+            std::shared_future<std::shared_ptr<const TGSegment>>,
+            CacheEntryHasher> inFlight;
+        size_t maxSize;
+        size_t currentSize;
+
+        //Statistics
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+
+        //The cache can be accessed by multiple threads executing rules
+        mutable std::mutex mutex;
+
+        SegmentCache();
+
+        void evict(size_t sizeToAdd);
+
+        //Must be called while holding the mutex
+        std::shared_ptr<const TGSegment> lookup(const CacheEntry &k);
 
     public:
         static SegmentCache &getInstance() {
             return instance;
         }
 
-        bool contains(const std::vector<size_t> &key, const std::vector<uint8_t> &fields) const {
-            if (fields.size() != 1)
-                return false;
-
-            auto field = fields[0];
-            CacheEntry k(key);
-            if (field == 0)
-                return cacheVar0.count(k);
-            else if (field == 1)
-                return cacheVar1.count(k);
-            else if (field == 2)
-                return cacheVar2.count(k);
-            else if (field == 3)
-                return cacheVar3.count(k);
-            else if (field == 4)
-                return cacheVar4.count(k);
-            else if (field == 5)
-                return cacheVar5.count(k);
-            else if (field == 6)
-                return cacheVar6.count(k);
-            else {
-                LOG(INFOL) << "Not supported";
-                throw 10;
-            }
-        }
+        static size_t estimateSize(const TGSegment &seg);
 
-        void insert(const std::vector<size_t> &key, const std::vector<uint8_t> &fields,
-                std::shared_ptr<const TGSegment> value) {
-            assert(fields.size() == 1);
-            auto field = fields[0];
-            CacheEntry k(key);
-            if (field == 0) {
-                cacheVar0[k] = value;
-            } else if (field == 1) {
-                cacheVar1[k] = value;
-            } else if (field == 2) {
-                cacheVar2[k] = value;
-            } else if (field == 3) {
-                cacheVar3[k] = value;
-            } else if (field == 4) {
-                cacheVar4[k] = value;
-            } else if (field == 5) {
-                cacheVar5[k] = value;
-            } else if (field == 6) {
-                cacheVar6[k] = value;
-            } else {
-                throw 10;
-            }
-        }
+        //Set the memory budget (in bytes)
+        void setMaxSize(size_t bytes);
+
+        size_t getMaxSize() const;
+
+        //Returns the estimated number of bytes used by the cached segments
+        size_t getSize() const;
+
+        size_t getNEntries() const;
+
+        bool contains(const std::vector<size_t> &key,
+                const std::vector<uint8_t> &fields) const;
 
-        const std::shared_ptr<const TGSegment> get(
+        void insert(const std::vector<size_t> &key,
+                const std::vector<uint8_t> &fields,
+                std::shared_ptr<const TGSegment> value);
+
+        //Returns NULL if the segment is not in the cache
+        std::shared_ptr<const TGSegment> get(
                 const std::vector<size_t> &key,
-                const std::vector<uint8_t> &fields) {
-            assert(fields.size() == 1);
-            auto field = fields[0];
-            CacheEntry k(key);
-            if (field == 0) {
-                return cacheVar0[k];
-            } else if (field == 1) {
-                return cacheVar1[k];
-            } else if (field == 2) {
-                return cacheVar2[k];
-            } else if (field == 3) {
-                return cacheVar3[k];
-            } else if (field == 4) {
-                return cacheVar4[k];
-            } else if (field == 5) {
-                return cacheVar5[k];
-            } else if (field == 6) {
-                return cacheVar6[k];
-            } else {
-                throw 10;
-            }
-        }
+                const std::vector<uint8_t> &fields);
 
-        void clear() {
-            cacheVar0.clear();
-            cacheVar1.clear();
-            cacheVar2.clear();
-            cacheVar3.clear();
-            cacheVar4.clear();
-            cacheVar5.clear();
-            cacheVar6.clear();
-        }
+        //Returns a segment sorted by fields, either from the cache or by
+        //sorting (and caching) input. Concurrent calls with the same key
+        //sort input only once
+        std::shared_ptr<const TGSegment> getSorted(
+                const std::vector<size_t> &key,
+                std::vector<uint8_t> &fields,
+                std::shared_ptr<const TGSegment> input);
+
+        void printStats() const;
+
+        void clear();
 };
 
 #endif
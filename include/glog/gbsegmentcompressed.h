@@ -0,0 +1,294 @@
+#ifndef _GB_SEGMENTCOMPRESSED_H
+#define _GB_SEGMENTCOMPRESSED_H
+
+#include <glog/gbsegment.h>
+
+#include <mutex>
+
+//Number of values in each block of a compressed column
+#define COMPRSEGMENT_BLOCK_SIZE 128
+//Segments with fewer rows are not compressed
+#define COMPRSEGMENT_MIN_ROWS 1024
+
+//A column split in blocks of COMPRSEGMENT_BLOCK_SIZE values. The values of
+//a block are bit-packed either as the deltas between consecutive values
+//(if the block is sorted) or as the differences w.r.t. the minimum value in
+//the block (frame of reference), whichever needs fewer bits.
+class TGPackedColumn {
+    private:
+        struct Block {
+            Term_t base;
+            uint64_t start; //First word of the block in words
+            uint8_t bits;
+            bool delta;
+        };
+
+        std::vector<Block> blocks;
+        std::vector<uint64_t> words;
+        size_t nvalues;
+
+        static uint8_t getNBits(uint64_t v) {
+            return v == 0 ? 0 : 64 - __builtin_clzll(v);
+        }
+
+        Term_t unpack(const Block &b, size_t idx) const {
+            if (b.bits == 0)
+                return 0;
+            const uint64_t bitpos = idx * b.bits;
+            const uint64_t w = b.start + bitpos / 64;
+            const uint64_t off = bitpos % 64;
+            uint64_t v = words[w] >> off;
+            if (off + b.bits > 64)
+                v |= words[w + 1] << (64 - off);
+            return b.bits == 64 ? v : v & ((1ul << b.bits) - 1);
+        }
+
+        void pack(const std::vector<uint64_t> &values, uint8_t bits);
+
+    public:
+        TGPackedColumn() : nvalues(0) {}
+
+        TGPackedColumn(const std::vector<Term_t> &values);
+
+        size_t getNValues() const {
+            return nvalues;
+        }
+
+        //Decode a block into out, which must have space for
+        //COMPRSEGMENT_BLOCK_SIZE values. Returns the number of values
+        size_t decode(size_t blockIdx, Term_t *out) const;
+
+        Term_t get(size_t idx) const;
+
+        size_t getSizeInBytes() const {
+            return blocks.size() * sizeof(Block) +
+                words.size() * sizeof(uint64_t);
+        }
+};
+
+//Read-only sorted segment that stores the columns in compressed blocks and
+//the nodes (if any) with run-length encoding. Iterators decompress one block
+//at the time, so that merge joins can scan the segment directly. All other
+//operations are executed on a decompressed copy, which is kept until
+//releaseDecompressed() is called.
+class TGSegmentCompressed : public TGSegment {
+    private:
+        const size_t nodeId;
+        const size_t nrows;
+        const size_t ncols;
+        const size_t nprovcols;
+        const size_t nOffsetColumns;
+        const SegProvenanceType provenanceType;
+        //The data columns followed by the offset columns
+        std::vector<TGPackedColumn> columns;
+        //(first row, node) of each run of rows with the same node
+        std::vector<std::pair<size_t, size_t>> nodeRuns;
+
+        mutable std::mutex mtxDecompressed;
+        mutable std::shared_ptr<const TGSegment> decompressed;
+
+        TGSegmentCompressed(const TGSegment &seg);
+
+    public:
+        //Returns a compressed copy of seg, or seg itself if it cannot be
+        //compressed or if compression does not save space
+        static std::shared_ptr<const TGSegment> compress(
+                std::shared_ptr<const TGSegment> seg);
+
+        //Returns the decompressed copy, creating it if needed
+        std::shared_ptr<const TGSegment> decompress() const;
+
+        void releaseDecompressed() const;
+
+        bool isDecompressed() const;
+
+        size_t getSizeInBytes() const;
+
+        const TGPackedColumn &getColumn(size_t idx) const {
+            return columns[idx];
+        }
+
+        size_t getNodeAtRow(size_t rowIdx, size_t &runIdx) const;
+
+        std::string getName() const {
+            return "TGSegmentCompressed";
+        }
+
+        size_t getNRows() const {
+            return nrows;
+        }
+
+        size_t getNColumns() const {
+            return ncols;
+        }
+
+        bool isEmpty() const {
+            return nrows == 0;
+        }
+
+        bool isSorted() const {
+            return true;
+        }
+
+        bool isSortedBy(std::vector<uint8_t> &fields) const;
+
+        SegProvenanceType getProvenanceType() const {
+            return provenanceType;
+        }
+
+        size_t getNodeId() const {
+            return nodeId;
+        }
+
+        size_t getNOffsetColumns() const {
+            return nOffsetColumns;
+        }
+
+        bool isNodeConstant() const {
+            return nodeRuns.size() <= 1;
+        }
+
+        std::unique_ptr<TGSegmentItr> iterator(
+                std::shared_ptr<const TGSegment> selfref = NULL) const;
+
+        std::shared_ptr<const TGSegment> sort() const;
+
+        void argsort(std::vector<size_t> &idxs) const;
+
+        std::shared_ptr<TGSegment> sortBy(std::vector<uint8_t> &fields) const;
+
+        std::shared_ptr<const TGSegment> sortByProv(size_t ncols,
+                std::vector<size_t> &idxs,
+                std::vector<size_t> &nodes) const;
+
+        std::shared_ptr<const TGSegment> sortByProv() const;
+
+        std::shared_ptr<const TGSegment> unique() const;
+
+        void argunique(std::vector<size_t> &idxs) const;
+
+        void projectTo(const std::vector<int> &posFields,
+                std::vector<std::shared_ptr<Column>> &out) const;
+
+        size_t countHits(const std::vector<Term_t> &terms,
+                int column) const;
+
+        size_t countHits(const std::vector<
+                std::pair<Term_t,Term_t>> &terms,
+                int column1, int column2) const;
+
+        std::shared_ptr<TGSegment> slice(const size_t nodeId,
+                const size_t start,
+                const size_t end) const;
+
+        std::shared_ptr<const TGSegment> slice(const size_t start,
+                const size_t end) const;
+
+        std::vector<std::shared_ptr<const TGSegment>> sliceByNodes(
+                size_t startNodeIdx,
+                std::vector<size_t> &provNodes) const;
+
+        std::shared_ptr<const TGSegment> shuffle(
+                const std::vector<size_t> &idxs) const;
+
+        std::shared_ptr<TGSegment> swap() const;
+
+        void appendTo(uint8_t colPos, std::vector<Term_t> &out) const;
+
+        void appendTo(uint8_t colPos,
+                std::vector<std::pair<Term_t, Term_t>> &out) const;
+
+        void appendTo(uint8_t colPos,
+                std::vector<UnWithFullProv> &out) const;
+
+        void appendTo(uint8_t colPos1, uint8_t colPos2,
+                std::vector<std::pair<Term_t,Term_t>> &out) const;
+
+        void appendTo(uint8_t colPos1, uint8_t colPos2,
+                std::vector<BinWithProv> &out) const;
+
+        void appendTo(uint8_t colPos1, uint8_t colPos2,
+                std::vector<BinWithFullProv> &out) const;
+
+        void appendTo(const std::vector<int> &posFields,
+                std::vector<std::vector<Term_t>> &out,
+                bool withProv = false) const;
+
+        std::vector<Term_t> getRow(size_t rowIdx, bool addProv) const;
+
+        Term_t getOffsetAtRow(size_t rowIdx, size_t proofNr,
+                size_t offsetColumnIdx) const;
+
+        Term_t getValueAtRow(size_t rowIdx, size_t colIdx) const;
+};
+
+class TGSegmentCompressedItr : public TGSegmentItr {
+    private:
+        const TGSegmentCompressed &seg;
+        const std::shared_ptr<const TGSegment> selfref;
+        const size_t nrows;
+        const size_t ncols;
+
+        int64_t currentRow;
+        int64_t m_currentRow;
+        mutable size_t currentRun;
+
+        //Decoded block of each column (~0ul if none)
+        mutable std::vector<size_t> decodedBlocks;
+        mutable std::vector<Term_t> buffer;
+
+        Term_t getValue(size_t colIdx) const {
+            const size_t block = currentRow / COMPRSEGMENT_BLOCK_SIZE;
+            Term_t *b = buffer.data() + colIdx * COMPRSEGMENT_BLOCK_SIZE;
+            if (decodedBlocks[colIdx] != block) {
+                seg.getColumn(colIdx).decode(block, b);
+                decodedBlocks[colIdx] = block;
+            }
+            return b[currentRow % COMPRSEGMENT_BLOCK_SIZE];
+        }
+
+    public:
+        TGSegmentCompressedItr(const TGSegmentCompressed &seg,
+                std::shared_ptr<const TGSegment> selfref,
+                size_t ncolumns) :
+            seg(seg), selfref(selfref), nrows(seg.getNRows()),
+            ncols(seg.getNColumns()), currentRow(-1), m_currentRow(-1),
+            currentRun(0), decodedBlocks(ncolumns, ~0ul),
+            buffer(ncolumns * COMPRSEGMENT_BLOCK_SIZE) {
+            }
+
+        bool hasNext() {
+            return currentRow + 1 < (int64_t)nrows;
+        }
+
+        void next() {
+            currentRow++;
+        }
+
+        void mark() {
+            m_currentRow = currentRow;
+        }
+
+        void reset() {
+            currentRow = m_currentRow;
+        }
+
+        Term_t get(const int colIdx) {
+            return getValue(colIdx);
+        }
+
+        size_t getNodeId() const {
+            return seg.getNodeAtRow(currentRow, currentRun);
+        }
+
+        size_t getProvenanceOffset(size_t proofNr, int pos) const {
+            assert(proofNr == 0);
+            return getValue(ncols + pos);
+        }
+
+        int getNFields() const {
+            return ncols;
+        }
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <glog/gbsegment.h>
 #include <glog/gblegacysegment.h>
 #include <glog/hashset.h>
+#include <vlog/rowhash.h>
 
 #include <vlog/term.h>
 #include <vlog/column.h>
@@ -13,6 +14,8 @@
 #include <memory>
 
 #define THRESHOLD_CHECK_DUPLICATES 32*1000000
+//Number of rows on which the builtin functions are evaluated at once
+#define BUILTIN_BLOCK_SIZE 4096
 #include <google/dense_hash_set>
 
 typedef google::dense_hash_set<Term_t> GBSegmentInserterEntities;
@@ -20,6 +23,11 @@ typedef google::dense_hash_set<Term_t> GBSegmentInserterEntities;
 class GBSegmentInserter {
     private:
         std::vector<BuiltinFunction> fns;
+        //Rows that are not yet filtered by the builtin functions
+        const size_t rowSize;
+        std::vector<Term_t> pendingRows;
+        size_t nPendingRows;
+        std::vector<uint32_t> selection;
 
         bool shouldRemoveDuplicates;
         size_t checkDuplicatesAfter;
@@ -29,11 +37,15 @@ class GBSegmentInserter {
         virtual size_t removeDuplicates() = 0;
         size_t processedRecords;
 
+        void addIfNotDuplicate(Term_t *row);
+
     protected:
         virtual void addRow(Term_t *row) = 0;
 
     public:
-        GBSegmentInserter(bool shouldRemoveDuplicates) :
+        GBSegmentInserter(size_t rowSize, bool shouldRemoveDuplicates) :
+            rowSize(rowSize),
+            nPendingRows(0),
             shouldRemoveDuplicates(shouldRemoveDuplicates),
             checkDuplicatesAfter(THRESHOLD_CHECK_DUPLICATES),
             useDuplicateMap(false),
@@ -57,6 +69,10 @@ class GBSegmentInserter {
 
         virtual void add(Term_t *row);
 
+        //Filters the rows that are still pending. Must be called after the
+        //last row is added if there are builtin functions
+        void flush();
+
         virtual void swap(std::vector<Term_t> &t) {
             throw 10;
         }
@@ -96,7 +112,7 @@ class GBSegmentInserterImpl : public GBSegmentInserter {
     private:
         size_t removeDuplicates() {
             size_t oldSize = tuples.size();
-            std::sort(tuples.begin(), tuples.end());
+            RadixSort::sort(tuples);
             auto e = std::unique(tuples.begin(), tuples.end());
             tuples.erase(e, tuples.end());
             size_t newSize = tuples.size();
@@ -105,8 +121,9 @@ class GBSegmentInserterImpl : public GBSegmentInserter {
         }
 
     public:
-        GBSegmentInserterImpl(size_t card, bool shouldRemoveDuplicates) :
-            GBSegmentInserter(shouldRemoveDuplicates),
+        GBSegmentInserterImpl(size_t card, size_t rowSize,
+                bool shouldRemoveDuplicates) :
+            GBSegmentInserter(rowSize, shouldRemoveDuplicates),
             card(card) {
             }
 
@@ -150,7 +167,7 @@ class GBSegmentInserterUnary :
 
     public:
         GBSegmentInserterUnary(bool delDupl) :
-            GBSegmentInserterImpl(1, delDupl)
+            GBSegmentInserterImpl(1, 1, delDupl)
     {
         novelTuples.set_empty_key(~0ul);
     }
@@ -230,7 +247,7 @@ class GBSegmentInserterBinary : public GBSegmentInserterImpl<
         }
 
     public:
-        GBSegmentInserterBinary(bool delDupl) : GBSegmentInserterImpl(1, delDupl),
+        GBSegmentInserterBinary(bool delDupl) : GBSegmentInserterImpl(1, 2, delDupl),
         secondFieldConstant(true) {
             novelTuples.set_empty_key(std::make_pair(~0ul, ~0ul));
         }
@@ -299,6 +316,16 @@ struct BinWithDoubleProv {
     }
 };
 
+template<>
+struct RadixKeys<BinWithDoubleProv> {
+    size_t nkeys() const {
+        return 2;
+    }
+    Term_t get(const BinWithDoubleProv &r, const size_t i) const {
+        return i == 0 ? r.first : r.second;
+    }
+};
+
 class GBSegmentInserterBinaryWithDoubleProv : public GBSegmentInserterImpl<
                                               std::vector<BinWithDoubleProv>,
                                               std::pair<Term_t, Term_t>>
@@ -353,7 +380,7 @@ class GBSegmentInserterBinaryWithDoubleProv : public GBSegmentInserterImpl<
 
     public:
         GBSegmentInserterBinaryWithDoubleProv(bool delDupl) :
-            GBSegmentInserterImpl(2, delDupl),
+            GBSegmentInserterImpl(2, 4, delDupl),
             node1Constant(true),
             node2Constant(true) {
                 if (!delDupl) {
@@ -434,8 +461,7 @@ class GBSegmentInserterNAry : public GBSegmentInserter
         size_t addedRows;
         bool isFinal;
 
-        //std::unique_ptr<HashSet> s; //For general case
-        google::dense_hash_set<std::pair<Term_t,Term_t>, std::hash<std::pair<Term_t,Term_t>>> s_binary;
+        RowHashSet<Term_t> s;
 
         bool isInMap(Term_t *row);
         void populateMap();
@@ -452,16 +478,11 @@ class GBSegmentInserterNAry : public GBSegmentInserter
     public:
         GBSegmentInserterNAry(size_t card, size_t cardCheckDuplicates,
                 bool shouldRemoveDuplicates) :
-            GBSegmentInserter(shouldRemoveDuplicates),
+            GBSegmentInserter(card, shouldRemoveDuplicates),
             writers(card),
             card(card),
             cardCheckDuplicates(cardCheckDuplicates),
-            addedRows(0), isFinal(false) {
-                s_binary.set_empty_key(std::make_pair(~0ul, ~0ul));
-
-                //s(cardCheckDuplicates,
-                //    THRESHOLD_CHECK_DUPLICATES / 10)
-                //LOG(INFOL) << "HashSet " << THRESHOLD_CHECK_DUPLICATES / 10;
+            addedRows(0), isFinal(false), s(cardCheckDuplicates) {
             }
 
         bool isEmpty() const  {
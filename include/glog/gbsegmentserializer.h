@@ -0,0 +1,38 @@
+#ifndef _GB_SEGMENTSERIALIZER_H
+#define _GB_SEGMENTSERIALIZER_H
+
+#include <glog/gbsegment.h>
+
+#include <iostream>
+
+//Stores segments in a binary format that contains only 64-bit words. Every
+//segment starts with a header (n. rows, n. columns, n. provenance columns,
+//provenance type, flags) followed by the columns, one after the other. The
+//first provenance column contains the nodes, the others the offsets.
+class GBSegmentSerializer {
+    public:
+        static void write(std::ostream &out,
+                std::shared_ptr<const TGSegment> seg);
+
+        static std::shared_ptr<const TGSegment> read(std::istream &in,
+                size_t nodeId);
+
+        //N. columns used to store the provenance of the rows
+        static size_t getNProvColumns(const TGSegment &seg);
+
+        static void writeWord(std::ostream &out, uint64_t v) {
+            out.write((const char*)&v, sizeof(uint64_t));
+        }
+
+        static uint64_t readWord(std::istream &in) {
+            uint64_t v;
+            in.read((char*)&v, sizeof(uint64_t));
+            if (!in) {
+                LOG(ERRORL) << "Unexpected end of file";
+                throw 10;
+            }
+            return v;
+        }
+};
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef _GB_SEGMENTSPILLED_H
+#define _GB_SEGMENTSPILLED_H
+
+#include <glog/gbsegment.h>
+
+#include <mutex>
+#include <atomic>
+#include <fstream>
+
+//Nodes with fewer rows are not spilled
+#define SPILLSEGMENT_MIN_ROWS 1024
+//By default, nodes are spilled after they are not used for so many steps
+#define SPILLSEGMENT_DEFAULT_COLDSTEPS 3
+
+//File where the segments of the cold nodes are written (see
+//GBSegmentSerializer). Segments are read back from a memory mapping of the
+//file, which is updated with map() after the segments are appended. The
+//file is removed when the object is destroyed.
+class GBSpillFile {
+    private:
+        const std::string path;
+        std::ofstream out;
+        size_t fileSize;
+        int fd;
+        char *mapped;
+        size_t mappedSize;
+
+        void unmap();
+
+    public:
+        GBSpillFile(const std::string &path);
+
+        //Returns the offset of the segment in the file
+        size_t write(std::shared_ptr<const TGSegment> seg);
+
+        //Must be called before reading the segments that were just written.
+        //It is not safe to call it while other threads read segments
+        void map();
+
+        std::shared_ptr<const TGSegment> read(size_t offset,
+                size_t nodeId) const;
+
+        size_t getSize() const {
+            return fileSize;
+        }
+
+        ~GBSpillFile();
+};
+
+//Placeholder for a segment stored in a spill file. The segment is loaded
+//when it is accessed and kept in memory until the graph releases it.
+class TGSegmentSpilled : public TGSegment {
+    private:
+        const std::shared_ptr<GBSpillFile> file;
+        const size_t offset;
+        const size_t nodeId;
+        const size_t nrows;
+        const size_t ncols;
+        const size_t nOffsetColumns;
+        const SegProvenanceType provenanceType;
+        const bool f_isSorted;
+        const bool f_isNodeConstant;
+
+        mutable std::mutex mutex;
+        mutable std::shared_ptr<const TGSegment> loaded;
+        mutable std::atomic<size_t> naccesses;
+        //Used by the graph to decide when the segment is cold
+        size_t lastNAccesses;
+        size_t lastAccessStep;
+
+        std::shared_ptr<const TGSegment> load() const;
+
+    public:
+        TGSegmentSpilled(std::shared_ptr<GBSpillFile> file,
+                std::shared_ptr<const TGSegment> seg,
+                size_t step);
+
+        bool isLoaded() const;
+
+        //Remove the copy in memory. Other segments that still use it are
+        //not affected
+        void release();
+
+        //True if the segment was not accessed in the last coldSteps steps
+        bool isCold(size_t step, size_t coldSteps);
+
+        std::string getName() const {
+            return "TGSegmentSpilled";
+        }
+
+        size_t getNRows() const {
+            return nrows;
+        }
+
+        size_t getNColumns() const {
+            return ncols;
+        }
+
+        bool isEmpty() const {
+            return nrows == 0;
+        }
+
+        bool isSorted() const {
+            return f_isSorted;
+        }
+
+        SegProvenanceType getProvenanceType() const {
+            return provenanceType;
+        }
+
+        size_t getNodeId() const {
+            return nodeId;
+        }
+
+        size_t getNOffsetColumns() const {
+            return nOffsetColumns;
+        }
+
+        bool isNodeConstant() const {
+            return f_isNodeConstant;
+        }
+
+        size_t getSizeInBytes() const;
+
+        std::unique_ptr<TGSegmentItr> iterator(
+                std::shared_ptr<const TGSegment> selfref = NULL) const;
+
+        bool isSortedBy(std::vector<uint8_t> &fields) const;
+
+        std::shared_ptr<const TGSegment> sort() const;
+
+        void argsort(std::vector<size_t> &idxs) const;
+
+        std::shared_ptr<TGSegment> sortBy(std::vector<uint8_t> &fields) const;
+
+        std::shared_ptr<const TGSegment> sortByProv(size_t ncols,
+                std::vector<size_t> &idxs,
+                std::vector<size_t> &nodes) const;
+
+        std::shared_ptr<const TGSegment> sortByProv() const;
+
+        std::shared_ptr<const TGSegment> unique() const;
+
+        void argunique(std::vector<size_t> &idxs) const;
+
+        void projectTo(const std::vector<int> &posFields,
+                std::vector<std::shared_ptr<Column>> &out) const;
+
+        size_t countHits(const std::vector<Term_t> &terms,
+                int column) const;
+
+        size_t countHits(const std::vector<
+                std::pair<Term_t,Term_t>> &terms,
+                int column1, int column2) const;
+
+        std::shared_ptr<TGSegment> slice(const size_t nodeId,
+                const size_t start,
+                const size_t end) const;
+
+        std::shared_ptr<const TGSegment> slice(const size_t start,
+                const size_t end) const;
+
+        std::vector<std::shared_ptr<const TGSegment>> sliceByNodes(
+                size_t startNodeIdx,
+                std::vector<size_t> &provNodes) const;
+
+        std::shared_ptr<const TGSegment> shuffle(
+                const std::vector<size_t> &idxs) const;
+
+        std::shared_ptr<TGSegment> swap() const;
+
+        void appendTo(uint8_t colPos, std::vector<Term_t> &out) const;
+
+        void appendTo(uint8_t colPos,
+                std::vector<std::pair<Term_t, Term_t>> &out) const;
+
+        void appendTo(uint8_t colPos,
+                std::vector<UnWithFullProv> &out) const;
+
+        void appendTo(uint8_t colPos1, uint8_t colPos2,
+                std::vector<std::pair<Term_t,Term_t>> &out) const;
+
+        void appendTo(uint8_t colPos1, uint8_t colPos2,
+                std::vector<BinWithProv> &out) const;
+
+        void appendTo(uint8_t colPos1, uint8_t colPos2,
+                std::vector<BinWithFullProv> &out) const;
+
+        void appendTo(const std::vector<int> &posFields,
+                std::vector<std::vector<Term_t>> &out,
+                bool withProv = false) const;
+
+        std::vector<Term_t> getRow(size_t rowIdx, bool addProv) const;
+
+        Term_t getOffsetAtRow(size_t rowIdx, size_t proofNr,
+                size_t offsetColumnIdx) const;
+
+        Term_t getValueAtRow(size_t rowIdx, size_t colIdx) const;
+};
+
+#endif
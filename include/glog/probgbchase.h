@@ -18,7 +18,9 @@ class ProbGBChase : public GBChase
                 const size_t step,
                 std::vector<GBRuleInput> &newnodes);
 
-        bool executeRule(GBRuleInput &node, bool cleanDuplicates = true);
+        bool commitRuleExecution(GBRuleInput &node,
+                GBRuleExecution &execution,
+                bool cleanDuplicates = true);
 
     public:
         ProbGBChase(EDBLayer &layer, Program &program,
@@ -2,6 +2,7 @@
 #define BINDINGS_TABLE_H
 
 #include <vlog/concepts.h>
+#include <vlog/rowhash.h>
 #include <trident/model/table.h>
 
 #include <unordered_set>
@@ -18,73 +19,11 @@ struct BindingsRow {
     bool operator==(const BindingsRow &other) const;
 };
 
-struct hash_BindingsRow {
-    size_t operator()(const BindingsRow &x) const {
-        size_t hash = 0;
-        for (int i = 0; i < x.size; ++i) {
-            hash = (hash + (324723947 + x.row[i])) ^93485734985;
-        }
-        return hash;
-     }
-};
-
-class RawBindings {
-    private:
-        const uint8_t sizeArray;
-        const size_t sizeFrag;
-        std::vector<Term_t*> arrays;
-        int arraysIdx;
-        Term_t *array;
-        size_t currentOffset;
-    public:
-        RawBindings(uint8_t sizeArray) : sizeArray(sizeArray), sizeFrag(sizeArray * 1000) {
-            array = new Term_t[sizeFrag];
-            arrays.push_back(array);
-            currentOffset = 0;
-            arraysIdx = 0;
-        }
-
-        Term_t *newRow() {
-            if (currentOffset + sizeArray > sizeFrag) {
-                arraysIdx++;
-                Term_t *newArray = NULL;
-                if (arraysIdx == arrays.size()) {
-                    newArray = new Term_t[sizeFrag];
-                    arrays.push_back(newArray);
-                } else {
-                    newArray = arrays[arraysIdx];
-                }
-                currentOffset = 0;
-                array = newArray;
-            }
-            currentOffset += sizeArray;
-            return array + currentOffset - sizeArray;
-        }
-
-        Term_t *getOffset(size_t idx) {
-            int seg = idx / sizeFrag;
-            int mod = idx % sizeFrag;
-            return arrays[seg] + mod;
-        }
-
-        void clear() {
-            currentOffset = 0;
-            arraysIdx = 0;
-            array = arrays[0];
-        }
-
-        ~RawBindings() {
-            for (std::vector<Term_t*>::iterator itr = arrays.begin(); itr != arrays.end();
-                    ++itr)
-                delete[] *itr;
-        }
-};
-
 class BindingsTable {
     private:
-        std::unordered_set<BindingsRow, hash_BindingsRow> uniqueElements;
-        RawBindings *rawBindings;
-        Term_t *currentRow;
+        //Stores the rows in insertion order
+        RowHashSet<Term_t> uniqueElements;
+        Term_t currentRow[256];
 
         size_t nPosToCopy;
         size_t *posToCopy;
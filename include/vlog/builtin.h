@@ -5,11 +5,17 @@
 
 #include <functional>
 #include <array>
+#include <vector>
 
 struct BuiltinFunction {
     //Max five args
     std::array<uint8_t, 5> posArgs;
     std::function<bool(Term_t * , uint8_t *)> fn;
+    //Optional. Evaluates the function on a block of rows (rowSize terms
+    //each) and keeps in the selection vector only the indices of the rows
+    //that satisfy it
+    std::function<void(Term_t *, size_t, uint8_t *,
+            std::vector<uint32_t> &)> fnBlock;
 };
 
 #endif
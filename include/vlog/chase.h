@@ -5,6 +5,8 @@
 #include <vlog/edb.h>
 #include <vlog/fctable.h>
 
+#include <atomic>
+
 struct StatsSizeIDB {
     size_t step;
     int idRule;
@@ -24,12 +26,37 @@ struct StatsRule {
     double timems_join;
     double timems_createhead;
     double timems_retain;
+    double timems_restricted;
     std::string nbdyatoms;
 
+    //Used for the trace of the execution
+    double startms; //Since the beginning of the chase
+    double startms_retain;
+    int thread;
+    long ninput;
+    long nintermediate;
+    long nmergejoins;
+    long nhashjoins;
+    long nsorts;
+    long ncachehits;
+    long outputbytes;
+
     StatsRule() : idRule(-1), step(0), nderivations_final(-1),
     nderivations_unfiltered(-1), nderivations_unique(-1),
     timems(-1), timems_first(-1), timems_merge(-1),
-    timems_join(-1), timems_createhead(-1), timems_retain(-1) {}
+    timems_join(-1), timems_createhead(-1), timems_retain(-1),
+    timems_restricted(-1), startms(-1), startms_retain(-1), thread(0),
+    ninput(-1), nintermediate(-1), nmergejoins(-1), nhashjoins(-1),
+    nsorts(-1), ncachehits(-1), outputbytes(-1) {}
+};
+
+//Other phases of the chase (e.g., query containment) shown in the trace
+struct StatsSpan {
+    std::string name;
+    std::string category;
+    double startms;
+    double timems;
+    int thread;
 };
 
 class Chase {
@@ -41,15 +68,38 @@ class Chase {
 
 #ifdef WEBINTERFACE
         long statsLastIteration;
-        bool running;
+        //Written by the thread of the materialization, read by the web
+        //interface
+        std::atomic<bool> running;
 #endif
         std::vector<StatsRule> statsRuleExecution;
+        std::vector<StatsSpan> statsSpans;
+
+        void writeTrace(const std::string &path);
 
     protected:
         virtual void saveStatistics(StatsRule &stats) {
             statsRuleExecution.push_back(stats);
         }
 
+        void saveSpan(const std::string &name, const std::string &category,
+                std::chrono::system_clock::time_point start,
+                std::chrono::system_clock::time_point end, int thread = 0) {
+            StatsSpan span;
+            span.name = name;
+            span.category = category;
+            span.startms = getMsSinceStart(start);
+            span.timems = std::chrono::duration<double, std::milli>(
+                    end - start).count();
+            span.thread = thread;
+            statsSpans.push_back(span);
+        }
+
+        double getMsSinceStart(std::chrono::system_clock::time_point t) {
+            return std::chrono::duration<double, std::milli>(
+                    t - startTime).count();
+        }
+
         void initRun();
 
         void stopRun();
@@ -3,14 +3,13 @@
 
 #include <vlog/column.h>
 #include <vlog/ruleexecdetails.h>
+#include <vlog/rowhash.h>
 
 #include <vector>
 #include <map>
 #include <set>
 #include <unordered_map>
 
-#define SIZE_BLOCK 1000
-
 #define RULE_MASK INT64_C(0xffffff0000000000)
 #define RULE_SHIFT(x) (((uint64_t) ((x) + 1)) << 40)
 #define GET_RULE(x) (((x) >> 40) - 1)
@@ -22,35 +21,6 @@
 
 typedef enum TypeChase {RESTRICTED_CHASE, SKOLEM_CHASE, SUM_CHASE, SUM_RESTRICTED_CHASE } TypeChase;
 
-struct ChaseRow {
-    uint8_t sz;
-    uint64_t *row;
-
-    ChaseRow() : sz(0), row(NULL) {}
-
-    ChaseRow(const uint8_t s, uint64_t *r) : sz(s), row(r) {
-    }
-
-    bool operator == (const ChaseRow &other) const {
-        for (int i = 0; i < sz; i++) {
-            if (row[i] != other.row[i]) {
-                return false;
-            }
-        }
-        return true;
-    }
-};
-
-struct hash_ChaseRow {
-    size_t operator() (const ChaseRow &x) const {
-        uint64_t result = 0;
-        for (int i = 0; i < x.sz; i++) {
-            result = (result + (324723947 + x.row[i])) ^93485734985;
-        }
-        return (size_t) result;
-    }
-};
-
 class ChaseMgmt {
     private:
         class Rows {
@@ -59,10 +29,9 @@ class ChaseMgmt {
                 const uint8_t sizerow;
                 std::vector<Var_t> nameArgVars;
                 uint64_t currentcounter;
-                std::vector<std::unique_ptr<uint64_t[]>> blocks;
-                uint32_t blockCounter;
-                uint64_t *currentblock;
-                std::unordered_map<ChaseRow, uint64_t, hash_ChaseRow> rows;
+                //The value of a row is at the same index in values
+                RowHashSet<uint64_t> rows;
+                std::vector<uint64_t> values;
                 TypeChase typeChase;
                 std::set<uint64_t> deps;    // For SUM chases.
 
@@ -71,9 +40,7 @@ class ChaseMgmt {
                         std::vector<Var_t> nameArgVars,
                         TypeChase typeChase) :
                     startCounter(startCounter), sizerow(sizerow),
-                    nameArgVars(nameArgVars) {
-                        blockCounter = 0;
-                        currentblock = NULL;
+                    nameArgVars(nameArgVars), rows(sizerow) {
                         currentcounter = startCounter;
                         this->typeChase = typeChase;
                     }
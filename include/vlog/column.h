@@ -713,6 +713,169 @@ class SubColumn final : public Column {
 };
 //----- END SUBCOLUMN ----------
 
+//----- MAPPED COLUMN ----------
+//Column that reads the values directly from memory that is owned by another
+//object (e.g., a memory-mapped file). The owner is kept alive as long as the
+//column exists.
+class MappedColumnReader final : public ColumnReader {
+    private:
+        const Term_t *values;
+        const size_t len;
+        size_t currentPos;
+        size_t m_currentPos;
+
+    public:
+        MappedColumnReader(const Term_t *values, size_t len) : values(values),
+        len(len), currentPos(0), m_currentPos(0) {
+        }
+
+        Term_t first() {
+            return values[0];
+        }
+
+        Term_t last() {
+            return values[len - 1];
+        }
+
+        std::vector<Term_t> asVector() {
+            return std::vector<Term_t>(values, values + len);
+        }
+
+        bool hasNext() {
+            return currentPos < len;
+        }
+
+        Term_t next() {
+            return values[currentPos++];
+        }
+
+        void clear() {
+        }
+
+        void reset() {
+            currentPos = m_currentPos;
+        }
+
+        void mark() {
+            m_currentPos = currentPos;
+        }
+};
+
+class MappedColumn final : public Column {
+    private:
+        const std::shared_ptr<const void> owner;
+        const Term_t *values;
+        const size_t len;
+
+        std::shared_ptr<Column> copy(bool sort, bool unique,
+                int nthreads) const {
+            std::vector<Term_t> newvals(values, values + len);
+            if (sort) {
+                if (nthreads > 1)
+                    ParallelTasks::sort_int(newvals.begin(), newvals.end());
+                else
+                    std::sort(newvals.begin(), newvals.end());
+            }
+            if (unique) {
+                auto last = std::unique(newvals.begin(), newvals.end());
+                newvals.erase(last, newvals.end());
+                newvals.shrink_to_fit();
+            }
+            return std::shared_ptr<Column>(new InmemoryColumn(newvals, true));
+        }
+
+    public:
+        MappedColumn(std::shared_ptr<const void> owner, const Term_t *values,
+                size_t len) : owner(owner), values(values), len(len) {
+        }
+
+        size_t size() const {
+            return len;
+        }
+
+        size_t getRepresentationSize() const {
+            return len;
+        }
+
+        size_t estimateSize() const {
+            return len;
+        }
+
+        bool isEmpty() const {
+            return len == 0;
+        }
+
+        Term_t getValue(const size_t pos) const {
+            return values[pos];
+        }
+
+        bool supportsDirectAccess() const {
+            return true;
+        }
+
+        bool isEDB() const {
+            return false;
+        }
+
+        bool containsDuplicates() const {
+            return len > 1;
+        }
+
+        std::shared_ptr<Column> slice(size_t start, size_t end) const {
+            return std::shared_ptr<Column>(new MappedColumn(owner,
+                        values + start, end - start));
+        }
+
+        std::unique_ptr<ColumnReader> getReader() const {
+            return std::unique_ptr<ColumnReader>(new MappedColumnReader(
+                        values, len));
+        }
+
+        std::shared_ptr<Column> sort() const {
+            return copy(true, false, 1);
+        }
+
+        std::shared_ptr<Column> sort_and_unique() const {
+            return copy(true, true, 1);
+        }
+
+        std::shared_ptr<Column> sort(const int nthreads) const {
+            return copy(true, false, nthreads);
+        }
+
+        std::shared_ptr<Column> sort_and_unique(const int nthreads) const {
+            return copy(true, true, nthreads);
+        }
+
+        std::shared_ptr<Column> unique() const {
+            //I assume the column is already sorted
+            return copy(false, true, 1);
+        }
+
+        size_t countHits(const std::vector<Term_t> &terms) const {
+            size_t c = 0;
+            for(auto &t : terms) {
+                if (std::binary_search(values, values + len, t))
+                    c++;
+            }
+            return c;
+        }
+
+        bool isConstant() const {
+            return len < 2;
+        }
+
+        Term_t first() const {
+            assert(len > 0);
+            return values[0];
+        }
+
+        bool isIn(const Term_t t) const {
+            return std::binary_search(values, values + len, t);
+        }
+};
+//----- END MAPPED COLUMN ----------
+
 
 //----- EDB COLUMN ----------
 class EDBColumnReader final : public ColumnReader {
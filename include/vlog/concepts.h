@@ -4,6 +4,7 @@
 #include <vlog/support.h>
 #include <vlog/consts.h>
 #include <vlog/graph.h>
+#include <vlog/rowhash.h>
 
 #include <kognac/logs.h>
 
@@ -169,17 +170,17 @@ class VTuple {
 
 struct hash_VTuple {
     size_t operator()(const VTuple &v) const {
-        size_t hash = 0;
+        uint64_t hash = 0;
         int sz = v.getSize();
         for (int i = 0; i < sz; i++) {
             VTerm term = v.get(i);
             if (term.isVariable()) {
-                hash = (hash + (324723947 + term.getId())) ^93485734985;
+                hash = combineHash64(hash, term.getId());
             } else {
-                hash = (hash + (324723947 + term.getValue())) ^93485734985;
+                hash = combineHash64(hash, term.getValue());
             }
         }
-        return hash;
+        return mixHash64(hash);
     }
 };
 
@@ -510,6 +511,34 @@ class Rule {
         }
 };
 
+//Identifies a version of the rules of a program. A new value is drawn when
+//the program is created or copied and whenever its rules change, so values
+//are never reused, not even by a program allocated at the same address
+class ProgramGeneration {
+    private:
+        uint64_t value;
+
+        static uint64_t next();
+
+    public:
+        ProgramGeneration() : value(next()) {}
+
+        ProgramGeneration(const ProgramGeneration &) : value(next()) {}
+
+        ProgramGeneration &operator=(const ProgramGeneration &) {
+            value = next();
+            return *this;
+        }
+
+        void increment() {
+            value = next();
+        }
+
+        uint64_t get() const {
+            return value;
+        }
+};
+
 class Program {
     private:
         EDBLayer *kb;
@@ -520,6 +549,7 @@ class Program {
         Dictionary dictPredicates;
         std::unordered_map<PredId_t, uint8_t> cardPredicates;
         std::unordered_map<PredId_t, uint8_t> typePredicates;
+        ProgramGeneration generation;
 
         void rewriteRule(std::vector<Literal> &heads,
                 std::vector<Literal> &body);
@@ -589,6 +619,10 @@ class Program {
 
         VLIBEXP int getNRules() const;
 
+        uint64_t getGeneration() const {
+            return generation.get();
+        }
+
         Program clone() const;
 
         std::shared_ptr<Program> cloneNew() const;
@@ -17,6 +17,7 @@
 
 #include <vector>
 #include <map>
+#include <mutex>
 
 //Datatype is set in the most significant three bits
 #define IS_NUMBER(x) ((x) >> 61)
@@ -144,6 +145,9 @@ class EDBLayer {
 
         const EDBConf &conf;
         const bool multithreaded;
+        //Threads used to load the tables if multithreaded is set (0 means
+        //one per core)
+        const int nthreads;
         const std::string edbconfpath;
         bool loadAllData;
 
@@ -157,7 +161,12 @@ class EDBLayer {
         std::vector<IndexedTupleTable *>tmpRelations;
 
         std::vector<std::shared_ptr<EDBTable>> edbTablesWithDict;
-        std::shared_ptr<Dictionary> termsDictionary;//std::string, Term_t
+        //Terms that are not in the tables. It is created (under
+        //termsDictionaryMutex) when the first new term is added
+        std::shared_ptr<ConcurrentDictionary> termsDictionary;
+        std::mutex termsDictionaryMutex;
+
+        std::shared_ptr<ConcurrentDictionary> getTermsDictionary();
         std::string rootPath;
 
         VLIBEXP void addTridentTable(const EDBConf::Table &tableConf,
@@ -189,6 +198,8 @@ class EDBLayer {
 #endif
         VLIBEXP void addInmemoryTable(const EDBConf::Table &tableConf,
                 std::string edbconfpath);
+        VLIBEXP void addBinaryTable(const EDBConf::Table &tableConf);
+
         VLIBEXP void addSparqlTable(const EDBConf::Table &tableConf);
 
         VLIBEXP void addEDBonIDBTable(const EDBConf::Table &tableConf);
@@ -210,15 +221,17 @@ class EDBLayer {
                 std::string edbconfpath, PredId_t predId = 0,
                 bool usePredId = false);
 
+        int getNThreadsLoad() const;
+
     public:
         EDBLayer(EDBLayer &db, bool copyTables = false);
 
         EDBLayer(const EDBConf &conf, bool multithreaded,
                 const NamedSemiNaiver &prevSemiNaiver,
-                bool loadAllData = true) :
+                bool loadAllData = true, int nthreads = 0) :
             conf(conf), prevSemiNaiver(prevSemiNaiver),
             loadAllData(loadAllData), multithreaded(multithreaded),
-            edbconfpath(conf.getConfigFilePath()), context_gbGraph(NULL),
+            nthreads(nthreads), edbconfpath(conf.getConfigFilePath()), context_gbGraph(NULL),
             context_step(0)
     {
 
@@ -238,8 +251,9 @@ class EDBLayer {
     }
 
         EDBLayer(const EDBConf &conf, bool multithreaded,
-                bool loadAllData = true) :
-            EDBLayer(conf, multithreaded, NamedSemiNaiver(), loadAllData)
+                bool loadAllData = true, int nthreads = 0) :
+            EDBLayer(conf, multithreaded, NamedSemiNaiver(), loadAllData,
+                    nthreads)
     {
     }
 
@@ -401,6 +415,11 @@ class EDBLayer {
         VLIBEXP bool getOrAddDictNumber(const char *text,
                 const size_t sizeText, uint64_t &id);
 
+        //Batched version of getOrAddDictNumber. The new terms are added to
+        //the dictionary in one call, which locks each of its shards once
+        VLIBEXP void getOrAddDictNumbers(const std::vector<std::string> &texts,
+                std::vector<uint64_t> &ids);
+
         VLIBEXP bool getDictText(const uint64_t id, char *text) const;
 
         VLIBEXP std::string getDictText(const uint64_t id) const;
@@ -425,6 +444,10 @@ class EDBLayer {
 
         VLIBEXP uint64_t getNTerms() const;
 
+        //Number of terms in the dictionaries of the tables, without the terms
+        //added at runtime
+        uint64_t getNTermsInTables() const;
+
         VLIBEXP uint64_t getNPredicates() const;
 
         bool expensiveEDBPredicate(PredId_t id) {
@@ -7,6 +7,11 @@
 
 #include <trident/tree/root.h>
 
+//Rows of a table that are formatted and written by one task of storeOnFiles
+#define EXPORTER_CHUNK_ROWS (1 << 20)
+
+typedef enum { EXPORT_TSV, EXPORT_CSV, EXPORT_BINARY } ExportFormat;
+
 struct _EDBPredicates {
     PredId_t id;
     size_t ruleid;
@@ -43,6 +48,18 @@ class Exporter {
 
         VLIBEXP void storeOnFiles(std::string path, const bool decompress,
                 const int minLevel, const bool csv);
+
+        //Store every IDB predicate in a file with nthreads threads. The
+        //tables are split in chunks of EXPORTER_CHUNK_ROWS rows that are
+        //formatted (and compressed with gzip, if gzip is set) in parallel,
+        //and then written in order. With EXPORT_BINARY, each file contains
+        //the IDs column by column, in blocks (decompress is ignored).
+        //The results of GBChase are read directly from the nodes of the
+        //graph. If mergeGBNodes is set, the nodes of each predicate are
+        //merged so that every fact is written only once.
+        VLIBEXP void storeOnFiles(std::string path, const bool decompress,
+                const ExportFormat format, const bool gzip, int nthreads,
+                const bool mergeGBNodes = false);
 };
 
 #endif
@@ -0,0 +1,102 @@
+#ifndef _BINARYTABLE_H
+#define _BINARYTABLE_H
+
+#include <vlog/concepts.h>
+#include <vlog/edbconf.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+class EDBLayer;
+class Segment;
+
+//Tables with a larger arity store only the sort orders that start with each
+//column, instead of all the permutations
+#define BINARYTABLE_MAX_ARITY_ALLPERMS 3
+
+//Read-only columnar file that contains the rows of an EDB table, sorted in
+//several orders, and the dictionary of the terms that appear in them. The
+//file is memory-mapped, so the columns can be used without copying them and
+//multiple processes share the same pages. Layout (in 8-byte words):
+//magic, version, arity, nrows, nterms, norders, the IDs of the terms (sorted),
+//nterms+1 offsets in the string area, the (padded) string area and, for each
+//order, a word with the sorted fields followed by arity columns of nrows IDs.
+class BinaryTableFile {
+    private:
+        const std::string path;
+        int fd;
+        char *mapped;
+        size_t mappedSize;
+
+        uint8_t arity;
+        size_t nrows;
+        size_t nterms;
+        const Term_t *termIds;
+        const uint64_t *termOffsets;
+        const char *terms;
+        std::vector<std::vector<uint8_t>> orders;
+        std::vector<const Term_t *> orderColumns;
+
+        void load();
+
+        void unmap();
+
+    public:
+        BinaryTableFile(const std::string &path);
+
+        uint8_t getArity() const {
+            return arity;
+        }
+
+        size_t getNRows() const {
+            return nrows;
+        }
+
+        size_t getNTerms() const {
+            return nterms;
+        }
+
+        //ID the term had when the file was created
+        Term_t getTermId(size_t idx) const {
+            return termIds[idx];
+        }
+
+        const Term_t *getTermIds() const {
+            return termIds;
+        }
+
+        const char *getTerm(size_t idx, size_t &len) const {
+            len = termOffsets[idx + 1] - termOffsets[idx];
+            return terms + termOffsets[idx];
+        }
+
+        size_t getNOrders() const {
+            return orders.size();
+        }
+
+        //The first order is always the one by the fields 0, 1, ...
+        const std::vector<uint8_t> &getOrder(size_t idx) const {
+            return orders[idx];
+        }
+
+        const Term_t *getColumn(size_t orderIdx, uint8_t colIdx) const {
+            return orderColumns[orderIdx] + colIdx * nrows;
+        }
+
+        ~BinaryTableFile();
+
+        //Write the rows of segment (which must be sorted by all fields and
+        //without duplicates) in a new file. The terms are taken from layer
+        static void create(const std::string &path, uint8_t arity,
+                std::shared_ptr<const Segment> segment, EDBLayer &layer,
+                int nthreads);
+
+        //Convert all the CSV/INMEMORY tables of conf (already loaded in
+        //layer) to binary tables in outputDir. It also writes in outputDir an
+        //edb.conf where these tables are replaced by the binary ones.
+        VLIBEXP static void convert(const EDBConf &conf, EDBLayer &layer,
+                const std::string &outputDir, int nthreads);
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <vlog/edbtable.h>
 #include <vlog/edbiterator.h>
 #include <vlog/segment.h>
+#include <vlog/inmemory/binarytable.h>
 
 class InmemoryIterator : public EDBIterator {
     private:
@@ -85,13 +86,20 @@ class InmemoryTable : public EDBTable {
                 const std::vector<uint8_t> &fields);
 
     public:
+        //If nthreads > 1, CSV files are parsed by nthreads threads
         InmemoryTable(std::string repository, std::string tablename, PredId_t predid,
-                EDBLayer *layer, char sep=',', bool loadData = true);
+                EDBLayer *layer, char sep=',', bool loadData = true,
+                int nthreads = 1);
 
         InmemoryTable(PredId_t predid, std::vector<std::vector<std::string>> &entries, EDBLayer *layer);
 
         InmemoryTable(PredId_t predid, uint8_t arity, std::vector<uint64_t> &entries, EDBLayer *layer);
 
+        //The columns and the sort orders stored in file are used without
+        //copying them if the terms keep the same IDs
+        InmemoryTable(PredId_t predid, std::shared_ptr<BinaryTableFile> file,
+                EDBLayer *layer, int nthreads = 1);
+
         InmemoryTable(PredId_t predid,
                 const Literal &query,
                 // const
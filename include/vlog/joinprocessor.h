@@ -34,6 +34,9 @@ struct LessTwoTuples {
 #define THRESHOLD_HASHJOIN 100
 
 #define FLUSH_SIZE (1 << 20)
+//Number of rows of the left relation joined by one task in the parallel
+//merge join. Small morsels let idle threads take over the work of skewed ones
+#define JOIN_MORSEL_SIZE 16384
 
 class Output {
     private:
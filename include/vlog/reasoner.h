@@ -16,6 +16,9 @@
 
 #include <trident/sparql/query.h>
 #include <vector>
+#include <map>
+#include <tuple>
+#include <mutex>
 
 #define QUERY_MAT 0
 #define QUERY_ONDEM 1
@@ -33,11 +36,31 @@ struct Metrics {
     uint8_t boundedness;
 };
 
+//Program rewritten with magic sets for a query. It depends only on the
+//predicate and on the adornment of the query: the constants are added as
+//facts of the input relation
+struct MagicProgram {
+    std::shared_ptr<Program> program;
+    std::pair<PredId_t, PredId_t> inputOutputRelIDs;
+};
+
 class Reasoner {
     private:
 
         const uint64_t threshold;
 
+        //Key is (generation of the program, predicate, adornment)
+        std::mutex mtxMagicPrograms;
+        std::map<std::tuple<uint64_t, PredId_t, uint8_t>,
+            MagicProgram> magicPrograms;
+        //Latest generation seen for every program. The entries of older
+        //generations are evicted since they cannot be hit anymore
+        std::map<const Program *, uint64_t> magicGenerations;
+
+        //The returned program is a copy, the chases can modify it
+        MagicProgram getMagicProgram(Literal &query, EDBLayer &edb,
+                Program &program);
+
         void cleanBindings(std::vector<Term_t> &bindings,
                 std::vector<uint8_t> * posJoins,
                 TupleTable *input);
@@ -157,6 +180,10 @@ class Reasoner {
 
         int getNumberOfIDBPredicates(Literal&, Program&);
 
+        //Programs that are changed get a new generation, so this is needed
+        //only to release memory or to measure the cost of the rewriting
+        VLIBEXP void clearMagicPrograms();
+
         ~Reasoner() {
         }
 };
@@ -0,0 +1,212 @@
+#ifndef _ROW_HASH_H
+#define _ROW_HASH_H
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <inttypes.h>
+
+//Dictionary IDs of terms are often close to each other. Every value goes
+//through a full 64-bit mixer (the finalizer of MurmurHash3) so that the hash
+//of clustered IDs does not collide in the lowest bits
+#define ROWHASH_MULT 0x9e3779b97f4a7c15ull
+
+inline uint64_t mixHash64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+inline uint64_t combineHash64(uint64_t h, uint64_t v) {
+    return (h ^ mixHash64(v)) * ROWHASH_MULT;
+}
+
+template<typename T>
+inline uint64_t hashRow(const T *row, size_t n) {
+    uint64_t h = n;
+    for (size_t i = 0; i < n; ++i) {
+        h = combineHash64(h, (uint64_t) row[i]);
+    }
+    return mixHash64(h);
+}
+
+//Slots that fit in a cache line
+#define ROWHASHSET_GROUP 8
+//Minimum number of rows of the first block of storage
+#define ROWHASHSET_MIN_BLOCK 16
+#define ROWHASHSET_IDX_BITS 40
+#define ROWHASHSET_IDX_MASK ((UINT64_C(1) << ROWHASHSET_IDX_BITS) - 1)
+
+//Open-addressing set of rows with a fixed number of columns. A slot stores
+//the index of the row and the highest bits of its hash as tag. The lookups
+//scan the slots of one cache line before they move to the next one, and
+//compare the rows only if the tags match. The rows are copied in blocks that
+//never move, so the pointers returned by getRow stay valid. The first block
+//is sized from the expected number of rows and every following block doubles
+//the capacity. Rows are numbered in insertion order.
+template<typename T>
+class RowHashSet {
+    private:
+        uint8_t card;
+        std::vector<uint64_t> slots; //0 if empty
+        std::vector<std::unique_ptr<T[]>> blocks;
+        uint8_t firstBlockBits; //log2 of the rows of the first block
+        size_t nrows;
+
+        //Block 0 contains the first 2^firstBlockBits rows, block b > 0 the
+        //next 2^(firstBlockBits + b - 1) rows
+        size_t getBlock(size_t idx, size_t &offset) const {
+            const size_t q = idx >> firstBlockBits;
+            if (q == 0) {
+                offset = idx;
+                return 0;
+            }
+            const size_t b = 64 - __builtin_clzll(q);
+            offset = idx - ((size_t) 1 << (firstBlockBits + b - 1));
+            return b;
+        }
+
+        static uint64_t getTag(uint64_t h) {
+            return h >> ROWHASHSET_IDX_BITS;
+        }
+
+        bool equals(const T *row1, const T *row2) const {
+            for (uint8_t i = 0; i < card; ++i) {
+                if (row1[i] != row2[i])
+                    return false;
+            }
+            return true;
+        }
+
+        //Returns the index of the row or -1. In this case, slot is the first
+        //empty slot where the row can be added
+        int64_t find(const T *row, uint64_t h, size_t &slot) const {
+            const size_t mask = slots.size() / ROWHASHSET_GROUP - 1;
+            const uint64_t tag = getTag(h);
+            size_t group = h & mask;
+            while (true) {
+                const uint64_t *line = slots.data() + group * ROWHASHSET_GROUP;
+                for (size_t i = 0; i < ROWHASHSET_GROUP; ++i) {
+                    const uint64_t v = line[i];
+                    if (v == 0) {
+                        slot = group * ROWHASHSET_GROUP + i;
+                        return -1;
+                    }
+                    if (getTag(v) == tag) {
+                        const size_t idx = (v & ROWHASHSET_IDX_MASK) - 1;
+                        if (equals(getRow(idx), row))
+                            return idx;
+                    }
+                }
+                group = (group + 1) & mask;
+            }
+        }
+
+        void resize(size_t nslots) {
+            std::vector<uint64_t> old(nslots, 0);
+            slots.swap(old);
+            for (size_t idx = 0; idx < nrows; ++idx) {
+                const T *row = getRow(idx);
+                const uint64_t h = hashRow(row, card);
+                size_t slot = 0;
+                find(row, h, slot);
+                slots[slot] = (getTag(h) << ROWHASHSET_IDX_BITS) | (idx + 1);
+            }
+        }
+
+    public:
+        RowHashSet(uint8_t card, size_t estSize = 0) : card(card),
+        firstBlockBits(0), nrows(0) {
+            while (((size_t) 1 << firstBlockBits) < ROWHASHSET_MIN_BLOCK) {
+                firstBlockBits++;
+            }
+            slots.resize(ROWHASHSET_GROUP, 0);
+            reserve(estSize);
+        }
+
+        uint8_t getCard() const {
+            return card;
+        }
+
+        size_t size() const {
+            return nrows;
+        }
+
+        const T *getRow(size_t idx) const {
+            size_t offset;
+            const size_t b = getBlock(idx, offset);
+            return blocks[b].get() + offset * card;
+        }
+
+        T *getRow(size_t idx) {
+            size_t offset;
+            const size_t b = getBlock(idx, offset);
+            return blocks[b].get() + offset * card;
+        }
+
+        void reserve(size_t n) {
+            //The size of the first block can change until it is allocated
+            while (blocks.empty() && firstBlockBits < 32 &&
+                    ((size_t) 1 << firstBlockBits) < n) {
+                firstBlockBits++;
+            }
+            //Keep the load factor below 3/4
+            size_t nslots = slots.size();
+            while (n * 4 > nslots * 3) {
+                nslots *= 2;
+            }
+            if (nslots != slots.size()) {
+                resize(nslots);
+            }
+        }
+
+        int64_t find(const T *row) const {
+            size_t slot = 0;
+            return find(row, hashRow(row, card), slot);
+        }
+
+        bool contains(const T *row) const {
+            return find(row) != -1;
+        }
+
+        //Returns the index of the row. inserted is false if the row was
+        //already in the set
+        size_t insert(const T *row, bool &inserted) {
+            reserve(nrows + 1);
+            const uint64_t h = hashRow(row, card);
+            size_t slot = 0;
+            const int64_t existing = find(row, h, slot);
+            if (existing != -1) {
+                inserted = false;
+                return existing;
+            }
+            const size_t idx = nrows;
+            size_t offset;
+            const size_t b = getBlock(idx, offset);
+            if (b == blocks.size()) {
+                const size_t blockRows = (size_t) 1 <<
+                    (b == 0 ? firstBlockBits : firstBlockBits + b - 1);
+                blocks.push_back(std::unique_ptr<T[]>(
+                            new T[(size_t) card * blockRows]));
+            }
+            T *dest = getRow(idx);
+            for (uint8_t i = 0; i < card; ++i) {
+                dest[i] = row[i];
+            }
+            slots[slot] = (getTag(h) << ROWHASHSET_IDX_BITS) | (idx + 1);
+            nrows++;
+            inserted = true;
+            return idx;
+        }
+
+        //Keeps the memory for the next rows
+        void clear() {
+            std::fill(slots.begin(), slots.end(), 0);
+            nrows = 0;
+        }
+};
+
+#endif
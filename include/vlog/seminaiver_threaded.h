@@ -5,29 +5,36 @@
 
 #include <mutex>
 #include <thread>
+#include <atomic>
 
+//Data produced by one thread during a round. It is merged after all the
+//threads are finished, so that the threads do not need to synchronize
 struct SemiNaiver_Threadlocal {
-    std::vector<FCBlock> listDerivations;
-    std::vector<StatsRule> statsRuleExecution;
+    std::vector<StatIteration> costRules;
+    std::vector<PredId_t> derivedPredicates;
     size_t iteration;
 };
 
+//The rules are split in one queue per thread. A thread takes the rules from
+//its own queue and, when that is empty, takes the remaining rules of the
+//other queues. Queues are consumed with atomic counters, without locks.
 class StatusRuleExecution_ThreadSafe {
     private:
         //Internal data structures
-
-        //Hold all rules to execution
         std::mutex mutexRules;
-        int rulecount;
         const int nrules;
+        const int nqueues;
+        std::unique_ptr<std::atomic<int>[]> nextRule;
+        std::vector<int> endRule;
 
         std::vector<ResultJoinProcessor*> tmpderivations;
 
     public:
 
-        StatusRuleExecution_ThreadSafe(const int nrules);
+        StatusRuleExecution_ThreadSafe(const int nrules, const int nqueues = 1);
 
-        int getRuleIDToExecute();
+        //Returns -1 if all the rules were taken
+        int getRuleIDToExecute(const int queueIdx = 0);
 
         void registerDerivations(ResultJoinProcessor *res);
 
@@ -39,10 +46,6 @@ class StatusRuleExecution_ThreadSafe {
 class SemiNaiverThreaded: public SemiNaiver {
 
     private:
-        //const int nthreads;
-        //TODO This variable is only visible to the thread
-        std::shared_ptr<SemiNaiver_Threadlocal> thread_data;
-
         std::vector<bool> marked;
         std::vector<bool> newMarked;
 
@@ -108,8 +111,11 @@ class SemiNaiverThreaded: public SemiNaiver {
         void runThread(
                 std::vector<RuleExecutionDetails> &ruleset,
                 StatusRuleExecution_ThreadSafe *status,
-                std::vector<StatIteration> *costRules,
-                size_t lastExec);
+                SemiNaiver_Threadlocal *data,
+                const int threadIdx);
+
+        void getRulePredicates(RuleExecutionDetails &rule,
+                std::vector<PredId_t> &predicates);
 
         bool executeUntilSaturation(
                 std::vector<RuleExecutionDetails> &ruleset,
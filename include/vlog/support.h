@@ -5,6 +5,8 @@
 #include <string>
 #include <functional>
 #include <vector>
+#include <mutex>
+#include <atomic>
 
 #include "term.h"
 #include <kognac/logs.h>
@@ -128,6 +130,94 @@ class Dictionary {
         }
 };
 
+//Number of shards of ConcurrentDictionary. Each shard has its own lock
+#define DICT_NSHARDS 64
+
+//Dictionary of terms that can be updated by multiple threads. The strings are
+//distributed in shards by their hash. Each shard stores its strings only once,
+//in an arena, and looks them up with an open-addressing table of indices; the
+//reverse map (also sharded) contains only references to the arenas.
+class ConcurrentDictionary {
+    private:
+        struct Shard {
+            mutable std::mutex mutex;
+            std::vector<char> arena;
+            std::vector<uint64_t> offsets; //Start of each string, plus the end
+            std::vector<Term_t> ids;
+            std::vector<uint32_t> slots; //1 + index of the string, 0 if empty
+            Shard();
+        };
+
+        struct ReverseShard {
+            mutable std::mutex mutex;
+            google::dense_hash_map<Term_t, uint64_t> map; //shard << 32 | index
+            ReverseShard();
+        };
+
+        Shard shards[DICT_NSHARDS];
+        ReverseShard reverseShards[DICT_NSHARDS];
+        std::atomic<uint64_t> counter;
+        std::atomic<uint64_t> nterms;
+
+        static uint64_t hash(const char *text, size_t len);
+
+        static int64_t find(const Shard &shard, const char *text, size_t len,
+                uint64_t h, size_t &slot);
+
+        static void grow(Shard &shard);
+
+        //The lock of the shard must be held
+        void insert(size_t shardIdx, const char *text, size_t len,
+                uint64_t h, Term_t id);
+
+    public:
+        ConcurrentDictionary() : ConcurrentDictionary(1) {
+        }
+
+        ConcurrentDictionary(uint64_t startingCounter);
+
+        bool get(const char *text, size_t len, Term_t &id) const;
+
+        bool get(const std::string &rawValue, Term_t &id) const {
+            return get(rawValue.c_str(), rawValue.size(), id);
+        }
+
+        Term_t getOrAdd(const char *text, size_t len);
+
+        Term_t getOrAdd(const std::string &rawValue) {
+            return getOrAdd(rawValue.c_str(), rawValue.size());
+        }
+
+        //Batched versions. Each shard is locked once per batch. get sets
+        //found[i] to false if rawValues[i] is not in the dictionary. getOrAdd
+        //assigns the new IDs in the order of rawValues
+        void get(const std::vector<std::string> &rawValues,
+                std::vector<Term_t> &ids, std::vector<bool> &found) const;
+
+        void getOrAdd(const std::vector<std::string> &rawValues,
+                std::vector<Term_t> &ids);
+
+        bool getRawValue(const Term_t id, std::string &rawValue) const;
+
+        std::string getRawValue(const Term_t id) const {
+            std::string out;
+            getRawValue(id, out);
+            return out;
+        }
+
+        bool contains(const Term_t id) const;
+
+        uint64_t getCounter() const {
+            return counter;
+        }
+
+        size_t size() const {
+            return nterms;
+        }
+
+        size_t getSizeInBytes() const;
+};
+
 class ReasoningUtils {
     public:
         static int cmp(const Term_t *r1, const Term_t *r2, const size_t s) {
@@ -1,6 +1,8 @@
 #ifndef TERM_H
 #define TERM_H
 
+#include <vlog/rowhash.h>
+
 #include <inttypes.h>
 #include <utility>
 
@@ -96,11 +98,8 @@ namespace std {
     template<>
         struct hash<std::pair<Term_t,Term_t>> {
             size_t operator()(const std::pair<Term_t,Term_t> &t) const {
-                size_t seed = 0;
-                std::hash<uint64_t> hasher;
-                seed ^= hasher(t.first) + 0x9e3779b9 + (seed<<6) + (seed>>2);
-                seed ^= hasher(t.second) + 0x9e3779b9 + (seed<<6) + (seed>>2);
-                return seed;
+                return mixHash64(combineHash64(
+                            combineHash64(2, t.first), t.second));
             }
         };
 }
@@ -5,6 +5,7 @@
 #include <vlog/edbtable.h>
 
 #include <vector>
+#include <unordered_map>
 
 class StringTable: public EDBTable {
     protected:
@@ -20,6 +21,9 @@ class StringTable: public EDBTable {
             return false;
         }
 
+        void builtinFunctionBlock(Term_t *rows, size_t rowSize, uint8_t *pos,
+                std::vector<uint32_t> &selection);
+
     public:
         StringTable(PredId_t predid,
                 EDBLayer *layer,
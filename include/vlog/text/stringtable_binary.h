@@ -29,6 +29,10 @@ class StringTableBinary : public StringTable {
             fn.fn = std::bind(&StringTableBinary::builtinFunction,
                     this,
                     std::placeholders::_1, std::placeholders::_2);
+            fn.fnBlock = std::bind(&StringTableBinary::builtinFunctionBlock,
+                    this,
+                    std::placeholders::_1, std::placeholders::_2,
+                    std::placeholders::_3, std::placeholders::_4);
             return fn;
 
         }
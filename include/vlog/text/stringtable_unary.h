@@ -33,6 +33,10 @@ class StringTableUnary : public StringTable {
             fn.fn = std::bind(&StringTableUnary::builtinFunction,
                     this,
                     std::placeholders::_1, std::placeholders::_2);
+            fn.fnBlock = std::bind(&StringTableUnary::builtinFunctionBlock,
+                    this,
+                    std::placeholders::_1, std::placeholders::_2,
+                    std::placeholders::_3, std::placeholders::_4);
             return fn;
         }
 };
@@ -24,6 +24,68 @@
 #include <map>
 #include <condition_variable>
 #include <mutex>
+#include <atomic>
+
+//Number of requests of each endpoint used to compute the latency percentiles
+#define WEB_LATENCY_SAMPLES 10000
+
+//Readers-writer lock on the KB of the web interface. Read-only queries share
+//it and run concurrently; requests that replace or change the KB take it
+//exclusively and wait until the queries are finished
+class WebKBLock {
+    private:
+        std::mutex mtx;
+        std::condition_variable cv;
+        int readers;
+        bool writer;
+        //New readers wait while a writer is queued, so writers do not starve
+        int writersWaiting;
+
+    public:
+        WebKBLock() : readers(0), writer(false), writersWaiting(0) {
+        }
+
+        void lock(bool exclusive);
+
+        void unlock(bool exclusive);
+
+        class Guard {
+            private:
+                WebKBLock &l;
+                const bool exclusive;
+
+            public:
+                Guard(WebKBLock &l, bool exclusive) : l(l),
+                exclusive(exclusive) {
+                    l.lock(exclusive);
+                }
+
+                ~Guard() {
+                    l.unlock(exclusive);
+                }
+        };
+};
+
+//Latencies of the last WEB_LATENCY_SAMPLES requests to an endpoint. The wait
+//is the time spent in the admission queue before the request could access the
+//KB, the total includes the execution
+class WebLatencyStats {
+    private:
+        std::mutex mtx;
+        std::vector<double> waitms;
+        std::vector<double> totalms;
+        uint64_t count;
+
+        static void percentiles(std::vector<double> samples, JSON &out);
+
+    public:
+        WebLatencyStats() : count(0) {
+        }
+
+        void add(double wait, double total);
+
+        void toJSON(JSON &out);
+};
 
 class VLogLayer;
 class WebInterface {
@@ -37,23 +99,38 @@ class WebInterface {
         void setupTridentLayer();
 
     private:
+        //Accessed with std::atomic_load/atomic_store, since /launchMat
+        //replaces it while other requests read it
         std::shared_ptr<Chase> sn;
+        //Last materialization that finished. Queries read only this one, so
+        //they never see the tables of a running materialization
+        std::shared_ptr<Chase> snFinished;
         std::thread t;
         std::thread matRunner;
         std::mutex mtxMatRunner;
+        //True from /launchMat until the runner has published the result in
+        //snFinished. Guarded by mtxMatRunner. /setup checks it, since the
+        //queued materialization already refers to the EDB layer and the
+        //program
+        bool matPending;
         std::condition_variable cvMatRunner;
         std::string dirhtmlfiles;
         std::string cmdArgs;
 
         std::shared_ptr<HttpServer> server;
 
-        bool isActive;
+        WebKBLock kbLock;
+        std::atomic<int> activeRequests;
         std::string edbFile;
         int webport;
         int nthreads;
 
+        std::mutex mtxCache;
         map<std::string, std::string> cachehtml;
 
+        std::mutex mtxLatencies;
+        map<std::string, std::unique_ptr<WebLatencyStats>> latencies;
+
         void startThread(int port);
 
         void processMaterialization();
@@ -63,6 +140,18 @@ class WebInterface {
 
         void processRequest(std::string req, std::string &resp);
 
+        void executeRequest(std::string &req, std::string &resp);
+
+        //Requests that change the KB cannot run concurrently with the others
+        static bool isExclusiveRequest(const std::string &req,
+                const std::string &path);
+
+        bool isMatPending();
+
+        void addLatency(const std::string &path, double wait, double total);
+
+        void getStats(JSON &out);
+
         void getResultsQueryLiteral(std::shared_ptr<Chase> sn,
                 std::unique_ptr<Program> &p,
                 std::string predicate,
@@ -85,11 +174,11 @@ class WebInterface {
         long getDurationExecMs();
 
         void setActive() {
-            isActive = true;
+            activeRequests++;
         }
 
         void setInactive() {
-            isActive = false;
+            activeRequests--;
         }
 
         void join() {
@@ -97,7 +186,7 @@ class WebInterface {
         }
 
         std::shared_ptr<Chase> getChase() {
-            return sn;
+            return std::atomic_load(&sn);
         }
 
         std::string getCommandLineArgs() {
@@ -0,0 +1,301 @@
+#!/usr/bin/env python3
+
+# Offline benchmark of the reasoning procedures of GLog. It generates
+# synthetic KBs (deterministically, given the seed), materializes them with
+# the selected commands and writes runtime, peak RSS, derived facts, nodes and
+# triggers of each run in a JSON file.
+#
+# Usage: benchmark.py --glog build/glog --scale 10000 --out results.json
+#
+# Two result files can be compared with --compare old.json, which fails if
+# the runtime of a run increased more than --tolerance or if the number of
+# derived facts changed.
+
+import argparse
+import json
+import os
+import random
+import re
+import subprocess
+import sys
+import time
+
+KBS = ['lubm', 'chain', 'tc', 'existential']
+COMMANDS = ['mat', 'gbchase', 'tgchase', 'tgchasefullprov', 'probtgchase']
+
+
+def writeTable(dbdir, name, rows):
+    with open(os.path.join(dbdir, name + '.csv'), 'wt') as out:
+        for row in rows:
+            out.write(','.join(row) + '\n')
+
+
+def writeKB(kbdir, tables, rules):
+    dbdir = os.path.join(kbdir, 'db')
+    os.makedirs(dbdir, exist_ok=True)
+    with open(os.path.join(kbdir, 'edb.conf'), 'wt') as conf:
+        for i, name in enumerate(sorted(tables)):
+            writeTable(dbdir, name, tables[name])
+            conf.write('EDB%d_predname=%s\n' % (i, name))
+            conf.write('EDB%d_type=INMEMORY\n' % i)
+            conf.write('EDB%d_param0=db\n' % i)
+            conf.write('EDB%d_param1=%s\n' % (i, name))
+    with open(os.path.join(kbdir, 'rules.dlog'), 'wt') as out:
+        for rule in rules:
+            out.write(rule + '\n')
+
+
+# Universities with departments, professors, students and courses, and a
+# subset of the rules of LUBM
+def genLUBM(scale, rnd):
+    ndepts = max(1, scale // 100)
+    tables = {'subOrganizationOf': [], 'worksFor': [], 'headOf': [],
+              'memberOf': [], 'advisor': [], 'takesCourse': [],
+              'teacherOf': [], 'typeOf': []}
+    for d in range(ndepts):
+        dept = 'dept%d' % d
+        univ = 'univ%d' % (d // 10)
+        group = 'group%d' % d
+        tables['subOrganizationOf'].append([dept, univ])
+        tables['subOrganizationOf'].append([group, dept])
+        tables['typeOf'].append([dept, 'department'])
+        tables['typeOf'].append([univ, 'university'])
+        nprofs = 10
+        for p in range(nprofs):
+            prof = 'prof%d_%d' % (d, p)
+            tables['worksFor'].append([prof, group if p % 2 else dept])
+            tables['typeOf'].append([prof, 'fullProfessor' if p < 3
+                                     else 'assistantProfessor'])
+            course = 'course%d_%d' % (d, p)
+            tables['teacherOf'].append([prof, course])
+            tables['typeOf'].append([course, 'course'])
+        tables['headOf'].append(['prof%d_0' % d, dept])
+        for s in range(scale // ndepts):
+            student = 'student%d_%d' % (d, s)
+            tables['memberOf'].append([student, dept])
+            tables['typeOf'].append([student, 'undergraduateStudent'
+                                     if s % 4 else 'graduateStudent'])
+            tables['advisor'].append([student,
+                                      'prof%d_%d' % (d, rnd.randrange(nprofs))])
+            for c in rnd.sample(range(nprofs), 3):
+                tables['takesCourse'].append([student,
+                                              'course%d_%d' % (d, c)])
+    rules = [
+        'Department(X) :- typeOf(X,department)',
+        'University(X) :- typeOf(X,university)',
+        'Course(X) :- typeOf(X,course)',
+        'FullProfessor(X) :- typeOf(X,fullProfessor)',
+        'AssistantProfessor(X) :- typeOf(X,assistantProfessor)',
+        'GraduateStudent(X) :- typeOf(X,graduateStudent)',
+        'UndergraduateStudent(X) :- typeOf(X,undergraduateStudent)',
+        'Professor(X) :- FullProfessor(X)',
+        'Professor(X) :- AssistantProfessor(X)',
+        'Faculty(X) :- Professor(X)',
+        'Student(X) :- GraduateStudent(X)',
+        'Student(X) :- UndergraduateStudent(X)',
+        'Person(X) :- Faculty(X)',
+        'Person(X) :- Student(X)',
+        'Organization(X) :- Department(X)',
+        'Organization(X) :- University(X)',
+        'subOrg(X,Y) :- subOrganizationOf(X,Y)',
+        'subOrg(X,Z) :- subOrg(X,Y), subOrganizationOf(Y,Z)',
+        'member(X,Y) :- memberOf(X,Y)',
+        'member(X,Y) :- worksFor(X,Y)',
+        'member(X,Z) :- member(X,Y), subOrg(Y,Z)',
+        'Chair(X) :- headOf(X,Y), Department(Y)',
+        'Student(X) :- takesCourse(X,Y), Course(Y)',
+        'advisedBy(X,Z) :- advisor(X,Y), teacherOf(Y,C), takesCourse(X,C), member(Y,Z)',
+        'Employee(X) :- worksFor(X,Y), Organization(Y)',
+    ]
+    return tables, rules
+
+
+# A chain of rules that follows the edges of a graph where each node has
+# one successor, so every rule adds the same number of facts
+def genChain(scale, rnd, depth=10):
+    nodes = list(range(scale))
+    rnd.shuffle(nodes)
+    edges = [['n%d' % nodes[i], 'n%d' % nodes[(i + 1) % scale]]
+             for i in range(scale)]
+    rules = ['P0(X,Y) :- E(X,Y)']
+    for i in range(depth):
+        rules.append('P%d(X,Z) :- P%d(X,Y), E(Y,Z)' % (i + 1, i))
+    return {'E': edges}, rules
+
+
+# Transitive closure of a forest of trees with bounded depth, so that the
+# size of the closure grows linearly with the scale
+def genTC(scale, rnd, fanout=3, treesize=200):
+    edges = []
+    for i in range(scale):
+        if i % treesize == 0:
+            continue
+        root = i - i % treesize
+        parent = root + (i - root - 1) // fanout
+        edges.append(['n%d' % parent, 'n%d' % i])
+    rnd.shuffle(edges)
+    rules = [
+        'TC(X,Y) :- E(X,Y)',
+        'TC(X,Z) :- TC(X,Y), E(Y,Z)',
+    ]
+    return {'E': edges}, rules
+
+
+# Rules whose heads introduce fresh values. The existential rules are
+# acyclic, so all the chase procedures terminate
+def genExistential(scale, rnd):
+    people = [['p%d' % i] for i in range(scale)]
+    knows = [['p%d' % i, 'p%d' % rnd.randrange(scale)] for i in range(scale)]
+    rules = [
+        'Person(X) :- person(X)',
+        'hasAddress(X,Y) :- Person(X)',
+        'Address(Y) :- hasAddress(X,Y)',
+        'inCity(Y,Z) :- Address(Y)',
+        'City(Z) :- inCity(Y,Z)',
+        'livesIn(X,Z) :- hasAddress(X,Y), inCity(Y,Z)',
+        'hasEmployer(X,Y) :- Person(X)',
+        'Company(Y) :- hasEmployer(X,Y)',
+        'colleague(X,Z) :- knows(X,Z), hasEmployer(X,Y)',
+        'related(X,Z) :- colleague(X,Z)',
+        'related(X,Z) :- related(X,Y), knows(Y,Z)',
+    ]
+    return {'person': people, 'knows': knows}, rules
+
+
+GENERATORS = {
+    'lubm': genLUBM,
+    'chain': genChain,
+    'tc': genTC,
+    'existential': genExistential,
+}
+
+PATTERNS = {
+    'runtime': re.compile(r'Runtime materialization = ([0-9.e+]+) milliseconds'),
+    'derived': re.compile(r'(?:Derived tuples = |Total # derivations: )([0-9]+)'),
+    'nodes': re.compile(r'N\. nodes = ([0-9]+)'),
+    'triggers': re.compile(r'Triggers = ([0-9]+)'),
+}
+
+
+def parseLog(log):
+    result = {}
+    for key, pattern in PATTERNS.items():
+        matches = pattern.findall(log)
+        if matches:
+            value = matches[-1]
+            result[key] = float(value) if key == 'runtime' else int(value)
+    return result
+
+
+def runGLog(glog, cmd, kbdir, nthreads):
+    args = [os.path.abspath(glog), cmd, '--edb', 'edb.conf', '--rules',
+            'rules.dlog', '--logLevel', 'info']
+    if nthreads > 1:
+        args += ['--nthreads', str(nthreads), '--multithreaded', '1']
+    logpath = os.path.join(kbdir, cmd + '.log')
+    # The paths in edb.conf are relative to the folder of the KB
+    with open(logpath, 'wt') as log:
+        start = time.time()
+        proc = subprocess.Popen(args, cwd=kbdir, stdout=log,
+                                stderr=subprocess.STDOUT)
+        try:
+            # wait4 returns the resource usage of this run only
+            _, status, usage = os.wait4(proc.pid, 0)
+            proc.returncode = status
+        except KeyboardInterrupt:
+            proc.kill()
+            raise
+        wallclock = (time.time() - start) * 1000
+    with open(logpath, 'rt') as log:
+        result = parseLog(log.read())
+    result['wallclock'] = wallclock
+    # ru_maxrss is in KB on Linux
+    result['peakrss_mb'] = usage.ru_maxrss / 1024.0
+    result['exitcode'] = os.waitstatus_to_exitcode(status) \
+        if hasattr(os, 'waitstatus_to_exitcode') else status
+    return result
+
+
+def compare(old, new, tolerance):
+    ok = True
+    oldruns = {(r['kb'], r['command']): r for r in old['runs']}
+    for run in new['runs']:
+        key = (run['kb'], run['command'])
+        if key not in oldruns:
+            continue
+        prev = oldruns[key]
+        if prev.get('derived') != run.get('derived'):
+            print('%s/%s: derived facts changed from %s to %s' %
+                  (key[0], key[1], prev.get('derived'), run.get('derived')))
+            ok = False
+        if 'runtime' in prev and 'runtime' in run and \
+                run['runtime'] > prev['runtime'] * (1 + tolerance):
+            print('%s/%s: runtime increased from %.1f to %.1f ms' %
+                  (key[0], key[1], prev['runtime'], run['runtime']))
+            ok = False
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark GLog on synthetic KBs')
+    parser.add_argument('--glog', required=True, help='path of the glog binary')
+    parser.add_argument('--workdir', default='bench_kbs',
+                        help='folder where the KBs are generated')
+    parser.add_argument('--scale', type=int, default=10000,
+                        help='size of the generated KBs')
+    parser.add_argument('--seed', type=int, default=42)
+    parser.add_argument('--kbs', default=','.join(KBS),
+                        help='comma-separated list among ' + ','.join(KBS))
+    parser.add_argument('--commands', default=','.join(COMMANDS),
+                        help='comma-separated list among ' + ','.join(COMMANDS))
+    parser.add_argument('--nthreads', type=int, default=1)
+    parser.add_argument('--reps', type=int, default=1,
+                        help='repetitions of each run; the fastest is kept')
+    parser.add_argument('--out', default='-', help='JSON file with the results')
+    parser.add_argument('--compare', help='JSON file of a previous run')
+    parser.add_argument('--tolerance', type=float, default=0.2,
+                        help='allowed relative increase of the runtime')
+    args = parser.parse_args()
+
+    results = {'scale': args.scale, 'seed': args.seed,
+               'nthreads': args.nthreads, 'runs': []}
+    for kb in args.kbs.split(','):
+        if kb not in GENERATORS:
+            print('Unknown KB ' + kb, file=sys.stderr)
+            return 1
+        kbdir = os.path.join(args.workdir, '%s_%d' % (kb, args.scale))
+        tables, rules = GENERATORS[kb](args.scale, random.Random(args.seed))
+        writeKB(kbdir, tables, rules)
+        for cmd in args.commands.split(','):
+            if cmd not in COMMANDS:
+                print('Unknown command ' + cmd, file=sys.stderr)
+                return 1
+            best = None
+            for _ in range(args.reps):
+                run = runGLog(args.glog, cmd, kbdir, args.nthreads)
+                if best is None or run.get('runtime', run['wallclock']) < \
+                        best.get('runtime', best['wallclock']):
+                    best = run
+            best['kb'] = kb
+            best['command'] = cmd
+            best['edbfacts'] = sum(len(t) for t in tables.values())
+            print('%s/%s: %s' % (kb, cmd, json.dumps(best)), file=sys.stderr)
+            results['runs'].append(best)
+
+    if args.out == '-':
+        json.dump(results, sys.stdout, indent=2)
+        print()
+    else:
+        with open(args.out, 'wt') as out:
+            json.dump(results, out, indent=2)
+
+    failed = any(r['exitcode'] != 0 for r in results['runs'])
+    if args.compare:
+        with open(args.compare, 'rt') as f:
+            if not compare(json.load(f), results, args.tolerance):
+                failed = True
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,439 @@
+//Micro-benchmarks of the kernels used by GLog: the operations on TGSegment,
+//the removal of duplicates in GBSegmentInserter, the joins of GBRuleExecutor
+//and the operations of GBGraph. The data is synthetic: terms are drawn from a
+//Zipf distribution, so that the skew of the join keys can be controlled.
+
+#include <vlog/edb.h>
+#include <vlog/edbconf.h>
+#include <vlog/concepts.h>
+
+#include <glog/gbgraph.h>
+#include <glog/gbruleexecutor.h>
+#include <glog/gbsegmentinserter.h>
+#include <glog/gbsegmentcache.h>
+
+#include <kognac/logs.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+struct BenchOptions {
+    size_t nrows;
+    size_t domain; //n. of distinct terms
+    uint8_t arity;
+    double skew; //0 = uniform
+    GBGraph::ProvenanceType provenance;
+    size_t nnodes; //n. of nodes in the graph for retain/mergeNodes
+    size_t reps;
+    uint64_t seed;
+    std::string filter;
+
+    BenchOptions() : nrows(1000000), domain(0), arity(2), skew(0),
+    provenance(GBGraph::ProvenanceType::NOPROV), nnodes(8), reps(5),
+    seed(42) {
+    }
+};
+
+//Draws values in [1, domain] with probability proportional to 1/rank^skew
+class ZipfGenerator {
+    private:
+        std::vector<double> cdf;
+        std::mt19937_64 gen;
+        std::uniform_real_distribution<double> dist;
+
+    public:
+        ZipfGenerator(size_t domain, double skew, uint64_t seed) :
+            cdf(domain), gen(seed), dist(0.0, 1.0) {
+                double sum = 0;
+                for(size_t i = 0; i < domain; ++i) {
+                    sum += 1.0 / std::pow((double)(i + 1), skew);
+                    cdf[i] = sum;
+                }
+                for(auto &v : cdf) {
+                    v /= sum;
+                }
+            }
+
+        Term_t next() {
+            auto itr = std::lower_bound(cdf.begin(), cdf.end(), dist(gen));
+            if (itr == cdf.end())
+                return cdf.size();
+            return (itr - cdf.begin()) + 1;
+        }
+};
+
+//Uses the private join methods of GBRuleExecutor
+class GBBenchmarks {
+    private:
+        const BenchOptions &opts;
+        ZipfGenerator zipf;
+
+        EDBConf conf;
+        EDBLayer layer;
+        Program program;
+        std::vector<Term_t> edbTermIds; //synthetic term -> ID in layer
+        PredId_t edbPredId;
+        Literal edbLiteral;
+
+        size_t nResults;
+
+        SegProvenanceType getSegProvenanceType() const {
+            return opts.provenance == GBGraph::ProvenanceType::NOPROV ?
+                SEG_NOPROV : SEG_SAMENODE;
+        }
+
+        std::vector<Term_t> generate(size_t nrows, uint8_t arity) {
+            std::vector<Term_t> rows(nrows * arity);
+            for(auto &v : rows) {
+                v = zipf.next();
+            }
+            return rows;
+        }
+
+        //The right side of nestedloopjoin must be an EDB relation. Its
+        //terms are strings, so the IDs are not the synthetic terms
+        PredId_t addEDBRelation() {
+            std::vector<std::vector<std::string>> rows;
+            auto tuples = generate(opts.nrows, 2);
+            for(size_t i = 0; i < tuples.size(); i += 2) {
+                std::vector<std::string> row;
+                row.push_back(std::to_string(tuples[i]));
+                row.push_back(std::to_string(tuples[i + 1]));
+                rows.push_back(row);
+            }
+            layer.addInmemoryTable("bench_edb", rows);
+            //Terms that do not appear in the relation get a fresh ID
+            std::vector<std::string> terms;
+            for(size_t i = 0; i <= opts.domain; ++i) {
+                terms.push_back(std::to_string(i));
+            }
+            layer.getOrAddDictNumbers(terms, edbTermIds);
+            return layer.getPredID("bench_edb");
+        }
+
+        static VTuple getEDBTuple() {
+            VTuple t(2);
+            t.set(VTerm(1, 0), 0);
+            t.set(VTerm(2, 0), 1);
+            return t;
+        }
+
+        std::shared_ptr<const TGSegment> toSegment(
+                const std::vector<Term_t> &rows, uint8_t arity,
+                size_t nodeId) {
+            auto inserter = GBSegmentInserter::getInserter(arity, 0, false);
+            std::vector<Term_t> row(arity);
+            for(size_t i = 0; i < rows.size(); i += arity) {
+                std::copy(rows.begin() + i, rows.begin() + i + arity,
+                        row.begin());
+                inserter->add(row.data());
+            }
+            return inserter->getSegment(nodeId, false, 0,
+                    getSegProvenanceType());
+        }
+
+        std::shared_ptr<const TGSegment> generateSegment(size_t nrows,
+                uint8_t arity, size_t nodeId) {
+            return toSegment(generate(nrows, arity), arity, nodeId);
+        }
+
+        //Output of the joins. With provenance, the two nodes are appended
+        std::unique_ptr<GBSegmentInserter> getJoinOutput(size_t nvars) {
+            size_t extraColumns = opts.provenance ==
+                GBGraph::ProvenanceType::NOPROV ? 0 : 2;
+            return GBSegmentInserter::getInserter(nvars + extraColumns,
+                    extraColumns, true);
+        }
+
+        //Adds nnodes nodes to g, splitting the rows among them
+        std::vector<size_t> populateGraph(GBGraph &g, PredId_t predId,
+                size_t nrows) {
+            const size_t nnodes = std::max(opts.nnodes, (size_t) 1);
+            for(size_t i = 0; i < nnodes; ++i) {
+                auto seg = generateSegment(nrows / nnodes, opts.arity,
+                        g.getNNodes())->sort()->unique();
+                if (opts.provenance == GBGraph::ProvenanceType::NOPROV) {
+                    g.addNodeNoProv(predId, 0, i, seg);
+                } else {
+                    std::vector<size_t> incomingEdges;
+                    g.addNodeProv(predId, 0, i, seg, incomingEdges);
+                }
+            }
+            return g.getNodeIDsWithPredicate(predId);
+        }
+
+        bool isSelected(const std::string &name) const {
+            return opts.filter.empty() ||
+                name.find(opts.filter) != std::string::npos;
+        }
+
+        //Runs fn opts.reps times and prints min and median time. fn returns
+        //the n. of output rows, which is printed to check the results
+        void run(const std::string &name, size_t inputRows,
+                std::function<size_t()> fn) {
+            if (!isSelected(name))
+                return;
+            std::vector<double> times;
+            size_t outputRows = 0;
+            for(size_t i = 0; i < std::max(opts.reps, (size_t) 1); ++i) {
+                SegmentCache::getInstance().clear();
+                std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+                outputRows = fn();
+                std::chrono::duration<double, std::milli> dur =
+                    std::chrono::steady_clock::now() - start;
+                times.push_back(dur.count());
+            }
+            std::sort(times.begin(), times.end());
+            const double median = times[times.size() / 2];
+            std::cout << std::left << std::setw(36) << name << std::right <<
+                std::setw(12) << inputRows <<
+                std::setw(12) << outputRows <<
+                std::setw(12) << std::fixed << std::setprecision(3) <<
+                times[0] << std::setw(12) << median <<
+                std::setw(12) << std::setprecision(1) <<
+                (median > 0 ? inputRows / median / 1000 : 0) << std::endl;
+            nResults++;
+        }
+
+    public:
+        GBBenchmarks(const BenchOptions &opts) : opts(opts),
+        zipf(opts.domain, opts.skew, opts.seed),
+        conf("", false), layer(conf, false), program(&layer),
+        edbPredId(addEDBRelation()),
+        edbLiteral(Predicate(edbPredId, 0, EDB, 2), getEDBTuple()),
+        nResults(0) {
+        }
+
+        size_t getNResults() const {
+            return nResults;
+        }
+
+        void segments() {
+            auto seg = generateSegment(opts.nrows, opts.arity, 0);
+            std::vector<uint8_t> fields;
+            for(uint8_t i = 0; i < opts.arity; ++i) {
+                fields.push_back(opts.arity - 1 - i);
+            }
+            run("TGSegment::sortBy", seg->getNRows(), [&]() {
+                    return seg->sortBy(fields)->getNRows();
+                    });
+            run("TGSegment::sort", seg->getNRows(), [&]() {
+                    return seg->sort()->getNRows();
+                    });
+            auto sorted = seg->sort();
+            run("TGSegment::unique", sorted->getNRows(), [&]() {
+                    return sorted->unique()->getNRows();
+                    });
+            std::vector<int> posFields;
+            for(uint8_t i = 0; i < opts.arity; ++i) {
+                posFields.push_back(i);
+            }
+            run("TGSegment::appendTo", seg->getNRows(), [&]() {
+                    std::vector<std::vector<Term_t>> out(opts.arity);
+                    seg->appendTo(posFields, out);
+                    return out[0].size();
+                    });
+        }
+
+        void inserter() {
+            auto rows = generate(opts.nrows, opts.arity);
+            run("GBSegmentInserter::add+unique", opts.nrows, [&]() {
+                    auto inserter = GBSegmentInserter::getInserter(opts.arity,
+                            0, true);
+                    for(size_t i = 0; i < rows.size(); i += opts.arity) {
+                        inserter->add(&rows[i]);
+                    }
+                    return inserter->getSegment(0, false, 0,
+                            getSegProvenanceType())->sort()->unique()->
+                        getNRows();
+                    });
+        }
+
+        void joins() {
+            GBGraph g(opts.provenance, false);
+            GBRuleExecutor executor(g, layer, &program);
+            //R(X,Y),S(Y,Z)
+            auto leftRows = generate(opts.nrows, 2);
+            auto left = toSegment(leftRows, 2, 0);
+            for(size_t i = 1; i < leftRows.size(); i += 2) {
+                leftRows[i] = edbTermIds[leftRows[i]];
+            }
+            auto leftEDB = toSegment(leftRows, 2, 0);
+            auto right = generateSegment(opts.nrows, 2, 1);
+            auto unary = generateSegment(opts.nrows, 1, 2);
+            const size_t inputRows = left->getNRows() + right->getNRows();
+            std::vector<size_t> nodesLeft;
+            std::vector<size_t> nodesRight;
+            std::vector<std::pair<int, int>> joinVarPos;
+            joinVarPos.push_back(std::make_pair(1, 0));
+            std::vector<int> copyVarPosLeft;
+            copyVarPosLeft.push_back(0);
+            std::vector<int> copyVarPosRight;
+            copyVarPosRight.push_back(1);
+
+            run("GBRuleExecutor::mergejoin", inputRows, [&]() {
+                    auto output = getJoinOutput(2);
+                    executor.mergejoin(false, false, left, nodesLeft, right,
+                            nodesRight, joinVarPos, copyVarPosLeft,
+                            copyVarPosRight, output);
+                    return output->getNRows();
+                    });
+            run("GBRuleExecutor::hashjoin", inputRows, [&]() {
+                    auto output = getJoinOutput(2);
+                    executor.hashjoin(left, right, joinVarPos, copyVarPosLeft,
+                            copyVarPosRight, output);
+                    return output->getNRows();
+                    });
+            run("GBRuleExecutor::nestedloopjoin", left->getNRows(), [&]() {
+                    auto output = getJoinOutput(2);
+                    executor.nestedloopjoin(false, false, leftEDB, nodesLeft,
+                            NULL, nodesRight, edbLiteral, joinVarPos,
+                            copyVarPosLeft, copyVarPosRight, output);
+                    return output->getNRows();
+                    });
+            //R(X,Y),U(Y)
+            run("GBRuleExecutor::joinTwoOne", left->getNRows() +
+                    unary->getNRows(), [&]() {
+                    std::unique_ptr<GBSegmentInserter> output =
+                    GBSegmentInserter::getInserter(1, 0, true);
+                    executor.joinTwoOne(false, false, left, unary, 1,
+                            copyVarPosLeft, 0, output);
+                    return output->getNRows();
+                    });
+        }
+
+        void graph() {
+            GBGraph g(opts.provenance, false);
+            const PredId_t predId = edbPredId + 1;
+            auto nodeIdxs = populateGraph(g, predId, opts.nrows);
+            auto newtuples = generateSegment(opts.nrows, opts.arity,
+                    g.getNNodes())->sort()->unique();
+            run("GBGraph::retain", newtuples->getNRows(), [&]() {
+                    std::vector<std::shared_ptr<Column>> derivationNodes;
+                    auto retained = g.retain(predId, newtuples,
+                            derivationNodes);
+                    return retained == NULL ? 0 : retained->getNRows();
+                    });
+            std::vector<int> copyVarPos;
+            for(uint8_t i = 0; i < opts.arity; ++i) {
+                copyVarPos.push_back(i);
+            }
+            size_t inputRows = 0;
+            for(auto nodeId : nodeIdxs) {
+                inputRows += g.getNodeSize(nodeId);
+            }
+            run("GBGraph::mergeNodes", inputRows, [&]() {
+                    return g.mergeNodes(nodeIdxs, copyVarPos)->getNRows();
+                    });
+        }
+};
+
+void printHelp(const char *programName) {
+    std::cout << "Usage: " << programName << " [options]" << std::endl <<
+        std::endl;
+    std::cout << "  --rows N      n. of rows of each input (default: 1000000)"
+        << std::endl;
+    std::cout << "  --domain N    n. of distinct terms (default: rows/10)" <<
+        std::endl;
+    std::cout << "  --arity N     arity of the segments, 1-3 (default: 2)" <<
+        std::endl;
+    std::cout << "  --skew S      Zipf exponent of the terms, 0 is uniform "
+        "(default: 0)" << std::endl;
+    std::cout << "  --prov P      provenance: noprov or nodeprov (default: "
+        "noprov)" << std::endl;
+    std::cout << "  --nodes N     n. of nodes for retain/mergeNodes "
+        "(default: 8)" << std::endl;
+    std::cout << "  --reps N      repetitions of each benchmark (default: 5)"
+        << std::endl;
+    std::cout << "  --seed N      seed of the generator (default: 42)" <<
+        std::endl;
+    std::cout << "  --filter S    run only the benchmarks whose name contains "
+        "S" << std::endl;
+}
+
+int main(int argc, const char** argv) {
+    BenchOptions opts;
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printHelp(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--rows") {
+            opts.nrows = std::stoull(value);
+        } else if (arg == "--domain") {
+            opts.domain = std::stoull(value);
+        } else if (arg == "--arity") {
+            opts.arity = std::stoi(value);
+        } else if (arg == "--skew") {
+            opts.skew = std::stod(value);
+        } else if (arg == "--prov") {
+            if (value == "noprov") {
+                opts.provenance = GBGraph::ProvenanceType::NOPROV;
+            } else if (value == "nodeprov") {
+                opts.provenance = GBGraph::ProvenanceType::NODEPROV;
+            } else {
+                //GBSegmentInserter cannot create segments with full
+                //provenance out of plain tuples
+                std::cerr << "Provenance " << value << " not supported" <<
+                    std::endl;
+                return 1;
+            }
+        } else if (arg == "--nodes") {
+            opts.nnodes = std::stoull(value);
+        } else if (arg == "--reps") {
+            opts.reps = std::stoull(value);
+        } else if (arg == "--seed") {
+            opts.seed = std::stoull(value);
+        } else if (arg == "--filter") {
+            opts.filter = value;
+        } else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+    if (opts.arity < 1 || opts.arity > 3) {
+        std::cerr << "The arity must be between 1 and 3" << std::endl;
+        return 1;
+    }
+    if (opts.domain == 0) {
+        opts.domain = std::max(opts.nrows / 10, (size_t) 1);
+    }
+    Logger::setMinLevel(WARNL);
+
+    std::cout << "rows=" << opts.nrows << " domain=" << opts.domain <<
+        " arity=" << (int) opts.arity << " skew=" << opts.skew <<
+        " prov=" << (opts.provenance == GBGraph::ProvenanceType::NOPROV ?
+                "noprov" : "nodeprov") << " reps=" << opts.reps << std::endl;
+    std::cout << std::left << std::setw(36) << "Benchmark" << std::right <<
+        std::setw(12) << "Input" << std::setw(12) << "Output" <<
+        std::setw(12) << "Min(ms)" << std::setw(12) << "Median(ms)" <<
+        std::setw(12) << "Krows/ms" << std::endl;
+
+    GBBenchmarks bench(opts);
+    bench.segments();
+    bench.inserter();
+    bench.joins();
+    bench.graph();
+    if (bench.getNResults() == 0) {
+        std::cerr << "No benchmark matches " << opts.filter << std::endl;
+        return 1;
+    }
+    return 0;
+}
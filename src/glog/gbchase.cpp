@@ -1,8 +1,12 @@
 #include <glog/gbchase.h>
 #include <glog/gbsegmentcache.h>
+#include <glog/gbsegmentspilled.h>
 #include <glog/gbquerier.h>
 
 #include <unordered_set>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 GBChase::GBChase(EDBLayer &layer, Program *program, bool useCacheRetain,
         GBGraph::ProvenanceType provenanceType,
@@ -18,6 +22,11 @@ GBChase::GBChase(EDBLayer &layer, Program *program, bool useCacheRetain,
     g(provenanceType, useCacheRetain, filterQueryCont, duplAllowed),
     triggers(0),
     durationRuleExec(0),
+    nthreads(1),
+    compressNodes(false),
+    memoryBudget(0),
+    segmentCacheMaxSize(0),
+    spillColdSteps(SPILLSEGMENT_DEFAULT_COLDSTEPS),
     currentIteration(0),
     startStep(0),
     maxStep(~0ul),
@@ -275,10 +284,17 @@ void GBChase::prepareRuleExecutionPlans_SNE(
                 }
             }
             if (canCheck) {
+                std::chrono::system_clock::time_point startQC =
+                    std::chrono::system_clock::now();
                 prepareRuleExecutionPlans_queryContainment(newnodes,
                         acceptableNodes,
                         ruleIdx,
                         step);
+                if (shouldStoreStats()) {
+                    saveSpan("query containment " + std::to_string(ruleIdx),
+                            "querycontainment", startQC,
+                            std::chrono::system_clock::now());
+                }
             } else {
                 newnodes.emplace_back();
                 GBRuleInput &newnode = newnodes.back();
@@ -490,8 +506,26 @@ size_t GBChase::executeRulesInStratum(
     auto nodesToProcess = newnodes.size();
 
     LOG(INFOL) << "Nodes to process " << nodesToProcess;
-    for(size_t idxNode = 0; idxNode < nodesToProcess; ++idxNode) {
+    size_t idxNode = 0;
+    while (idxNode < nodesToProcess) {
+        if (nthreads > 1 && isParallelizable(newnodes[idxNode])) {
+            //Collect consecutive plans that can be executed in parallel. The
+            //size of the window is bounded to limit the number of derivations
+            //kept in memory before they are added to the graph
+            size_t endWindow = idxNode + 1;
+            while (endWindow < nodesToProcess &&
+                    endWindow - idxNode < nthreads * GBCHASE_PARALLEL_WINDOW &&
+                    isParallelizable(newnodes[endWindow])) {
+                endWindow++;
+            }
+            if (endWindow - idxNode > 1) {
+                executeRulesInParallel(newnodes, idxNode, endWindow);
+                idxNode = endWindow;
+                continue;
+            }
+        }
         executeRule(newnodes[idxNode]);
+        idxNode++;
     }
 
     //Retain all the predicates that should be cleaned at the end
@@ -524,6 +558,7 @@ void GBChase::run() {
     initRun();
     size_t nnodes = 0;
     size_t step = startStep;
+    segmentCacheMaxSize = SegmentCache::getInstance().getMaxSize();
 
     //Mark the predicates that should be cleaned at the end
     for (auto &predId : program->getAllPredicateIDs()) {
@@ -557,8 +592,25 @@ void GBChase::run() {
             currentIteration = step;
             g.cleanTmpNodes();
             nnodes = g.getNNodes();
+            std::chrono::system_clock::time_point startStep =
+                std::chrono::system_clock::now();
             size_t derivedTuples = executeRulesInStratum(rulesInStratum,
                     currentStrat, stepStratum, step);
+            if (shouldStoreStats()) {
+                saveSpan("step " + std::to_string(step), "step", startStep,
+                        std::chrono::system_clock::now());
+            }
+            if (compressNodes) {
+                //The nodes of the previous steps are read only by merge
+                //joins and retain from now on
+                g.compressNodes(step, nthreads);
+            }
+            if (g.isSpillEnabled()) {
+                g.spillNodes(step, spillColdSteps);
+            }
+            if (memoryBudget > 0) {
+                checkMemoryBudget(step);
+            }
         } while (g.getNNodes() != nnodes);
         g.cleanTmpNodes();
     }
@@ -570,7 +622,13 @@ void GBChase::run() {
     LOG(INFOL) << "Runtime chase: " << dur.count();
 
     layer.clearContext();
+    SegmentCache::getInstance().printStats();
     SegmentCache::getInstance().clear();
+    SegmentCache::getInstance().setMaxSize(segmentCacheMaxSize);
+    for (auto &worker : workers) {
+        executor->addStats(*worker.get());
+    }
+    workers.clear();
     executor->printStats();
     LOG(INFOL) << "(GBChase) Time stratum preparation (ms): " << durationPreparation.count();
     LOG(INFOL) << "(GBChase) Time rule exec (ms): " << durationRuleExec.count();
@@ -583,6 +641,60 @@ void GBChase::run() {
       auto out = q.getDerivationTree(0, 0);*/
 }
 
+size_t GBChase::getMemoryUsage() const {
+    return g.getSizeNodes() + g.getSizeTmpNodes() + g.getSizeCacheRetain() +
+        SegmentCache::getInstance().getSize();
+}
+
+void GBChase::printMemoryUsage() const {
+    LOG(INFOL) << "Memory (MB): nodes=" << g.getSizeNodes() / 1024 / 1024 <<
+        " tmpnodes=" << g.getSizeTmpNodes() / 1024 / 1024 <<
+        " cacheretain=" << g.getSizeCacheRetain() / 1024 / 1024 <<
+        " segmentcache=" << SegmentCache::getInstance().getSize() / 1024 / 1024 <<
+        " budget=" << memoryBudget / 1024 / 1024;
+}
+
+void GBChase::checkMemoryBudget(size_t step) {
+    auto &cache = SegmentCache::getInstance();
+    size_t sizeGraph = g.getSizeNodes() + g.getSizeTmpNodes() +
+        g.getSizeCacheRetain();
+    if (sizeGraph > memoryBudget * GBCHASE_MEMBUDGET_COMPRESS_RATIO) {
+        g.compressNodes(step, nthreads);
+        sizeGraph = g.getSizeNodes() + g.getSizeTmpNodes() +
+            g.getSizeCacheRetain();
+    }
+    if (sizeGraph > memoryBudget) {
+        g.clearRestrictedCheckIndex();
+        sizeGraph = g.getSizeNodes() + g.getSizeTmpNodes() +
+            g.getSizeCacheRetain();
+    }
+    if (sizeGraph > memoryBudget && g.isSpillEnabled()) {
+        //Spill all the nodes except the ones derived in the last step
+        g.spillNodes(step, 1);
+        sizeGraph = g.getSizeNodes() + g.getSizeTmpNodes() +
+            g.getSizeCacheRetain();
+    }
+    //The cache can use what is left by the graph
+    size_t sizeCache = memoryBudget > sizeGraph ? memoryBudget - sizeGraph : 0;
+    sizeCache = std::min(sizeCache, segmentCacheMaxSize);
+    if (sizeCache != cache.getMaxSize()) {
+        cache.setMaxSize(sizeCache);
+    }
+    if (sizeGraph > memoryBudget) {
+        LOG(WARNL) << "The memory budget is exceeded at step " << step;
+        printMemoryUsage();
+    }
+}
+
+void GBChase::storeSnapshot(const std::string &path) const {
+    g.store(path);
+}
+
+void GBChase::loadSnapshot(const std::string &path) {
+    auto lastStepSnapshot = g.load(path);
+    prepareRun(lastStepSnapshot, maxStep);
+}
+
 size_t GBChase::getNDerivedFacts() {
     return g.getNDerivedFacts();
 }
@@ -608,12 +720,85 @@ bool GBChase::shouldRetainAtEnd(PredId_t pred) {
     return outcome;
 }
 
-bool GBChase::executeRule(GBRuleInput &node, bool cleanDuplicates) {
-    auto &bodyNodes = node.incomingEdges;
+bool GBChase::isParallelizable(const GBRuleInput &node) const {
+    const Rule &rule = rules[node.ruleIdx];
+    //The execution of existential rules and EGDs reads (and updates) parts of
+    //the graph that can be changed by the other rules of the same step
+    if (rule.isExistential() || rule.isEGD()) {
+        return false;
+    }
+    for (auto &bodyAtom : rule.getBody()) {
+        Predicate pred = bodyAtom.getPredicate();
+        if (pred.getType() != EDB ||
+                !layer.acceptQueriesWithFreeVariables(bodyAtom)) {
+            continue;
+        }
+        //Only EDB relations stored in segments can be read concurrently
+        if (layer.canChange(pred.getId())) {
+            return false;
+        }
+        auto table = layer.getEDBTable(pred.getId());
+        if (table == NULL || !table->useSegments()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GBChase::executeRulesInParallel(
+        std::vector<GBRuleInput> &nodes,
+        const size_t start,
+        const size_t end) {
+    const size_t nworkers = std::min(nthreads, end - start);
+    while (workers.size() < nworkers) {
+        workers.push_back(executor->createWorker());
+    }
+    LOG(DEBUGL) << "Executing " << (end - start) << " plans with " <<
+        nworkers << " threads";
+
+    //Each thread stores the derivations privately. They are added to the
+    //graph only after all threads are finished
+    std::vector<GBRuleExecution> executions(end - start);
+    std::atomic<size_t> nextNode(start);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nworkers; ++i) {
+        GBRuleExecutor *worker = workers[i].get();
+        threads.push_back(std::thread([&, worker, i]() {
+                    try {
+                        size_t idxNode;
+                        while ((idxNode = nextNode++) < end) {
+                            executions[idxNode - start].thread = i + 1;
+                            computeRuleExecution(*worker, nodes[idxNode],
+                                    executions[idxNode - start]);
+                        }
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        error = std::current_exception();
+                        nextNode = end;
+                    }
+                    }));
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    //Add the derivations following the order of the plans, so that the IDs
+    //of the new nodes are the same as in a sequential execution
+    for (size_t idxNode = start; idxNode < end; ++idxNode) {
+        commitRuleExecution(nodes[idxNode], executions[idxNode - start]);
+        executions[idxNode - start] = GBRuleExecution();
+    }
+}
+
+void GBChase::computeRuleExecution(GBRuleExecutor &e,
+        GBRuleInput &node,
+        GBRuleExecution &out) {
     Rule &rule = rules[node.ruleIdx];
-#ifdef WEBINTERFACE
-    currentRule = rule.tostring();
-#endif
 
 //#ifdef DEBUG
     LOG(DEBUGL) << "Execute rule " << node.ruleIdx << " " <<
@@ -622,17 +807,67 @@ bool GBChase::executeRule(GBRuleInput &node, bool cleanDuplicates) {
 
     std::chrono::system_clock::time_point start =
         std::chrono::system_clock::now();
+    out.start = start;
+    out.outputs = e.executeRule(rule, node);
+    out.durationExec = std::chrono::system_clock::now() - start;
+    out.durationFirst = e.getDuration(DurationType::DUR_FIRST);
+    out.durationMerge = e.getDuration(DurationType::DUR_MERGE);
+    out.durationJoin = e.getDuration(DurationType::DUR_JOIN);
+    out.durationHead = e.getDuration(DurationType::DUR_HEAD);
+    out.bdyAtoms = e.getStat(StatType::N_BDY_ATOMS);
+    out.stats = e.getLastStats();
+}
+
+void GBChase::fillStatsRule(StatsRule &stats, const GBRuleInput &node,
+        const GBRuleExecution &execution,
+        std::chrono::system_clock::time_point startRetain) {
+    stats.step = node.step;
+    stats.idRule = node.ruleIdx;
+    stats.timems_first = execution.durationFirst.count();
+    stats.timems_merge = execution.durationMerge.count();
+    stats.timems_join = execution.durationJoin.count();
+    stats.timems_createhead = execution.durationHead.count();
+    stats.timems_restricted = execution.stats.durationRestrictedCheck.count();
+    stats.nbdyatoms = execution.bdyAtoms;
+    stats.startms = getMsSinceStart(execution.start);
+    stats.startms_retain = getMsSinceStart(startRetain);
+    stats.thread = execution.thread;
+    stats.ninput = execution.stats.nInput;
+    stats.nintermediate = execution.stats.nIntermediate;
+    stats.nmergejoins = execution.stats.nMergeJoins;
+    stats.nhashjoins = execution.stats.nHashJoins;
+    stats.nsorts = execution.stats.nSorts;
+    stats.ncachehits = execution.stats.nCacheHits;
+    stats.outputbytes = 0;
+    for (const auto &output : execution.outputs) {
+        if (output.segment != NULL) {
+            stats.outputbytes += output.segment->getSizeInBytes();
+        }
+    }
+}
+
+bool GBChase::executeRule(GBRuleInput &node, bool cleanDuplicates) {
+    GBRuleExecution execution;
+    computeRuleExecution(*executor.get(), node, execution);
+    return commitRuleExecution(node, execution, cleanDuplicates);
+}
+
+bool GBChase::commitRuleExecution(GBRuleInput &node,
+        GBRuleExecution &execution,
+        bool cleanDuplicates) {
+    Rule &rule = rules[node.ruleIdx];
+#ifdef WEBINTERFACE
+    currentRule = rule.tostring();
+#endif
 
     size_t nders = 0;
     size_t nders_un = 0;
     auto &heads = rule.getHeads();
     int headIdx = 0;
     currentPredicate = heads[headIdx].getPredicate().getId();
-    auto outputsRule = executor->executeRule(rule, node);
+    auto &outputsRule = execution.outputs;
     bool nonempty = false;
-    std::chrono::duration<double, std::milli> execRuntime =
-        std::chrono::system_clock::now() - start;
-    durationRuleExec += execRuntime;
+    durationRuleExec += execution.durationExec;
 
     std::chrono::system_clock::time_point starth =
         std::chrono::system_clock::now();
@@ -656,6 +891,10 @@ bool GBChase::executeRule(GBRuleInput &node, bool cleanDuplicates) {
                 if (shouldCleanDuplicates && !node.retainFree) {
                     retainedTuples = g.retain(currentPredicate, derivations,
                             derivationNodes);
+                    if (g.areNodesWithPredicate(currentPredicate)) {
+                        g.releaseDecompressed(
+                                g.getNodeIDsWithPredicate(currentPredicate));
+                    }
                 } else {
                     retainedTuples = derivations;
                 }
@@ -685,20 +924,14 @@ bool GBChase::executeRule(GBRuleInput &node, bool cleanDuplicates) {
         std::chrono::duration<double, std::milli> retainRuntime =
             std::chrono::system_clock::now() - starth;
         std::chrono::duration<double, std::milli> totalRuntime =
-            std::chrono::system_clock::now() - start;
+            execution.durationExec + retainRuntime;
 
         StatsRule stats;
-        stats.step = node.step;
-        stats.idRule = node.ruleIdx;
+        fillStatsRule(stats, node, execution, starth);
         stats.nderivations_final = nders;
         stats.nderivations_unfiltered = nders_un;
         stats.timems = totalRuntime.count();
-        stats.timems_first = executor->getDuration(DurationType::DUR_FIRST).count();
-        stats.timems_merge = executor->getDuration(DurationType::DUR_MERGE).count();
-        stats.timems_join = executor->getDuration(DurationType::DUR_JOIN).count();
-        stats.timems_createhead = executor->getDuration(DurationType::DUR_HEAD).count();
         stats.timems_retain = retainRuntime.count();
-        stats.nbdyatoms = executor->getStat(StatType::N_BDY_ATOMS);
         saveStatistics(stats);
     }
 
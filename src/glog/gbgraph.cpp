@@ -3,6 +3,8 @@
 #include <glog/gbruleexecutor.h>
 #include <glog/gbcompositesegment.h>
 #include <glog/gbquerier.h>
+#include <glog/gbsegmentcompressed.h>
+#include <glog/gbsegmentspilled.h>
 
 #include <vlog/support.h>
 #include <vlog/concepts.h>
@@ -880,6 +882,12 @@ void GBGraph::replaceEqualTerms(
             if (cacheRetainEnabled && cacheRetain.count(predid)) {
                 cacheRetain.erase(cacheRetain.find(predid));
             }
+            auto itr = restrictedCheckIndex.lower_bound(std::make_pair(
+                        predid, std::vector<Term_t>()));
+            while (itr != restrictedCheckIndex.end() &&
+                    itr->first.first == predid) {
+                itr = restrictedCheckIndex.erase(itr);
+            }
             auto tuples = rewrittenTuples->getSegment(~0ul,
                     false,
                     0,
@@ -934,6 +942,148 @@ std::shared_ptr<GBQuerier> GBGraph::getQuerier() const {
     return std::shared_ptr<GBQuerier>(new GBQuerier(*this, *program, *layer));
 }
 
+void GBGraph::compressNodes(size_t maxStep, size_t nthreads) {
+    std::chrono::system_clock::time_point start =
+        std::chrono::system_clock::now();
+    std::vector<size_t> nodeIds;
+    size_t nreleased = 0;
+    for(size_t nodeId = 0; nodeId < nodes.size(); ++nodeId) {
+        const auto &n = nodes[nodeId];
+        const auto name = n.getData()->getName();
+        if (name == "TGSegmentCompressed") {
+            //Drop the copies decompressed during the last step
+            auto c = std::static_pointer_cast<const TGSegmentCompressed>(
+                    n.getData());
+            if (c->isDecompressed()) {
+                c->releaseDecompressed();
+                nreleased++;
+            }
+        }
+        if (n.step < maxStep && name != "TGSegmentCompressed" &&
+                name != "TGSegmentSpilled" &&
+                n.getData()->getNRows() >= COMPRSEGMENT_MIN_ROWS) {
+            nodeIds.push_back(nodeId);
+        }
+    }
+    //Each node is compressed independently
+    nthreads = std::max((size_t)1, std::min(nthreads, nodeIds.size()));
+    std::vector<size_t> sizesBefore(nodeIds.size());
+    std::vector<size_t> sizesAfter(nodeIds.size());
+    ParallelTasks::parallel_for(0, nthreads, 1,
+            [&](const ParallelRange &r) {
+        for(size_t i = r.begin(); i < nodeIds.size(); i += nthreads) {
+            auto &n = nodes[nodeIds[i]];
+            auto data = n.getData();
+            auto compressed = TGSegmentCompressed::compress(data);
+            sizesBefore[i] = data->getSizeInBytes();
+            sizesAfter[i] = compressed->getSizeInBytes();
+            n.setData(compressed);
+        }
+    });
+    for(size_t i = 0; i < nodeIds.size(); ++i) {
+        sizeNodesBeforeCompression += sizesBefore[i];
+        sizeNodesAfterCompression += sizesAfter[i];
+    }
+    durationCompressNodes += std::chrono::system_clock::now() - start;
+    LOG(DEBUGL) << "Compressed " << nodeIds.size() << " nodes, released " <<
+        nreleased << " decompressed copies";
+}
+
+void GBGraph::releaseDecompressed(const std::vector<size_t> &nodeIds) const {
+    for(auto nodeId : nodeIds) {
+        auto data = getNodeData(nodeId);
+        if (data->getName() == "TGSegmentCompressed") {
+            std::static_pointer_cast<const TGSegmentCompressed>(
+                    data)->releaseDecompressed();
+        }
+    }
+}
+
+void GBGraph::setSpillFile(const std::string &path) {
+    spillFile = std::shared_ptr<GBSpillFile>(new GBSpillFile(path));
+}
+
+void GBGraph::spillNodes(size_t step, size_t coldSteps) {
+    if (!isSpillEnabled()) {
+        LOG(ERRORL) << "The spill file is not set";
+        throw 10;
+    }
+    std::chrono::system_clock::time_point start =
+        std::chrono::system_clock::now();
+    size_t nspilled = 0;
+    size_t nreleased = 0;
+    for(auto &n : nodes) {
+        auto data = n.getData();
+        if (data->getName() == "TGSegmentSpilled") {
+            auto s = std::static_pointer_cast<TGSegmentSpilled>(
+                    std::const_pointer_cast<TGSegment>(data));
+            if (s->isCold(step, coldSteps) && s->isLoaded()) {
+                s->release();
+                nreleased++;
+            }
+        } else if (n.step + coldSteps <= step &&
+                data->getNRows() >= SPILLSEGMENT_MIN_ROWS &&
+                data->getName() != "CompositeTGSegment" &&
+                !data->hasColumnarBackend() &&
+                !data->containsMultipleProofs()) {
+            n.setData(std::shared_ptr<const TGSegment>(
+                        new TGSegmentSpilled(spillFile, data, step)));
+            nspilled++;
+        }
+    }
+    spillFile->map();
+    nSpilledNodes += nspilled;
+    nReleasedNodes += nreleased;
+    durationSpill += std::chrono::system_clock::now() - start;
+    LOG(DEBUGL) << "Spilled " << nspilled << " nodes, released " <<
+        nreleased << " nodes";
+}
+
+size_t GBGraph::getSizeSpillFile() const {
+    return spillFile ? spillFile->getSize() : 0;
+}
+
+size_t GBGraph::getSizeNodes() const {
+    size_t size = nodes.size() * sizeof(GBGraph_Node);
+    for(const auto &n : nodes) {
+        size += n.getData()->getSizeInBytes();
+        size += n.getIncomingEdges(false).size() * sizeof(size_t);
+    }
+    return size;
+}
+
+size_t GBGraph::getSizeTmpNodes() const {
+    size_t size = 0;
+    for(const auto &p : mapTmpNodes) {
+        size += sizeof(GBGraph_Node) + p.second.getData()->getSizeInBytes();
+    }
+    for(const auto &p : mapPredTmpNodes) {
+        for(const auto &n : p.second) {
+            size += sizeof(GBGraph_TmpPredNode) + n.data->getSizeInBytes();
+            for(const auto &c : n.nodes) {
+                if (c && c->isBackedByVector())
+                    size += c->size() * sizeof(Term_t);
+            }
+        }
+    }
+    return size;
+}
+
+size_t GBGraph::getSizeCacheRetain() const {
+    size_t size = 0;
+    for(const auto &p : cacheRetain) {
+        for(const auto &run : p.second.runs) {
+            size += run->getSizeInBytes();
+        }
+    }
+    for(const auto &p : restrictedCheckIndex) {
+        if (p.second.seg != NULL) {
+            size += p.second.seg->getSizeInBytes();
+        }
+    }
+    return size;
+}
+
 SegProvenanceType GBGraph::getSegProvenanceType(bool multipleNodes) const {
     if (provenanceType == ProvenanceType::NOPROV) {
         return SegProvenanceType::SEG_NOPROV;
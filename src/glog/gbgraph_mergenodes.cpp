@@ -130,7 +130,7 @@ std::shared_ptr<const TGSegment> GBGraph::mergeNodes_special_unary2(
                 }
 
                 if (shouldSortAndUnique) {
-                    std::sort(tuples.begin(), tuples.end());
+                    RadixSort::sort(tuples);
                     return std::shared_ptr<const TGSegment>(
                             new UnaryWithFullProvTGSegment(tuples, ~0ul,
                                 true, 0));
@@ -149,7 +149,7 @@ std::shared_ptr<const TGSegment> GBGraph::mergeNodes_special_unary2(
                 getNodeData(idbBodyAtomIdx)->appendTo(copyVarPos[0], tuples);
             }
             if (shouldSortAndUnique) {
-                std::sort(tuples.begin(), tuples.end());
+                RadixSort::sort(tuples);
                 if (removeDuplicates) {
                     auto itr = std::unique(tuples.begin(), tuples.end());
                     tuples.erase(itr, tuples.end());
@@ -166,7 +166,7 @@ std::shared_ptr<const TGSegment> GBGraph::mergeNodes_special_unary2(
         for(auto idbBodyAtomIdx : nodeIdxs)
             getNodeData(idbBodyAtomIdx)->appendTo(copyVarPos[0], tuples);
         if (shouldSortAndUnique) {
-            std::sort(tuples.begin(), tuples.end());
+            RadixSort::sort(tuples);
             if (removeDuplicates) {
                 auto itr = std::unique(tuples.begin(), tuples.end());
                 tuples.erase(itr, tuples.end());
@@ -292,7 +292,7 @@ std::shared_ptr<const TGSegment> GBGraph::mergeNodes(
                                 copyVarPos[0], copyVarPos[1], tuples);
                     }
                     if (shouldSortAndUnique) {
-                        std::sort(tuples.begin(), tuples.end());
+                        RadixSort::sort(tuples);
                         if (removeDuplicates) {
                             auto itr = std::unique(tuples.begin(), tuples.end());
                             tuples.erase(itr, tuples.end());
@@ -311,7 +311,7 @@ std::shared_ptr<const TGSegment> GBGraph::mergeNodes(
                             copyVarPos[0], copyVarPos[1], tuples);
                 }
                 if (shouldSortAndUnique) {
-                    std::sort(tuples.begin(), tuples.end());
+                    RadixSort::sort(tuples);
                     if (removeDuplicates) {
                         auto itr = std::unique(tuples.begin(), tuples.end());
                         tuples.erase(itr, tuples.end());
@@ -538,3 +538,46 @@ uint64_t GBGraph::mergeNodesWithPredicateIntoOne(PredId_t predId) {
     }
     return tuples->getNRows();
 }
+
+std::shared_ptr<const TGSegment> GBGraph::getRestrictedCheckIndex(
+        PredId_t predId,
+        const std::vector<Term_t> &filterConstants,
+        const std::vector<int> &copyVarPos) {
+    assert(copyVarPos.size() > 0);
+    std::vector<Term_t> key(filterConstants);
+    for(auto pos : copyVarPos) {
+        key.push_back(pos);
+    }
+    auto &entry = restrictedCheckIndex[std::make_pair(predId, key)];
+    const auto &nodeIdxs = getNodeIDsWithPredicate(predId);
+    if (entry.nnodes == nodeIdxs.size()) {
+        return entry.seg;
+    }
+
+    //Sort only the tuples of the new nodes and merge them with the others
+    std::vector<size_t> newNodeIdxs(nodeIdxs.begin() + entry.nnodes,
+            nodeIdxs.end());
+    auto merged = mergeNodes(newNodeIdxs, filterConstants, copyVarPos);
+    const size_t ncols = copyVarPos.size();
+    std::vector<int> posFields;
+    for(int i = 0; i < ncols; ++i)
+        posFields.push_back(i);
+    std::vector<std::vector<Term_t>> tuples(ncols);
+    merged->appendTo(posFields, tuples);
+    const size_t nrows = tuples[0].size();
+    std::vector<std::shared_ptr<Column>> columns;
+    for(int i = 0; i < ncols; ++i) {
+        columns.push_back(std::shared_ptr<Column>(
+                    new InmemoryColumn(tuples[i], true)));
+    }
+    std::shared_ptr<const TGSegment> delta(new TGSegmentLegacy(columns,
+                nrows));
+    delta = delta->sort()->unique();
+    if (entry.seg == NULL) {
+        entry.seg = delta;
+    } else if (!delta->isEmpty()) {
+        entry.seg = mergeSortedSegments(entry.seg, delta, true);
+    }
+    entry.nnodes = nodeIdxs.size();
+    return entry.seg;
+}
@@ -358,6 +358,158 @@ std::shared_ptr<const TGSegment> GBGraph::retainFromDerivationTree_slow(
     return out;
 }
 
+std::shared_ptr<const TGSegment> GBGraph::mergeSortedSegments(
+        std::shared_ptr<const TGSegment> seg1,
+        std::shared_ptr<const TGSegment> seg2,
+        bool removeDuplicates) {
+    const size_t ncolumns = seg1->getNColumns();
+    if (ncolumns == 1) {
+        std::vector<Term_t> tuples1, tuples2;
+        seg1->appendTo(0, tuples1);
+        seg2->appendTo(0, tuples2);
+        std::vector<Term_t> tuples(tuples1.size() + tuples2.size());
+        std::merge(tuples1.begin(), tuples1.end(), tuples2.begin(),
+                tuples2.end(), tuples.begin());
+        if (removeDuplicates) {
+            tuples.erase(std::unique(tuples.begin(), tuples.end()),
+                    tuples.end());
+        }
+        return std::shared_ptr<const TGSegment>(
+                new UnaryTGSegment(tuples, ~0ul, true, 0));
+    } else if (ncolumns == 2) {
+        std::vector<std::pair<Term_t, Term_t>> tuples1, tuples2;
+        seg1->appendTo(0, 1, tuples1);
+        seg2->appendTo(0, 1, tuples2);
+        std::vector<std::pair<Term_t, Term_t>> tuples(tuples1.size() +
+                tuples2.size());
+        std::merge(tuples1.begin(), tuples1.end(), tuples2.begin(),
+                tuples2.end(), tuples.begin());
+        if (removeDuplicates) {
+            tuples.erase(std::unique(tuples.begin(), tuples.end()),
+                    tuples.end());
+        }
+        return std::shared_ptr<const TGSegment>(
+                new BinaryTGSegment(tuples, ~0ul, true, 0));
+    } else {
+        std::vector<std::vector<Term_t>> tuples(ncolumns);
+        for(auto &column : tuples) {
+            column.reserve(seg1->getNRows() + seg2->getNRows());
+        }
+        auto itr1 = seg1->iterator();
+        auto itr2 = seg2->iterator();
+        bool active1 = itr1->hasNext();
+        bool active2 = itr2->hasNext();
+        if (active1)
+            itr1->next();
+        if (active2)
+            itr2->next();
+        while (active1 || active2) {
+            int res;
+            if (!active2) {
+                res = -1;
+            } else if (!active1) {
+                res = 1;
+            } else {
+                res = TGSegmentItr::cmp(itr1.get(), itr2.get());
+            }
+            TGSegmentItr *itr = res <= 0 ? itr1.get() : itr2.get();
+            for(size_t i = 0; i < ncolumns; ++i) {
+                tuples[i].push_back(itr->get(i));
+            }
+            if (res <= 0) {
+                active1 = itr1->hasNext();
+                if (active1)
+                    itr1->next();
+            }
+            if (res > 0 || (res == 0 && removeDuplicates)) {
+                active2 = itr2->hasNext();
+                if (active2)
+                    itr2->next();
+            }
+        }
+        const size_t nrows = tuples[0].size();
+        std::vector<std::shared_ptr<Column>> columns;
+        for(size_t i = 0; i < ncolumns; ++i) {
+            columns.push_back(std::shared_ptr<Column>(
+                        new InmemoryColumn(tuples[i], true)));
+        }
+        return std::shared_ptr<const TGSegment>(
+                new TGSegmentLegacy(columns, nrows, true, 0,
+                    SegProvenanceType::SEG_NOPROV, 0,
+                    TGSegmentLegacy::getFirstFields(ncolumns)));
+    }
+}
+
+void GBGraph::updateCacheRetain(PredId_t p, size_t ncolumns) {
+    auto &nodeIdxs = getNodeIDsWithPredicate(p);
+    auto &entry = cacheRetain[p];
+
+    //Only the tuples of the new nodes are sorted
+    std::shared_ptr<const TGSegment> run;
+    if (ncolumns == 1) {
+        std::vector<Term_t> tuples;
+        for(size_t i = entry.nnodes; i < nodeIdxs.size(); ++i) {
+            getNodeData(nodeIdxs[i])->appendTo(0, tuples);
+        }
+        RadixSort::sort(tuples);
+        run = std::shared_ptr<const TGSegment>(
+                new UnaryTGSegment(tuples, ~0ul, true, 0));
+    } else if (ncolumns == 2) {
+        std::vector<std::pair<Term_t, Term_t>> tuples;
+        for(size_t i = entry.nnodes; i < nodeIdxs.size(); ++i) {
+            getNodeData(nodeIdxs[i])->appendTo(0, 1, tuples);
+        }
+        RadixSort::sort(tuples);
+#ifdef DEBUG
+        auto e = std::unique(tuples.begin(), tuples.end());
+        auto d = std::distance(e, tuples.end());
+        if (d > 0) {
+            LOG(ERRORL) << "Duplicates should not occur here!";
+            throw 10;
+        }
+#endif
+        run = std::shared_ptr<const TGSegment>(
+                new BinaryTGSegment(tuples, ~0ul, true, 0));
+    } else if (ncolumns > 2) {
+        std::vector<int> posFields;
+        for(int i = 0; i < ncolumns; ++i)
+            posFields.push_back(i);
+        std::vector<std::vector<Term_t>> tuples(ncolumns);
+        for(size_t i = entry.nnodes; i < nodeIdxs.size(); ++i) {
+            getNodeData(nodeIdxs[i])->appendTo(posFields, tuples);
+        }
+        size_t nrows = tuples[0].size();
+        //Create columns from the content of tuples
+        std::vector<std::shared_ptr<Column>> columns;
+        for(int i = 0; i < ncolumns; ++i) {
+            columns.push_back(std::shared_ptr<Column>(
+                        new InmemoryColumn(tuples[i], true)));
+        }
+        run = std::shared_ptr<const TGSegment>(
+                new TGSegmentLegacy(columns, nrows));
+        run = run->sort();
+    } else {
+        LOG(ERRORL) << "Retain with arity = 0 is not supported";
+        throw 10;
+    }
+    entry.nnodes = nodeIdxs.size();
+    if (run->isEmpty())
+        return;
+    entry.runs.push_back(run);
+
+    //Size-tiered merging: every tuple is merged O(log n) times and there are
+    //O(log n) runs to probe
+    auto &runs = entry.runs;
+    while (runs.size() > 1 && runs[runs.size() - 2]->getNRows() <
+            GBGRAPH_RETAIN_MERGE_FACTOR * runs.back()->getNRows()) {
+        //The nodes do not share tuples, so there are no duplicates
+        auto merged = mergeSortedSegments(runs[runs.size() - 2], runs.back(),
+                false);
+        runs.pop_back();
+        runs.back() = merged;
+    }
+}
+
 std::shared_ptr<const TGSegment> GBGraph::retain(
         PredId_t p,
         std::shared_ptr<const TGSegment> newtuples,
@@ -403,97 +555,19 @@ std::shared_ptr<const TGSegment> GBGraph::retain(
     auto &nodeIdxs = getNodeIDsWithPredicate(p);
     assert(nodeIdxs.size() > 0);
     if (cacheRetainEnabled && nodeIdxs.size() > 1) {
-        //Merge and sort the segments
         if (!cacheRetain.count(p) || cacheRetain[p].nnodes < nodeIdxs.size()) {
-            //Get the arity
-            if (newtuples->getNColumns() == 1) {
-                std::vector<Term_t> tuples;
-                size_t startNodeIdx = 0;
-                if (cacheRetain.count(p)) {
-                    cacheRetain[p].seg->appendTo(0, tuples);
-                    startNodeIdx = cacheRetain[p].nnodes;
-                }
-                for(size_t i = startNodeIdx; i < nodeIdxs.size(); ++i) {
-                    getNodeData(nodeIdxs[i])->appendTo(0, tuples);
-                }
-                std::sort(tuples.begin(), tuples.end());
-                auto seg = std::shared_ptr<const TGSegment>(
-                        new UnaryTGSegment(tuples, ~0ul, true, 0));
-                CacheRetainEntry entry;
-                entry.nnodes = nodeIdxs.size();
-                entry.seg = seg;
-                cacheRetain[p] = entry;
-            } else if (newtuples->getNColumns() == 2) {
-                //std::chrono::steady_clock::time_point startCache =
-                //    std::chrono::steady_clock::now();
-
-                std::vector<std::pair<Term_t, Term_t>> tuples;
-                size_t startNodeIdx = 0;
-                if (cacheRetain.count(p)) {
-                    cacheRetain[p].seg->appendTo(0, 1, tuples);
-                    startNodeIdx = cacheRetain[p].nnodes;
-                }
-                for(size_t i = startNodeIdx; i < nodeIdxs.size(); ++i) {
-                    getNodeData(nodeIdxs[i])->appendTo(0, 1, tuples);
-                }
-                std::sort(tuples.begin(), tuples.end());
-#ifdef DEBUG
-                auto e = std::unique(tuples.begin(), tuples.end());
-                auto d = std::distance(e, tuples.end());
-                if (d > 0) {
-                    LOG(ERRORL) << "Duplicates should not occur here!";
-                    throw 10;
-                }
-#endif
-                auto seg = std::shared_ptr<const TGSegment>(
-                        new BinaryTGSegment(tuples, ~0ul, true, 0));
-                CacheRetainEntry entry;
-                entry.nnodes = nodeIdxs.size();
-                entry.seg = seg;
-                cacheRetain[p] = entry;
-
-            } else if (newtuples->getNColumns() > 2) {
-                size_t ncolumns = newtuples->getNColumns();
-                std::vector<int> posFields;
-                for(int i = 0; i < ncolumns; ++i)
-                    posFields.push_back(i);
-                std::vector<std::vector<Term_t>> tuples(ncolumns);
-                size_t startNodeIdx = 0;
-                if (cacheRetain.count(p)) {
-                    cacheRetain[p].seg->appendTo(posFields, tuples);
-                    startNodeIdx = cacheRetain[p].nnodes;
-                }
-                for(size_t i = startNodeIdx; i < nodeIdxs.size(); ++i) {
-                    getNodeData(nodeIdxs[i])->appendTo(posFields, tuples);
-                }
-                size_t nrows = tuples[0].size();
-                //Create columns from the content of tuples
-                std::vector<std::shared_ptr<Column>> columns;
-                for(int i = 0; i < ncolumns; ++i) {
-                    columns.push_back(std::shared_ptr<Column>(
-                                new InmemoryColumn(tuples[i], true)));
-                }
-                auto seg = std::shared_ptr<const TGSegment>(
-                        new TGSegmentLegacy(columns, nrows));
-                seg = seg->sort();
-                CacheRetainEntry entry;
-                entry.nnodes = nodeIdxs.size();
-                entry.seg = seg;
-                cacheRetain[p] = entry;
-            } else {
-                LOG(ERRORL) << "Retain with arity = 0 is not supported";
-                throw 10;
-            }
+            updateCacheRetain(p, newtuples->getNColumns());
         }
-        auto existingTuples = cacheRetain[p].seg;
-        newtuples = retainVsNodeFast(existingTuples, newtuples,
-                derivationNodes);
-        if (newtuples == NULL || newtuples->isEmpty()) {
-            std::chrono::steady_clock::time_point end =
-                std::chrono::steady_clock::now();
-            auto dur = end - start;
-            durationRetain += dur;
-            return std::shared_ptr<const TGSegment>();
+        //Probe the runs directly, starting from the largest one
+        for(auto &run : cacheRetain[p].runs) {
+            newtuples = retainVsNodeFast(run, newtuples, derivationNodes);
+            if (newtuples == NULL || newtuples->isEmpty()) {
+                std::chrono::steady_clock::time_point end =
+                    std::chrono::steady_clock::now();
+                auto dur = end - start;
+                durationRetain += dur;
+                return std::shared_ptr<const TGSegment>();
+            }
         }
     } else {
         for(auto &nodeIdx : nodeIdxs) {
@@ -850,13 +924,24 @@ std::shared_ptr<const TGSegment> GBGraph::retainVsNodeFast_two(
             } else {
                 assert(existuples->getNColumns() == 2);
                 assert(existuples->getProvenanceType() != SEG_DIFFNODES);
-                const std::vector<std::pair<Term_t, Term_t>> &t =
-                    existuples->getProvenanceType() == SEG_NOPROV ?
-                    ((BinaryTGSegment*)existuples.get())->getTuples() :
-                    ((BinaryWithConstProvTGSegment*)existuples.get())->getTuples();
+                //The data of the node might be compressed or spilled
+                const std::vector<std::pair<Term_t, Term_t>> *t = NULL;
+                std::vector<std::pair<Term_t, Term_t>> copy;
+                auto binary = dynamic_cast<const BinaryTGSegment*>(
+                        existuples.get());
+                auto binaryProv = dynamic_cast<
+                    const BinaryWithConstProvTGSegment*>(existuples.get());
+                if (binary) {
+                    t = &binary->getTuples();
+                } else if (binaryProv) {
+                    t = &binaryProv->getTuples();
+                } else {
+                    existuples->appendTo(0, 1, copy);
+                    t = &copy;
+                }
 
                 std::vector<std::pair<Term_t, Term_t>> retained = layer.
-                    checkNewIn(l1, posColumnsNew, t);
+                    checkNewIn(l1, posColumnsNew, *t);
                 if (retained.empty()) {
                     return std::shared_ptr<const TGSegment>();
                 } else {
@@ -0,0 +1,224 @@
+#include <glog/gbgraph.h>
+#include <glog/gbsegmentserializer.h>
+#include <vlog/edbconf.h>
+
+#include <kognac/utils.h>
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <sys/stat.h>
+
+#define GBGRAPH_SNAPSHOT_MAGIC "GBGSNAP1"
+#define GBGRAPH_SNAPSHOT_VERSION 3
+
+static void writeString(std::ostream &out, const std::string &s) {
+    //Strings are padded so that all the words remain aligned
+    GBSegmentSerializer::writeWord(out, s.size());
+    out.write(s.c_str(), s.size());
+    const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    if (s.size() % 8 != 0)
+        out.write(padding, 8 - s.size() % 8);
+}
+
+//Size and modification time of a file of an EDB table, if it exists
+static void addFileFingerprint(std::ostream &out, const std::string &rootPath,
+        const std::string &param) {
+    if (param.empty()) {
+        return;
+    }
+    std::string path = Utils::isAbsolutePath(param) ? param :
+        Utils::join(rootPath, param);
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+        out << "@" << param << ":" << (uint64_t) st.st_size << ":" <<
+            (uint64_t) st.st_mtime;
+    }
+}
+
+//The IDs of the terms in the nodes are valid only with the same EDB layer.
+//The fingerprint contains the EDB predicates in the order of their IDs, with
+//their arities and sizes, and the number of terms in the dictionaries. It
+//also contains the tables of edb.conf with the sizes and the modification
+//times of their files, so that a change in the data is detected also if the
+//counts do not change
+static std::string getEDBFingerprint(const EDBLayer &layer) {
+    std::ostringstream out;
+    out << "terms=" << layer.getNTermsInTables();
+    auto predIds = layer.getAllPredicateIDs();
+    std::sort(predIds.begin(), predIds.end());
+    for(auto p : predIds) {
+        out << ";" << p << ":" << layer.getPredName(p) << "/" <<
+            (int) layer.getPredArity(p) << "=" << layer.getPredSize(p);
+    }
+    const EDBConf &conf = layer.getConf();
+    for(const auto &table : conf.getTables()) {
+        out << ";" << table.predname << ":" << table.type;
+        for(const auto &param : table.params) {
+            out << "," << param;
+            addFileFingerprint(out, conf.getRootPath(), param);
+        }
+        if ((table.type == "INMEMORY" || table.type == "CSV") &&
+                table.params.size() > 1) {
+            //The files are <dir>/<name>.csv(.gz)
+            std::string file = Utils::join(table.params[0], table.params[1]) +
+                ".csv";
+            addFileFingerprint(out, conf.getRootPath(), file);
+            addFileFingerprint(out, conf.getRootPath(), file + ".gz");
+        }
+    }
+    return out.str();
+}
+
+static std::string readString(std::istream &in) {
+    size_t len = GBSegmentSerializer::readWord(in);
+    size_t paddedLen = (len + 7) / 8 * 8;
+    std::unique_ptr<char[]> buffer(new char[paddedLen]);
+    in.read(buffer.get(), paddedLen);
+    if (!in) {
+        LOG(ERRORL) << "Unexpected end of file";
+        throw 10;
+    }
+    return std::string(buffer.get(), len);
+}
+
+void GBGraph::store(const std::string &path) const {
+    if (program == NULL || layer == NULL) {
+        LOG(ERRORL) << "The program must be set before storing the graph";
+        throw 10;
+    }
+    std::ofstream out(path, std::ios_base::binary);
+    if (!out) {
+        LOG(ERRORL) << "Cannot open the file " << path;
+        throw 10;
+    }
+    out.write(GBGRAPH_SNAPSHOT_MAGIC, 8);
+    GBSegmentSerializer::writeWord(out, GBGRAPH_SNAPSHOT_VERSION);
+    GBSegmentSerializer::writeWord(out, provenanceType);
+    GBSegmentSerializer::writeWord(out, counterNullValues);
+    GBSegmentSerializer::writeWord(out, counterFreshVarsQueryCont);
+    GBSegmentSerializer::writeWord(out, program->getNRules());
+    writeString(out, getEDBFingerprint(*layer));
+
+    //Predicate IDs depend on the order in which the program is parsed,
+    //therefore I store also their names
+    GBSegmentSerializer::writeWord(out, pred2Nodes.size());
+    for(const auto &p : pred2Nodes) {
+        GBSegmentSerializer::writeWord(out, p.first);
+        GBSegmentSerializer::writeWord(out,
+                program->getPredicate(p.first).getCardinality());
+        writeString(out, program->getPredicateName(p.first));
+    }
+
+    GBSegmentSerializer::writeWord(out, nodes.size());
+    for(size_t nodeId = 0; nodeId < nodes.size(); ++nodeId) {
+        const auto &node = nodes[nodeId];
+        GBSegmentSerializer::writeWord(out, node.predid);
+        GBSegmentSerializer::writeWord(out, node.ruleIdx);
+        GBSegmentSerializer::writeWord(out, node.step);
+        const auto &incomingEdges = node.getIncomingEdges();
+        GBSegmentSerializer::writeWord(out, incomingEdges.size());
+        for(auto e : incomingEdges) {
+            GBSegmentSerializer::writeWord(out, e);
+        }
+        GBSegmentSerializer::write(out, node.getData());
+    }
+    if (!out) {
+        LOG(ERRORL) << "Error while writing the file " << path;
+        throw 10;
+    }
+    LOG(INFOL) << "Stored " << nodes.size() << " nodes in " << path;
+}
+
+size_t GBGraph::load(const std::string &path) {
+    if (program == NULL || layer == NULL) {
+        LOG(ERRORL) << "The program must be set before loading the graph";
+        throw 10;
+    }
+    if (!nodes.empty()) {
+        LOG(ERRORL) << "The graph can be loaded only if it is empty";
+        throw 10;
+    }
+    std::ifstream in(path, std::ios_base::binary);
+    if (!in) {
+        LOG(ERRORL) << "Cannot open the file " << path;
+        throw 10;
+    }
+    char magic[8];
+    in.read(magic, 8);
+    if (!in || memcmp(magic, GBGRAPH_SNAPSHOT_MAGIC, 8) != 0) {
+        LOG(ERRORL) << "The file " << path << " is not a snapshot of a graph";
+        throw 10;
+    }
+    auto version = GBSegmentSerializer::readWord(in);
+    if (version != GBGRAPH_SNAPSHOT_VERSION) {
+        LOG(ERRORL) << "Version " << version << " of the snapshot is not "
+            "supported";
+        throw 10;
+    }
+    auto storedProvenanceType = GBSegmentSerializer::readWord(in);
+    if (storedProvenanceType != provenanceType) {
+        LOG(ERRORL) << "The snapshot was created with a different type of "
+            "provenance (" << storedProvenanceType << " vs. " <<
+            provenanceType << ")";
+        throw 10;
+    }
+    counterNullValues = GBSegmentSerializer::readWord(in);
+    counterFreshVarsQueryCont = GBSegmentSerializer::readWord(in);
+    auto nrules = GBSegmentSerializer::readWord(in);
+    if (nrules != program->getNRules()) {
+        LOG(ERRORL) << "The snapshot was created with a program with " <<
+            nrules << " rules, while the current one has " <<
+            program->getNRules() << " rules";
+        throw 10;
+    }
+    const std::string fingerprint = readString(in);
+    if (fingerprint != getEDBFingerprint(*layer)) {
+        LOG(ERRORL) << "The snapshot was created with a different EDB layer";
+        LOG(DEBUGL) << "Snapshot: " << fingerprint;
+        LOG(DEBUGL) << "Current: " << getEDBFingerprint(*layer);
+        throw 10;
+    }
+
+    std::map<PredId_t, PredId_t> predMap;
+    auto npreds = GBSegmentSerializer::readWord(in);
+    for(size_t i = 0; i < npreds; ++i) {
+        PredId_t storedId = GBSegmentSerializer::readWord(in);
+        uint8_t card = GBSegmentSerializer::readWord(in);
+        std::string name = readString(in);
+        auto id = program->getOrAddPredicate(name, card);
+        if (id < 0) {
+            LOG(ERRORL) << "Predicate " << name << " has a different arity";
+            throw 10;
+        }
+        predMap[storedId] = id;
+    }
+
+    size_t lastStep = 0;
+    auto nnodes = GBSegmentSerializer::readWord(in);
+    nodes.reserve(nnodes);
+    for(size_t nodeId = 0; nodeId < nnodes; ++nodeId) {
+        PredId_t predId = predMap.at(GBSegmentSerializer::readWord(in));
+        size_t ruleIdx = GBSegmentSerializer::readWord(in);
+        size_t step = GBSegmentSerializer::readWord(in);
+        std::vector<size_t> incomingEdges(GBSegmentSerializer::readWord(in));
+        for(size_t i = 0; i < incomingEdges.size(); ++i) {
+            incomingEdges[i] = GBSegmentSerializer::readWord(in);
+        }
+        auto data = GBSegmentSerializer::read(in, nodeId);
+
+        nodes.emplace_back();
+        GBGraph_Node &node = nodes.back();
+        node.predid = predId;
+        node.ruleIdx = ruleIdx;
+        node.step = step;
+        node.setData(data);
+        node.setIncomingEdges(incomingEdges);
+        pred2Nodes[predId].push_back(nodeId);
+        if (step != ~0ul && step > lastStep)
+            lastStep = step;
+    }
+    LOG(INFOL) << "Loaded " << nodes.size() << " nodes from " << path;
+    return lastStep;
+}
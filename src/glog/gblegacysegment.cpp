@@ -58,12 +58,29 @@ bool TGSegmentLegacy::isProvenanceAutomatic() const {
 }
 
 bool TGSegmentLegacy::isSortedBy(std::vector<uint8_t> &fields) const {
-    if (fields.size() != 1)
-        return false;
+    if (fields.size() != 1) {
+        //Only the fields that were actually used for sorting count: after
+        //sortBy({0,2}) the rows are not sorted by (0,1)
+        if (!f_isSorted || fields.empty() ||
+                fields.size() > sortedFields.size())
+            return false;
+        for(size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i] != sortedFields[i])
+                return false;
+        }
+        return true;
+    }
     auto field = fields[0];
     return (f_isSorted && sortedField == field);
 }
 
+std::vector<uint8_t> TGSegmentLegacy::getFirstFields(size_t n) {
+    std::vector<uint8_t> fields;
+    for(size_t i = 0; i < n; ++i)
+        fields.push_back(i);
+    return fields;
+}
+
 std::vector<std::shared_ptr<const TGSegment>> TGSegmentLegacy::sliceByNodes(
         size_t startNodeIdx,
         std::vector<size_t> &provNodes) const
@@ -102,7 +119,8 @@ std::shared_ptr<TGSegment> TGSegmentLegacy::sortBy(
     if (f_isSorted && (fields.size() == 0 ||
                 (fields.size() == 1 && fields[0] == 0))) {
         return std::shared_ptr<TGSegment>(new TGSegmentLegacy(
-                    columns, nrows, true, 0, provenanceType, nprovcolumns));
+                    columns, nrows, true, 0, provenanceType, nprovcolumns,
+                    sortedFields));
     }
 
     if (columns.size() == 1) {
@@ -112,7 +130,7 @@ std::shared_ptr<TGSegment> TGSegmentLegacy::sortBy(
         return std::shared_ptr<TGSegment>(
                 new TGSegmentLegacy(
                     columns, column->size(), true, 0,
-                    provenanceType, nprovcolumns));
+                    provenanceType, nprovcolumns, getFirstFields(1)));
     } else {
         auto nfields = columns.size();
         auto oldcols(columns);
@@ -125,7 +143,7 @@ std::shared_ptr<TGSegment> TGSegmentLegacy::sortBy(
         return std::shared_ptr<TGSegment>(
                 new TGSegmentLegacy(
                     newColumns, s.getNRows(), true, fields[0],
-                    provenanceType, nprovcolumns));
+                    provenanceType, nprovcolumns, fields));
     }
 }
 
@@ -181,7 +199,8 @@ std::shared_ptr<const TGSegment> TGSegmentLegacy::unique() const {
         nrows = retained->getNRows();
     }
     return std::shared_ptr<const TGSegment>(new TGSegmentLegacy(newcols,
-                nrows, true, sortedField, provenanceType, nprovcolumns));
+                nrows, true, sortedField, provenanceType, nprovcolumns,
+                sortedFields));
 }
 
 std::shared_ptr<const TGSegment> TGSegmentLegacy::sort() const {
@@ -230,11 +249,12 @@ std::shared_ptr<const TGSegment> TGSegmentLegacy::sort() const {
         }
         return std::shared_ptr<const TGSegment>(
                 new TGSegmentLegacy(newcols, nrows, true, 0,
-                    provenanceType, nprovcolumns));
+                    provenanceType, nprovcolumns,
+                    getFirstFields(columns.size() - nprovcolumns)));
     } else {
         return std::shared_ptr<const TGSegment>(
                 new TGSegmentLegacy(columns, nrows, true, 0,
-                    provenanceType, nprovcolumns));
+                    provenanceType, nprovcolumns, sortedFields));
     }
 }
 
@@ -333,7 +353,7 @@ std::shared_ptr<const TGSegment> TGSegmentLegacy::shuffle(
     } else {
         return std::shared_ptr<TGSegment>(
                 new TGSegmentLegacy(columns, nrows, f_isSorted, sortedField,
-                    provenanceType, nprovcolumns));
+                    provenanceType, nprovcolumns, sortedFields));
     }
 }
 
@@ -345,7 +365,7 @@ std::shared_ptr<const TGSegment> TGSegmentLegacy::sortByProv(size_t ncols,
     const auto nrows = nodes.size() / ncols;
     idxs.resize(nrows);
     for(size_t i = 0; i < nrows; ++i) idxs[i] = i;
-    std::stable_sort(idxs.begin(), idxs.end(), ProvSorter(nodes.data(), ncols));
+    RadixSort::sort(idxs, RadixKeysRows(nodes.data(), ncols));
     return shuffle(idxs);
 }
 
@@ -377,7 +397,7 @@ std::shared_ptr<TGSegment> TGSegmentLegacy::slice(const size_t nodeId,
     if (p == SEG_DIFFNODES)
         p = SEG_SAMENODE;
     return std::shared_ptr<TGSegment>(new TGSegmentLegacy(newcols, length,
-                f_isSorted, sortedField, p, nprovcolumns));
+                f_isSorted, sortedField, p, nprovcolumns, sortedFields));
 }
 
 std::shared_ptr<const TGSegment> TGSegmentLegacy::slice(
@@ -394,7 +414,8 @@ std::shared_ptr<const TGSegment> TGSegmentLegacy::slice(
         }
     }
     return std::shared_ptr<TGSegment>(new TGSegmentLegacy(newcols, length,
-                f_isSorted, sortedField, provenanceType, nprovcolumns));
+                f_isSorted, sortedField, provenanceType, nprovcolumns,
+                sortedFields));
 }
 
 void TGSegmentLegacy::appendTo(uint8_t colPos, std::vector<Term_t> &out) const {
@@ -890,10 +890,18 @@ std::shared_ptr<const TGSegment> GBRuleExecutor::performRestrictedCheck(
         if (g.areNodesWithPredicate(headAtom.getPredicate().getId())) {
             const auto &nodesRight = g.getNodeIDsWithPredicate(
                     headAtom.getPredicate().getId());
-            std::shared_ptr<const TGSegment> inputRight = g.mergeNodes(
-                    nodesRight,
-                    filterConstants,
-                    varsToCopyRight);
+            std::shared_ptr<const TGSegment> inputRight;
+            if (varsToCopyRight.empty()) {
+                inputRight = g.mergeNodes(nodesRight, filterConstants,
+                        varsToCopyRight);
+            } else {
+                //Already sorted by all the fields, so leftjoin can use it
+                //as it is
+                inputRight = g.getRestrictedCheckIndex(
+                        headAtom.getPredicate().getId(),
+                        filterConstants,
+                        varsToCopyRight);
+            }
 
             //Prepare the container that will store the retained tuples
             const int extraColumns = shouldTrackProvenance() ? 1 : 0;
@@ -956,6 +964,12 @@ std::vector<GBRuleOutput> GBRuleExecutor::executeRule(Rule &rule,
     lastDurationJoin = std::chrono::duration<double, std::milli>(0);
     lastDurationCreateHead = std::chrono::duration<double, std::milli>(0);
     bdyAtoms = "";
+    lastStats = GBRuleExecutionStats();
+    for(const auto &nodes : bodyNodes) {
+        for(auto nodeId : nodes) {
+            lastStats.nInput += g.getNodeSize(nodeId);
+        }
+    }
 
     //Perform the joins and populate the head
     auto &bodyAtoms = rule.getBody();
@@ -1157,6 +1171,8 @@ std::vector<GBRuleOutput> GBRuleExecutor::executeRule(Rule &rule,
                     copyVarPosLeft,
                     copyVarPosRight,
                     newIntermediateResults);
+            //Apply the builtin functions to the last block of rows
+            newIntermediateResults->flush();
             //After the first join, it makes little sense to further cache
             //the left side of joins
             enableCacheLeft = false; //enableCacheLeft & enableCacheRight;
@@ -1214,11 +1230,16 @@ std::vector<GBRuleOutput> GBRuleExecutor::executeRule(Rule &rule,
             intermediateResults->isEmpty());
     std::vector<GBRuleOutput> output;
     if (nonempty) {
+        lastStats.nIntermediate = intermediateResults->getNRows();
         bool uniqueTuples = false;
         if (rule.isExistential()) {
             //Perform restricted check
+            std::chrono::steady_clock::time_point startRC =
+                std::chrono::steady_clock::now();
             intermediateResults = performRestrictedCheck(rule,
                     intermediateResults, varsIntermediate);
+            lastStats.durationRestrictedCheck +=
+                std::chrono::steady_clock::now() - startRC;
             if (!intermediateResults->isEmpty()) {
                 //If there are existential variables, add values for them
                 intermediateResults = addExistentialVariables(rule,
@@ -1251,14 +1272,29 @@ std::vector<GBRuleOutput> GBRuleExecutor::executeRule(Rule &rule,
             }
         }
     }
+    //The joins are done, so the compressed body nodes can be dropped
+    for(const auto &nodes : bodyNodes) {
+        g.releaseDecompressed(nodes);
+    }
     return output;
 }
 
+void GBRuleExecutor::addStats(const GBRuleExecutor &worker) {
+    durationFirst += worker.durationFirst;
+    durationMergeSort += worker.durationMergeSort;
+    durationJoin += worker.durationJoin;
+    durationCreateHead += worker.durationCreateHead;
+    nMergeJoins += worker.nMergeJoins;
+    nHashJoins += worker.nHashJoins;
+}
+
 void GBRuleExecutor::printStats() {
     LOG(INFOL) << "Time first (ms): " << durationFirst.count();
     LOG(INFOL) << "Time mergesort (ms): " << durationMergeSort.count();
     LOG(INFOL) << "Time joins (ms): " << durationJoin.count();
     LOG(INFOL) << "Time head (ms): " << durationCreateHead.count();
+    LOG(INFOL) << "N. merge joins: " << nMergeJoins << " N. hash joins: " <<
+        nHashJoins;
     //LOG(INFOL) << "Time preparation join2to1 (ms): " << durationPrep2to1.count();
 }
 
@@ -1266,6 +1302,7 @@ DuplManager::DuplManager(GBSegmentInserter *output) {
     //Collect all the entities in the left side of the binary relation
     //added so far
     LOG(DEBUGL) << "Start populating the maps for the detection of duplicates";
+    output->flush();
     l = output->getEntitiesAddedSoFar(0);
     r = output->getEntitiesAddedSoFar(1);
     size_t nrows = output->getNRows();
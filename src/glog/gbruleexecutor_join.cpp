@@ -1,6 +1,8 @@
 #include <glog/gbruleexecutor.h>
 #include <glog/gbsegmentcache.h>
 
+#include <cmath>
+
 void GBRuleExecutor::join(
         const bool enableCacheLeft,
         const bool enableCacheRight,
@@ -61,7 +63,17 @@ void GBRuleExecutor::join(
                 copyVarPosLeft,
                 output);
     } else {
-        if (mergeJoinPossible) {
+        if (mergeJoinPossible && shouldUseHashJoin(enableCacheLeft,
+                    enableCacheRight, inputLeft, nodesLeft, inputRight,
+                    nodesRight, joinVarPos)) {
+            hashjoin(
+                    inputLeft,
+                    inputRight,
+                    joinVarPos,
+                    copyVarPosLeft,
+                    copyVarPosRight,
+                    output);
+        } else if (mergeJoinPossible) {
             mergejoin(
                     enableCacheLeft,
                     enableCacheRight,
@@ -90,6 +102,198 @@ void GBRuleExecutor::join(
     }
 }
 
+bool GBRuleExecutor::shouldUseHashJoin(
+        const bool enableCacheLeft,
+        const bool enableCacheRight,
+        std::shared_ptr<const TGSegment> inputLeft,
+        const std::vector<size_t> &nodesLeft,
+        std::shared_ptr<const TGSegment> inputRight,
+        const std::vector<size_t> &nodesRight,
+        std::vector<std::pair<int, int>> &joinVarPos) {
+    if (joinVarPos.empty()) {
+        return false; //Cartesian product
+    }
+    std::vector<uint8_t> fields1;
+    std::vector<uint8_t> fields2;
+    for (uint32_t i = 0; i < joinVarPos.size(); ++i) {
+        fields1.push_back(joinVarPos[i].first);
+        fields2.push_back(joinVarPos[i].second);
+    }
+    //The merge join must sort the inputs, unless they are already sorted or
+    //their sorted version is in the cache
+    SegmentCache &c = SegmentCache::getInstance();
+    const double nLeft = inputLeft->getNRows();
+    const double nRight = inputRight->getNRows();
+    double costMerge = nLeft + nRight;
+    if (!inputLeft->isSortedBy(fields1) && !(enableCacheLeft &&
+                nodesLeft.size() > 0 && c.contains(nodesLeft, fields1))) {
+        costMerge += nLeft * std::log2(nLeft + 2);
+    }
+    if (!inputRight->isSortedBy(fields2) && !(enableCacheRight &&
+                nodesRight.size() > 0 && c.contains(nodesRight, fields2))) {
+        costMerge += nRight * std::log2(nRight + 2);
+    }
+    //The hash join builds a hash table on the smallest side and probes it
+    //with the largest one
+    double costHash = HASHJOIN_BUILD_COST * std::min(nLeft, nRight) +
+        HASHJOIN_PROBE_COST * std::max(nLeft, nRight);
+    return costHash < costMerge;
+}
+
+void GBRuleExecutor::hashjoin(
+        std::shared_ptr<const TGSegment> inputLeft,
+        std::shared_ptr<const TGSegment> inputRight,
+        std::vector<std::pair<int, int>> &joinVarsPos,
+        std::vector<int> &copyVarPosLeft,
+        std::vector<int> &copyVarPosRight,
+        std::unique_ptr<GBSegmentInserter> &output) {
+    std::chrono::system_clock::time_point startB =
+        std::chrono::system_clock::now();
+    nHashJoins++;
+    lastStats.nHashJoins++;
+
+    //The output rows have the same layout of the ones produced by mergejoin
+    auto extraLeft = 0;
+    if (inputLeft->getNOffsetColumns() > 0)
+        extraLeft = inputLeft->getNOffsetColumns() - 1; //I remove the node,
+    //it will be added at the end
+    auto extraRight = 0;
+    if (provenanceType == GBGraph::ProvenanceType::FULLPROV) {
+        extraRight = 1;
+    }
+    const size_t sizeRow = copyVarPosLeft.size() + copyVarPosRight.size() +
+        extraLeft + extraRight;
+    Term_t currentrow[sizeRow + 2];
+    for(size_t i = 0; i < sizeRow + 2; ++i) currentrow[i] = 0;
+    const bool trackProvenance = shouldTrackProvenance();
+
+    //Build the hash table on the smallest side
+    const bool buildLeft = inputLeft->getNRows() <= inputRight->getNRows();
+    auto buildInput = buildLeft ? inputLeft : inputRight;
+    auto probeInput = buildLeft ? inputRight : inputLeft;
+    std::vector<int> buildKeys;
+    std::vector<int> probeKeys;
+    for (const auto &p : joinVarsPos) {
+        buildKeys.push_back(buildLeft ? p.first : p.second);
+        probeKeys.push_back(buildLeft ? p.second : p.first);
+    }
+    const std::vector<int> &buildCopy = buildLeft ? copyVarPosLeft :
+        copyVarPosRight;
+    const std::vector<int> &probeCopy = buildLeft ? copyVarPosRight :
+        copyVarPosLeft;
+    const size_t buildExtra = buildLeft ? extraLeft : extraRight;
+    const size_t probeExtra = buildLeft ? extraRight : extraLeft;
+    //Positions in the output row
+    const size_t startOffsetsLeft = copyVarPosLeft.size() +
+        copyVarPosRight.size();
+    const size_t startOffsetsRight = startOffsetsLeft + extraLeft;
+    const size_t buildCopyStart = buildLeft ? 0 : copyVarPosLeft.size();
+    const size_t probeCopyStart = buildLeft ? copyVarPosLeft.size() : 0;
+    const size_t buildExtraStart = buildLeft ? startOffsetsLeft :
+        startOffsetsRight;
+    const size_t probeExtraStart = buildLeft ? startOffsetsRight :
+        startOffsetsLeft;
+    const size_t buildNodePos = buildLeft ? sizeRow : sizeRow + 1;
+    const size_t probeNodePos = buildLeft ? sizeRow + 1 : sizeRow;
+
+    //Each row of the build side stores the keys, the values to copy, the
+    //provenance offsets and the node
+    const size_t nkeys = buildKeys.size();
+    const size_t stride = nkeys + buildCopy.size() + buildExtra + 1;
+    const size_t nbuild = buildInput->getNRows();
+    std::vector<Term_t> buildRows;
+    buildRows.reserve(nbuild * stride);
+    size_t nbuckets = 1;
+    while (nbuckets < nbuild * 2)
+        nbuckets <<= 1;
+    std::vector<size_t> buckets(nbuckets, ~0ul);
+    std::vector<size_t> next;
+    next.reserve(nbuild);
+    auto itrBuild = buildInput->iterator();
+    size_t rowIdx = 0;
+    while (itrBuild->hasNext()) {
+        itrBuild->next();
+        for (size_t i = 0; i < nkeys; ++i) {
+            buildRows.push_back(itrBuild->get(buildKeys[i]));
+        }
+        for (size_t i = 0; i < buildCopy.size(); ++i) {
+            buildRows.push_back(itrBuild->get(buildCopy[i]));
+        }
+        for (size_t i = 0; i < buildExtra; ++i) {
+            assert(itrBuild->getNProofs() == 1);
+            buildRows.push_back(itrBuild->getProvenanceOffset(0, i));
+        }
+        buildRows.push_back(trackProvenance ? itrBuild->getNodeId() : 0);
+        auto h = hashRow(buildRows.data() + rowIdx * stride, nkeys) &
+            (nbuckets - 1);
+        next.push_back(buckets[h]);
+        buckets[h] = rowIdx;
+        rowIdx++;
+    }
+    std::chrono::duration<double, std::milli> durationBuild =
+        std::chrono::system_clock::now() - startB;
+    lastDurationMergeSort += durationBuild;
+    durationMergeSort += durationBuild;
+
+    //Probe the hash table
+    Term_t probeKey[nkeys];
+    auto itrProbe = probeInput->iterator();
+    while (itrProbe->hasNext()) {
+        itrProbe->next();
+        for (size_t i = 0; i < nkeys; ++i) {
+            probeKey[i] = itrProbe->get(probeKeys[i]);
+        }
+        size_t idx = buckets[hashRow(probeKey, nkeys) & (nbuckets - 1)];
+        bool probeCopied = false;
+        while (idx != ~0ul) {
+            const Term_t *row = buildRows.data() + idx * stride;
+            idx = next[idx];
+            bool equal = true;
+            for (size_t i = 0; i < nkeys; ++i) {
+                if (row[i] != probeKey[i]) {
+                    equal = false;
+                    break;
+                }
+            }
+            if (!equal) {
+                continue;
+            }
+            if (!probeCopied) {
+                for (size_t i = 0; i < probeCopy.size(); ++i) {
+                    currentrow[probeCopyStart + i] =
+                        itrProbe->get(probeCopy[i]);
+                }
+                for (size_t i = 0; i < probeExtra; ++i) {
+                    assert(itrProbe->getNProofs() == 1);
+                    currentrow[probeExtraStart + i] =
+                        itrProbe->getProvenanceOffset(0, i);
+                }
+                if (trackProvenance) {
+                    currentrow[probeNodePos] = itrProbe->getNodeId();
+                }
+                probeCopied = true;
+            }
+            row += nkeys;
+            for (size_t i = 0; i < buildCopy.size(); ++i) {
+                currentrow[buildCopyStart + i] = row[i];
+            }
+            row += buildCopy.size();
+            for (size_t i = 0; i < buildExtra; ++i) {
+                currentrow[buildExtraStart + i] = row[i];
+            }
+            if (trackProvenance) {
+                currentrow[buildNodePos] = row[buildExtra];
+            }
+            output->add(currentrow);
+        }
+    }
+#if DEBUG
+    std::chrono::duration<double> secB =
+        std::chrono::system_clock::now() - startB;
+    LOG(TRACEL) << "hash_join: time : " << secB.count() * 1000;
+#endif
+}
+
 void GBRuleExecutor::mergejoin(
         const bool enableCacheLeft,
         const bool enableCacheRight,
@@ -103,6 +307,8 @@ void GBRuleExecutor::mergejoin(
         std::unique_ptr<GBSegmentInserter> &output) {
     std::chrono::system_clock::time_point startL =
         std::chrono::system_clock::now();
+    nMergeJoins++;
+    lastStats.nMergeJoins++;
 
     std::vector<uint8_t> fields1;
     std::vector<uint8_t> fields2;
@@ -115,43 +321,32 @@ void GBRuleExecutor::mergejoin(
 
     //Sort the left segment by the join variable
     if (!fields1.empty() && !inputLeft->isSortedBy(fields1)) {
-        if (enableCacheLeft && fields1.size() > 1)
-            LOG(DEBUGL) << "I cannot use the cache because it works only if "
-                "the join is over 1 variable";
-        if (enableCacheLeft && nodesLeft.size() > 0 && fields1.size() == 1) {
+        if (enableCacheLeft && nodesLeft.size() > 0) {
             SegmentCache &c = SegmentCache::getInstance();
-            if (!c.contains(nodesLeft, fields1)) {
-                inputLeft = inputLeft->sortBy(fields1);
-                c.insert(nodesLeft, fields1, inputLeft);
+            if (c.contains(nodesLeft, fields1)) {
+                lastStats.nCacheHits++;
             } else {
-                inputLeft = c.get(nodesLeft, fields1);
+                lastStats.nSorts++;
             }
+            inputLeft = c.getSorted(nodesLeft, fields1, inputLeft);
         } else {
+            lastStats.nSorts++;
             inputLeft = inputLeft->sortBy(fields1);
         }
     }
     std::unique_ptr<TGSegmentItr> itrLeft = inputLeft->iterator();
     //Sort the right segment by the join variable
     if (!fields2.empty() && !inputRight->isSortedBy(fields2)) {
-        if (enableCacheRight && fields2.size() > 1)
-            LOG(DEBUGL) << "I cannot use the cache because it works only if "
-                "the join is over 1 variable";
-        if (enableCacheRight && nodesRight.size() > 0 && fields2.size() == 1) {
+        if (enableCacheRight && nodesRight.size() > 0) {
             SegmentCache &c = SegmentCache::getInstance();
-            if (fields2.size() == 1) {
-                if (!c.contains(nodesRight, fields2)) {
-                    if (nodesRight.size() == 1 && nodesRight[0] == 94)
-                        std::cout << "strop";
-                    inputRight = inputRight->sortBy(fields2);
-                    c.insert(nodesRight, fields2, inputRight);
-                } else {
-                    inputRight = c.get(nodesRight, fields2);
-                }
+            if (c.contains(nodesRight, fields2)) {
+                lastStats.nCacheHits++;
             } else {
-                assert(fields2.size() > 1);
-                inputRight = inputRight->sortBy(fields2);
+                lastStats.nSorts++;
             }
+            inputRight = c.getSorted(nodesRight, fields2, inputRight);
         } else {
+            lastStats.nSorts++;
             inputRight = inputRight->sortBy(fields2);
         }
     }
@@ -346,6 +541,10 @@ void GBRuleExecutor::mergejoin(
                 //The algorithm should have outputted countLeft * grpCountRight
                 //tuples. Check if they turned out to be duplicates
                 size_t maxSize = countLeft * grpCountRight;
+                if (!filterDuplEnabled && leftActive) {
+                    //Count also the rows that wait for the builtin functions
+                    output->flush();
+                }
                 size_t diff = output->getNRows() - addedSoFar;
                 if (!filterDuplEnabled && leftActive && diff < maxSize / 10) {
                     countDuplicatedJoins++;
@@ -408,14 +607,9 @@ void GBRuleExecutor::leftjoin(
 
     //Sort the left segment by the join variable
     if (!fields1.empty() && !inputLeft->isSortedBy(fields1)) {
-        if (enableCacheLeft && nodesLeft.size() > 0 && fields1.size() == 1) {
+        if (enableCacheLeft && nodesLeft.size() > 0) {
             SegmentCache &c = SegmentCache::getInstance();
-            if (!c.contains(nodesLeft, fields1)) {
-                inputLeft = inputLeft->sortBy(fields1);
-                c.insert(nodesLeft, fields1, inputLeft);
-            } else {
-                inputLeft = c.get(nodesLeft, fields1);
-            }
+            inputLeft = c.getSorted(nodesLeft, fields1, inputLeft);
         } else {
             inputLeft = inputLeft->sortBy(fields1);
         }
@@ -423,7 +617,10 @@ void GBRuleExecutor::leftjoin(
     auto itrLeft = inputLeft->iterator();
 
     //Get all the triples in the right relation
-    auto sortedInputRight = inputRight->sortBy(fields2);
+    std::shared_ptr<const TGSegment> sortedInputRight = inputRight;
+    if (!inputRight->isSortedBy(fields2)) {
+        sortedInputRight = inputRight->sortBy(fields2);
+    }
     auto itrRight = sortedInputRight->iterator();
 
     bool leftActive = false;
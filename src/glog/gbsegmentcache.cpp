@@ -1,3 +1,206 @@
 #include <glog/gbsegmentcache.h>
+#include <glog/gbsegment.h>
+
+#include <kognac/utils.h>
+
+#include <cmath>
 
 SegmentCache SegmentCache::instance;
+
+SegmentCache::SegmentCache() : currentSize(0), hits(0), misses(0),
+    evictions(0) {
+    maxSize = (size_t)SEGMENTCACHE_DEFAULT_SIZE * 1024 * 1024;
+    if (maxSize == 0) {
+        maxSize = Utils::getSystemMemory() / 4;
+    }
+}
+
+size_t SegmentCache::estimateSize(const TGSegment &seg) {
+    return seg.getSizeInBytes();
+}
+
+void SegmentCache::setMaxSize(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxSize = bytes;
+    evict(0);
+}
+
+size_t SegmentCache::getMaxSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxSize;
+}
+
+size_t SegmentCache::getSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentSize;
+}
+
+size_t SegmentCache::getNEntries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void SegmentCache::evict(size_t sizeToAdd) {
+    //Evict entries until the new one fits in the budget. Among the least
+    //recently used entries, remove the one that is the least useful, i.e.,
+    //that was hit the fewest times w.r.t. its size and the cost of sorting
+    //it again.
+    while (!lru.empty() && currentSize + sizeToAdd > maxSize) {
+        auto victim = std::prev(lru.end());
+        double victimScore = -1;
+        auto itr = lru.end();
+        for (size_t i = 0; i < SEGMENTCACHE_EVICTION_WINDOW &&
+                itr != lru.begin(); ++i) {
+            itr--;
+            const auto &v = entries.at(*itr);
+            double score = (v.hits + 1) * v.cost / (v.size + 1);
+            if (victimScore < 0 || score < victimScore) {
+                victimScore = score;
+                victim = itr;
+            }
+        }
+        auto e = entries.find(*victim);
+        currentSize -= e->second.size;
+        entries.erase(e);
+        lru.erase(victim);
+        evictions++;
+    }
+}
+
+bool SegmentCache::contains(const std::vector<size_t> &key,
+        const std::vector<uint8_t> &fields) const {
+    CacheEntry k(key, fields);
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.count(k);
+}
+
+void SegmentCache::insert(const std::vector<size_t> &key,
+        const std::vector<uint8_t> &fields,
+        std::shared_ptr<const TGSegment> value) {
+    CacheEntry k(key, fields);
+    size_t size = estimateSize(*value.get());
+    size_t nrows = value->getNRows();
+    double cost = nrows * std::log2(nrows + 2);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t prevMisses = 0;
+    auto e = entries.find(k);
+    if (e != entries.end()) {
+        //Another thread computed the same segment in the meantime
+        prevMisses = e->second.misses;
+        currentSize -= e->second.size;
+        lru.erase(e->second.lruItr);
+        entries.erase(e);
+    }
+    if (size > maxSize) {
+        LOG(DEBUGL) << "The segment (" << size << " bytes) is too large to "
+            "be cached";
+        return;
+    }
+    evict(size);
+    lru.push_front(k);
+    CacheValue v;
+    v.seg = value;
+    v.size = size;
+    v.cost = cost;
+    v.hits = 0;
+    v.misses = prevMisses + 1;
+    v.lruItr = lru.begin();
+    entries.insert(std::make_pair(k, v));
+    currentSize += size;
+}
+
+std::shared_ptr<const TGSegment> SegmentCache::lookup(const CacheEntry &k) {
+    auto e = entries.find(k);
+    if (e == entries.end()) {
+        return std::shared_ptr<const TGSegment>();
+    }
+    hits++;
+    e->second.hits++;
+    lru.splice(lru.begin(), lru, e->second.lruItr);
+    return e->second.seg;
+}
+
+std::shared_ptr<const TGSegment> SegmentCache::get(
+        const std::vector<size_t> &key,
+        const std::vector<uint8_t> &fields) {
+    CacheEntry k(key, fields);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto out = lookup(k);
+    if (!out) {
+        misses++;
+    }
+    return out;
+}
+
+std::shared_ptr<const TGSegment> SegmentCache::getSorted(
+        const std::vector<size_t> &key,
+        std::vector<uint8_t> &fields,
+        std::shared_ptr<const TGSegment> input) {
+    CacheEntry k(key, fields);
+    std::promise<std::shared_ptr<const TGSegment>> promise;
+    std::shared_future<std::shared_ptr<const TGSegment>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto out = lookup(k);
+        if (out) {
+            return out;
+        }
+        auto f = inFlight.find(k);
+        if (f != inFlight.end()) {
+            //Another thread is sorting the same segment: wait for it
+            hits++;
+            pending = f->second;
+        } else {
+            misses++;
+            inFlight.insert(std::make_pair(k, promise.get_future().share()));
+        }
+    }
+    if (pending.valid()) {
+        return pending.get();
+    }
+
+    std::shared_ptr<const TGSegment> out;
+    try {
+        out = input->sortBy(fields);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight.erase(k);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+    insert(key, fields, out);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inFlight.erase(k);
+    }
+    promise.set_value(out);
+    return out;
+}
+
+void SegmentCache::printStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t totalEntries = hits + misses;
+    LOG(INFOL) << "Segment cache: hits=" << hits << " misses=" << misses <<
+        " hitratio=" << (totalEntries > 0 ? (double)hits / totalEntries : 0) <<
+        " evictions=" << evictions << " entries=" << entries.size() <<
+        " size(MB)=" << currentSize / 1024 / 1024 << " maxsize(MB)=" <<
+        maxSize / 1024 / 1024;
+#ifdef DEBUG
+    for(const auto &e : entries) {
+        LOG(DEBUGL) << "Cache entry with " << e.first.getNNodes() <<
+            " nodes: size=" << e.second.size << " hits=" << e.second.hits <<
+            " misses=" << e.second.misses;
+    }
+#endif
+}
+
+void SegmentCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    lru.clear();
+    currentSize = 0;
+    hits = misses = evictions = 0;
+}
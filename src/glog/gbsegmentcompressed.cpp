@@ -0,0 +1,390 @@
+#include <glog/gbsegmentcompressed.h>
+#include <glog/gbsegmentinserter.h>
+#include <glog/gbsegmentserializer.h>
+
+TGPackedColumn::TGPackedColumn(const std::vector<Term_t> &values) :
+    nvalues(values.size()) {
+    std::vector<uint64_t> packed;
+    for(size_t begin = 0; begin < values.size();
+            begin += COMPRSEGMENT_BLOCK_SIZE) {
+        const size_t end = std::min(values.size(),
+                begin + COMPRSEGMENT_BLOCK_SIZE);
+        Term_t min = values[begin];
+        Term_t max = values[begin];
+        Term_t maxDelta = 0;
+        bool sorted = true;
+        for(size_t i = begin + 1; i < end; ++i) {
+            const auto v = values[i];
+            if (v < min)
+                min = v;
+            if (v > max)
+                max = v;
+            if (v < values[i - 1]) {
+                sorted = false;
+            } else if (v - values[i - 1] > maxDelta) {
+                maxDelta = v - values[i - 1];
+            }
+        }
+
+        Block b;
+        b.start = words.size();
+        const uint8_t bitsFOR = getNBits(max - min);
+        const uint8_t bitsDelta = getNBits(maxDelta);
+        b.delta = sorted && bitsDelta < bitsFOR;
+        packed.clear();
+        if (b.delta) {
+            b.base = values[begin];
+            b.bits = bitsDelta;
+            packed.push_back(0);
+            for(size_t i = begin + 1; i < end; ++i) {
+                packed.push_back(values[i] - values[i - 1]);
+            }
+        } else {
+            b.base = min;
+            b.bits = bitsFOR;
+            for(size_t i = begin; i < end; ++i) {
+                packed.push_back(values[i] - min);
+            }
+        }
+        blocks.push_back(b);
+        pack(packed, b.bits);
+    }
+    words.shrink_to_fit();
+}
+
+void TGPackedColumn::pack(const std::vector<uint64_t> &values,
+        uint8_t bits) {
+    if (bits == 0)
+        return;
+    const size_t start = words.size();
+    words.resize(start + (values.size() * bits + 63) / 64, 0);
+    uint64_t bitpos = 0;
+    for(auto v : values) {
+        const uint64_t w = start + bitpos / 64;
+        const uint64_t off = bitpos % 64;
+        words[w] |= v << off;
+        if (off + bits > 64)
+            words[w + 1] |= v >> (64 - off);
+        bitpos += bits;
+    }
+}
+
+size_t TGPackedColumn::decode(size_t blockIdx, Term_t *out) const {
+    const Block &b = blocks[blockIdx];
+    const size_t n = std::min((size_t)COMPRSEGMENT_BLOCK_SIZE,
+            nvalues - blockIdx * COMPRSEGMENT_BLOCK_SIZE);
+    if (b.delta) {
+        Term_t v = b.base;
+        for(size_t i = 0; i < n; ++i) {
+            v += unpack(b, i);
+            out[i] = v;
+        }
+    } else {
+        for(size_t i = 0; i < n; ++i) {
+            out[i] = b.base + unpack(b, i);
+        }
+    }
+    return n;
+}
+
+Term_t TGPackedColumn::get(size_t idx) const {
+    const Block &b = blocks[idx / COMPRSEGMENT_BLOCK_SIZE];
+    const size_t pos = idx % COMPRSEGMENT_BLOCK_SIZE;
+    if (b.delta) {
+        Term_t v = b.base;
+        for(size_t i = 1; i <= pos; ++i) {
+            v += unpack(b, i);
+        }
+        return v;
+    } else {
+        return b.base + unpack(b, pos);
+    }
+}
+
+TGSegmentCompressed::TGSegmentCompressed(const TGSegment &seg) :
+    nodeId(seg.getNodeId()),
+    nrows(seg.getNRows()),
+    ncols(seg.getNColumns()),
+    nprovcols(GBSegmentSerializer::getNProvColumns(seg)),
+    nOffsetColumns(seg.getNOffsetColumns()),
+    provenanceType(seg.getProvenanceType()) {
+    //Copy the rows column by column, as in GBSegmentSerializer
+    const size_t noffcols = nprovcols > 0 ? nprovcols - 1 : 0;
+    std::vector<std::vector<Term_t>> values(ncols + noffcols);
+    for(auto &c : values)
+        c.reserve(nrows);
+    size_t row = 0;
+    auto itr = seg.iterator();
+    while (itr->hasNext()) {
+        itr->next();
+        for(size_t i = 0; i < ncols; ++i) {
+            values[i].push_back(itr->get(i));
+        }
+        for(size_t i = 0; i < noffcols; ++i) {
+            values[ncols + i].push_back(itr->getProvenanceOffset(0, i));
+        }
+        if (nprovcols > 0) {
+            const size_t node = itr->getNodeId();
+            if (nodeRuns.empty() || nodeRuns.back().second != node) {
+                nodeRuns.push_back(std::make_pair(row, node));
+            }
+        }
+        row++;
+    }
+    assert(row == nrows);
+    for(auto &c : values) {
+        columns.emplace_back(c);
+        std::vector<Term_t>().swap(c);
+    }
+    nodeRuns.shrink_to_fit();
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::compress(
+        std::shared_ptr<const TGSegment> seg) {
+    if (seg->getNRows() < COMPRSEGMENT_MIN_ROWS || !seg->isSorted() ||
+            seg->containsMultipleProofs() || seg->hasColumnarBackend() ||
+            seg->getName() == "TGSegmentCompressed" ||
+            seg->getName() == "TGSegmentSpilled") {
+        return seg;
+    }
+    std::shared_ptr<const TGSegmentCompressed> out(
+            new TGSegmentCompressed(*seg.get()));
+    const size_t uncompressedSize = seg->getNRows() * sizeof(Term_t) *
+        (seg->getNColumns() + GBSegmentSerializer::getNProvColumns(*seg.get()));
+    if (out->getSizeInBytes() >= uncompressedSize) {
+        return seg;
+    }
+    return out;
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::decompress() const {
+    std::lock_guard<std::mutex> lock(mtxDecompressed);
+    if (decompressed) {
+        return decompressed;
+    }
+    //Recreate the segment in the same way the chase does
+    const size_t rowSize = ncols + nprovcols;
+    auto ins = GBSegmentInserter::getInserter(rowSize, nprovcols, false);
+    std::unique_ptr<Term_t[]> row(new Term_t[rowSize]);
+    auto itr = iterator();
+    while (itr->hasNext()) {
+        itr->next();
+        for(size_t i = 0; i < ncols; ++i) {
+            row[i] = itr->get(i);
+        }
+        if (nprovcols > 0) {
+            row[ncols] = itr->getNodeId();
+        }
+        for(size_t i = 1; i < nprovcols; ++i) {
+            row[ncols + i] = itr->getProvenanceOffset(0, i - 1);
+        }
+        ins->add(row.get());
+    }
+    decompressed = ins->getSegment(nodeId, true, 0, provenanceType, nprovcols);
+    return decompressed;
+}
+
+void TGSegmentCompressed::releaseDecompressed() const {
+    std::lock_guard<std::mutex> lock(mtxDecompressed);
+    decompressed.reset();
+}
+
+bool TGSegmentCompressed::isDecompressed() const {
+    std::lock_guard<std::mutex> lock(mtxDecompressed);
+    return decompressed != NULL;
+}
+
+size_t TGSegmentCompressed::getSizeInBytes() const {
+    size_t size = nodeRuns.size() * sizeof(std::pair<size_t, size_t>);
+    for(const auto &c : columns) {
+        size += c.getSizeInBytes();
+    }
+    std::lock_guard<std::mutex> lock(mtxDecompressed);
+    if (decompressed) {
+        size += decompressed->getSizeInBytes();
+    }
+    return size;
+}
+
+size_t TGSegmentCompressed::getNodeAtRow(size_t rowIdx, size_t &runIdx) const {
+    if (nodeRuns.empty()) {
+        return nodeId;
+    }
+    //Rows are mostly accessed in order, so first try the runs close to the
+    //last one
+    if (runIdx >= nodeRuns.size() || nodeRuns[runIdx].first > rowIdx) {
+        runIdx = 0;
+    }
+    if (runIdx + 1 < nodeRuns.size() && nodeRuns[runIdx + 1].first <= rowIdx) {
+        auto itr = std::upper_bound(nodeRuns.begin() + runIdx, nodeRuns.end(),
+                std::make_pair(rowIdx, ~0ul));
+        runIdx = itr - nodeRuns.begin() - 1;
+    }
+    return nodeRuns[runIdx].second;
+}
+
+bool TGSegmentCompressed::isSortedBy(std::vector<uint8_t> &fields) const {
+    for(size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i] != i)
+            return false;
+    }
+    return true;
+}
+
+std::unique_ptr<TGSegmentItr> TGSegmentCompressed::iterator(
+        std::shared_ptr<const TGSegment> selfref) const {
+    return std::unique_ptr<TGSegmentItr>(new TGSegmentCompressedItr(*this,
+                selfref, columns.size()));
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::sort() const {
+    return decompress();
+}
+
+void TGSegmentCompressed::argsort(std::vector<size_t> &idxs) const {
+    decompress()->argsort(idxs);
+}
+
+std::shared_ptr<TGSegment> TGSegmentCompressed::sortBy(
+        std::vector<uint8_t> &fields) const {
+    return decompress()->sortBy(fields);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::sortByProv(size_t ncols,
+        std::vector<size_t> &idxs,
+        std::vector<size_t> &nodes) const {
+    return decompress()->sortByProv(ncols, idxs, nodes);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::sortByProv() const {
+    return decompress()->sortByProv();
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::unique() const {
+    return decompress()->unique();
+}
+
+void TGSegmentCompressed::argunique(std::vector<size_t> &idxs) const {
+    decompress()->argunique(idxs);
+}
+
+void TGSegmentCompressed::projectTo(const std::vector<int> &posFields,
+        std::vector<std::shared_ptr<Column>> &out) const {
+    decompress()->projectTo(posFields, out);
+}
+
+size_t TGSegmentCompressed::countHits(const std::vector<Term_t> &terms,
+        int column) const {
+    return decompress()->countHits(terms, column);
+}
+
+size_t TGSegmentCompressed::countHits(const std::vector<
+        std::pair<Term_t,Term_t>> &terms,
+        int column1, int column2) const {
+    return decompress()->countHits(terms, column1, column2);
+}
+
+std::shared_ptr<TGSegment> TGSegmentCompressed::slice(const size_t nodeId,
+        const size_t start,
+        const size_t end) const {
+    return decompress()->slice(nodeId, start, end);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::slice(const size_t start,
+        const size_t end) const {
+    return decompress()->slice(start, end);
+}
+
+std::vector<std::shared_ptr<const TGSegment>> TGSegmentCompressed::sliceByNodes(
+        size_t startNodeIdx,
+        std::vector<size_t> &provNodes) const {
+    return decompress()->sliceByNodes(startNodeIdx, provNodes);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentCompressed::shuffle(
+        const std::vector<size_t> &idxs) const {
+    return decompress()->shuffle(idxs);
+}
+
+std::shared_ptr<TGSegment> TGSegmentCompressed::swap() const {
+    return decompress()->swap();
+}
+
+void TGSegmentCompressed::appendTo(uint8_t colPos,
+        std::vector<Term_t> &out) const {
+    //Decode the blocks directly in the output
+    const auto &c = columns[colPos];
+    size_t start = out.size();
+    out.resize(start + nrows + COMPRSEGMENT_BLOCK_SIZE);
+    for(size_t b = 0; b * COMPRSEGMENT_BLOCK_SIZE < nrows; ++b) {
+        start += c.decode(b, out.data() + start);
+    }
+    out.resize(start);
+}
+
+void TGSegmentCompressed::appendTo(uint8_t colPos,
+        std::vector<std::pair<Term_t, Term_t>> &out) const {
+    decompress()->appendTo(colPos, out);
+}
+
+void TGSegmentCompressed::appendTo(uint8_t colPos,
+        std::vector<UnWithFullProv> &out) const {
+    decompress()->appendTo(colPos, out);
+}
+
+void TGSegmentCompressed::appendTo(uint8_t colPos1, uint8_t colPos2,
+        std::vector<std::pair<Term_t,Term_t>> &out) const {
+    Term_t values1[COMPRSEGMENT_BLOCK_SIZE];
+    Term_t values2[COMPRSEGMENT_BLOCK_SIZE];
+    out.reserve(out.size() + nrows);
+    for(size_t b = 0; b * COMPRSEGMENT_BLOCK_SIZE < nrows; ++b) {
+        const size_t n = columns[colPos1].decode(b, values1);
+        columns[colPos2].decode(b, values2);
+        for(size_t i = 0; i < n; ++i) {
+            out.push_back(std::make_pair(values1[i], values2[i]));
+        }
+    }
+}
+
+void TGSegmentCompressed::appendTo(uint8_t colPos1, uint8_t colPos2,
+        std::vector<BinWithProv> &out) const {
+    decompress()->appendTo(colPos1, colPos2, out);
+}
+
+void TGSegmentCompressed::appendTo(uint8_t colPos1, uint8_t colPos2,
+        std::vector<BinWithFullProv> &out) const {
+    decompress()->appendTo(colPos1, colPos2, out);
+}
+
+void TGSegmentCompressed::appendTo(const std::vector<int> &posFields,
+        std::vector<std::vector<Term_t>> &out,
+        bool withProv) const {
+    decompress()->appendTo(posFields, out, withProv);
+}
+
+std::vector<Term_t> TGSegmentCompressed::getRow(size_t rowIdx,
+        bool addProv) const {
+    std::vector<Term_t> out;
+    for(size_t i = 0; i < ncols; ++i) {
+        out.push_back(columns[i].get(rowIdx));
+    }
+    if (addProv && nprovcols > 0) {
+        size_t runIdx = 0;
+        out.push_back(getNodeAtRow(rowIdx, runIdx));
+        for(size_t i = ncols; i < columns.size(); ++i) {
+            out.push_back(columns[i].get(rowIdx));
+        }
+    }
+    return out;
+}
+
+Term_t TGSegmentCompressed::getOffsetAtRow(size_t rowIdx, size_t proofNr,
+        size_t offsetColumnIdx) const {
+    assert(proofNr == 0);
+    assert(ncols + offsetColumnIdx < columns.size());
+    return columns[ncols + offsetColumnIdx].get(rowIdx);
+}
+
+Term_t TGSegmentCompressed::getValueAtRow(size_t rowIdx, size_t colIdx) const {
+    return columns[colIdx].get(rowIdx);
+}
@@ -2,31 +2,35 @@
 #include <glog/gbsegmentcomprprov.h>
 #include <glog/gbsegment.h>
 
+#include <numeric>
+
 std::unique_ptr<GBSegmentInserter> GBSegmentInserter::getInserter(size_t card,
         size_t nodeColumns,
         bool delDupl) {
+    std::unique_ptr<GBSegmentInserter> out;
     if (card - nodeColumns == 0) {
-        return std::unique_ptr<GBSegmentInserter>(
+        out = std::unique_ptr<GBSegmentInserter>(
                 new GBSegmentInserterNAry(card, card - nodeColumns, delDupl));
     } else if (card == 1) {
-        return std::unique_ptr<GBSegmentInserter>(new GBSegmentInserterUnary(
+        out = std::unique_ptr<GBSegmentInserter>(new GBSegmentInserterUnary(
                     delDupl));
     } else if (card == 2) {
-        return std::unique_ptr<GBSegmentInserter>(
+        out = std::unique_ptr<GBSegmentInserter>(
                 new GBSegmentInserterBinary(delDupl));
     } else if (card > 2) {
         if (card == 4 && nodeColumns == 2 && delDupl) {
-            return std::unique_ptr<GBSegmentInserter>(
+            out = std::unique_ptr<GBSegmentInserter>(
                     new GBSegmentInserterBinaryWithDoubleProv(delDupl));
         } else {
-            return std::unique_ptr<GBSegmentInserter>(
+            out = std::unique_ptr<GBSegmentInserter>(
                     new GBSegmentInserterNAry(card, card - nodeColumns, delDupl));
         }
     } else {
         //singleton
-        return std::unique_ptr<GBSegmentInserter>(
+        out = std::unique_ptr<GBSegmentInserter>(
                 new GBSegmentInserterNAry(card, card - nodeColumns, delDupl));
     }
+    return out;
 }
 
 std::shared_ptr<const TGSegment> GBSegmentInserter::compressProvNode(
@@ -78,6 +82,50 @@ std::shared_ptr<const TGSegment> GBSegmentInserter::compressProvNode(
 }
 
 void GBSegmentInserter::add(Term_t *row) {
+    if (!fns.empty()) {
+        //The builtin functions are evaluated on blocks of rows
+        pendingRows.insert(pendingRows.end(), row, row + rowSize);
+        nPendingRows++;
+        if (nPendingRows >= BUILTIN_BLOCK_SIZE) {
+            flush();
+        }
+    } else {
+        addIfNotDuplicate(row);
+    }
+}
+
+void GBSegmentInserter::flush() {
+    if (nPendingRows == 0) {
+        return;
+    }
+    selection.resize(nPendingRows);
+    std::iota(selection.begin(), selection.end(), 0);
+    for(auto &fn : fns) {
+        if (selection.empty()) {
+            break;
+        }
+        if (fn.fnBlock) {
+            fn.fnBlock(pendingRows.data(), rowSize, fn.posArgs.data(),
+                    selection);
+        } else {
+            size_t nselected = 0;
+            for(size_t i = 0; i < selection.size(); ++i) {
+                if (fn.fn(pendingRows.data() + selection[i] * rowSize,
+                            fn.posArgs.data())) {
+                    selection[nselected++] = selection[i];
+                }
+            }
+            selection.resize(nselected);
+        }
+    }
+    for(auto idx : selection) {
+        addIfNotDuplicate(pendingRows.data() + idx * rowSize);
+    }
+    pendingRows.clear();
+    nPendingRows = 0;
+}
+
+void GBSegmentInserter::addIfNotDuplicate(Term_t *row) {
     if (shouldRemoveDuplicates) {
         processedRecords++;
         if (processedRecords % 10000000 == 0)
@@ -110,42 +158,22 @@ void GBSegmentInserter::add(Term_t *row) {
         }
     }
 
-    bool ok = true;
-    for(auto &fn : fns) {
-        if (!fn.fn(row, fn.posArgs.data())) {
-            ok = false;
-            break;
-        }
-    }
-    if (ok)
-        addRow(row);
+    addRow(row);
 }
 
 bool GBSegmentInserterNAry::isInMap(Term_t *row) {
-    if (cardCheckDuplicates == 1) {
-        throw 10;
-    } else if (cardCheckDuplicates == 2) {
-        return s_binary.count(std::make_pair(row[0], row[1]));
-    } else {
-        throw 10;
-        //return s.isIn(row);
-    }
+    return s.contains(row);
 }
 
 void GBSegmentInserterNAry::populateMap() {
     std::unique_ptr<Term_t[]> row = std::unique_ptr<Term_t[]>(new Term_t[cardCheckDuplicates]);
+    s.reserve(addedRows);
     for(size_t i = 0; i < addedRows; ++i) {
         for(size_t j = 0; j < cardCheckDuplicates; ++j) {
             row[j] = writers[j].getValue(i);
         }
-        if (cardCheckDuplicates == 1) {
-            throw 10;
-        } else if (cardCheckDuplicates == 2) {
-            s_binary.insert(std::make_pair(row[0], row[1]));
-        } else {
-            throw 10;
-            //s.add(row.get());
-        }
+        bool inserted;
+        s.insert(row.get(), inserted);
     }
 }
 
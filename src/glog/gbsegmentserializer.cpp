@@ -0,0 +1,88 @@
+#include <glog/gbsegmentserializer.h>
+#include <glog/gbsegmentinserter.h>
+
+#define SEGMENT_FLAG_SORTED 1
+
+size_t GBSegmentSerializer::getNProvColumns(const TGSegment &seg) {
+    switch (seg.getProvenanceType()) {
+        case SEG_NOPROV:
+            return 0;
+        case SEG_FULLPROV:
+            //The node plus the offsets
+            return std::max((size_t)1, seg.getNOffsetColumns());
+        default:
+            return 1;
+    }
+}
+
+void GBSegmentSerializer::write(std::ostream &out,
+        std::shared_ptr<const TGSegment> seg) {
+    if (seg->containsMultipleProofs()) {
+        LOG(ERRORL) << "Segments with multiple proofs per row cannot be "
+            "serialized";
+        throw 10;
+    }
+    const size_t nrows = seg->getNRows();
+    const size_t ncols = seg->getNColumns();
+    const size_t nprovcols = getNProvColumns(*seg.get());
+    writeWord(out, nrows);
+    writeWord(out, ncols);
+    writeWord(out, nprovcols);
+    writeWord(out, seg->getProvenanceType());
+    writeWord(out, seg->isSorted() ? SEGMENT_FLAG_SORTED : 0);
+
+    //Copy the rows column by column
+    std::vector<std::vector<Term_t>> columns(ncols + nprovcols);
+    for(auto &c : columns)
+        c.reserve(nrows);
+    auto itr = seg->iterator();
+    while (itr->hasNext()) {
+        itr->next();
+        for(size_t i = 0; i < ncols; ++i) {
+            columns[i].push_back(itr->get(i));
+        }
+        if (nprovcols > 0) {
+            columns[ncols].push_back(itr->getNodeId());
+        }
+        for(size_t i = 1; i < nprovcols; ++i) {
+            columns[ncols + i].push_back(itr->getProvenanceOffset(0, i - 1));
+        }
+    }
+    for(auto &c : columns) {
+        assert(c.size() == nrows);
+        out.write((const char*)c.data(), sizeof(Term_t) * c.size());
+    }
+}
+
+std::shared_ptr<const TGSegment> GBSegmentSerializer::read(std::istream &in,
+        size_t nodeId) {
+    const size_t nrows = readWord(in);
+    const size_t ncols = readWord(in);
+    const size_t nprovcols = readWord(in);
+    const SegProvenanceType provenanceType = (SegProvenanceType)readWord(in);
+    const uint64_t flags = readWord(in);
+
+    const size_t rowSize = ncols + nprovcols;
+    std::vector<std::vector<Term_t>> columns(rowSize);
+    for(auto &c : columns) {
+        c.resize(nrows);
+        in.read((char*)c.data(), sizeof(Term_t) * nrows);
+        if (!in) {
+            LOG(ERRORL) << "Unexpected end of file";
+            throw 10;
+        }
+    }
+
+    //Recreate the segment in the same way the chase does
+    auto ins = GBSegmentInserter::getInserter(rowSize, nprovcols, false);
+    std::unique_ptr<Term_t[]> row = std::unique_ptr<Term_t[]>(
+            new Term_t[rowSize]);
+    for(size_t i = 0; i < nrows; ++i) {
+        for(size_t j = 0; j < rowSize; ++j) {
+            row[j] = columns[j][i];
+        }
+        ins->add(row.get());
+    }
+    return ins->getSegment(nodeId, flags & SEGMENT_FLAG_SORTED, 0,
+            provenanceType, nprovcols);
+}
@@ -0,0 +1,261 @@
+#include <glog/gbsegmentspilled.h>
+#include <glog/gbsegmentserializer.h>
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+
+//Input stream over a region of the memory mapping
+struct GBSpillBuffer : public std::streambuf {
+    GBSpillBuffer(char *begin, char *end) {
+        setg(begin, begin, end);
+    }
+};
+
+GBSpillFile::GBSpillFile(const std::string &path) : path(path), fileSize(0),
+    fd(-1), mapped(NULL), mappedSize(0) {
+    out.open(path, std::ios_base::binary | std::ios_base::trunc);
+    if (!out) {
+        LOG(ERRORL) << "Cannot create the spill file " << path;
+        throw 10;
+    }
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        LOG(ERRORL) << "Cannot open the spill file " << path;
+        throw 10;
+    }
+}
+
+size_t GBSpillFile::write(std::shared_ptr<const TGSegment> seg) {
+    size_t offset = fileSize;
+    GBSegmentSerializer::write(out, seg);
+    if (!out) {
+        LOG(ERRORL) << "Error while writing the spill file " << path;
+        throw 10;
+    }
+    fileSize = out.tellp();
+    return offset;
+}
+
+void GBSpillFile::unmap() {
+    if (mapped != NULL) {
+        munmap(mapped, mappedSize);
+        mapped = NULL;
+        mappedSize = 0;
+    }
+}
+
+void GBSpillFile::map() {
+    if (fileSize == mappedSize)
+        return;
+    out.flush();
+    unmap();
+    void *addr = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        LOG(ERRORL) << "Cannot map the spill file " << path;
+        throw 10;
+    }
+    mapped = (char*)addr;
+    mappedSize = fileSize;
+}
+
+std::shared_ptr<const TGSegment> GBSpillFile::read(size_t offset,
+        size_t nodeId) const {
+    assert(offset < mappedSize);
+    GBSpillBuffer buffer(mapped + offset, mapped + mappedSize);
+    std::istream in(&buffer);
+    return GBSegmentSerializer::read(in, nodeId);
+}
+
+GBSpillFile::~GBSpillFile() {
+    unmap();
+    if (fd != -1)
+        close(fd);
+    out.close();
+    std::remove(path.c_str());
+}
+
+TGSegmentSpilled::TGSegmentSpilled(std::shared_ptr<GBSpillFile> file,
+        std::shared_ptr<const TGSegment> seg,
+        size_t step) :
+    file(file),
+    offset(file->write(seg)),
+    nodeId(seg->getNodeId()),
+    nrows(seg->getNRows()),
+    ncols(seg->getNColumns()),
+    nOffsetColumns(seg->getNOffsetColumns()),
+    provenanceType(seg->getProvenanceType()),
+    f_isSorted(seg->isSorted()),
+    f_isNodeConstant(seg->isNodeConstant()),
+    naccesses(0),
+    lastNAccesses(0),
+    lastAccessStep(step) {
+    }
+
+std::shared_ptr<const TGSegment> TGSegmentSpilled::load() const {
+    naccesses++;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) {
+        LOG(DEBUGL) << "Loading node " << nodeId << " from the spill file";
+        loaded = file->read(offset, nodeId);
+    }
+    return loaded;
+}
+
+bool TGSegmentSpilled::isLoaded() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return loaded != NULL;
+}
+
+void TGSegmentSpilled::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    loaded.reset();
+}
+
+bool TGSegmentSpilled::isCold(size_t step, size_t coldSteps) {
+    size_t n = naccesses.load();
+    if (n != lastNAccesses) {
+        lastNAccesses = n;
+        lastAccessStep = step;
+    }
+    return step >= lastAccessStep + coldSteps;
+}
+
+size_t TGSegmentSpilled::getSizeInBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return loaded ? loaded->getSizeInBytes() : 0;
+}
+
+std::unique_ptr<TGSegmentItr> TGSegmentSpilled::iterator(
+        std::shared_ptr<const TGSegment> selfref) const {
+    auto seg = load();
+    return seg->iterator(seg);
+}
+
+bool TGSegmentSpilled::isSortedBy(std::vector<uint8_t> &fields) const {
+    return load()->isSortedBy(fields);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentSpilled::sort() const {
+    return load()->sort();
+}
+
+void TGSegmentSpilled::argsort(std::vector<size_t> &idxs) const {
+    load()->argsort(idxs);
+}
+
+std::shared_ptr<TGSegment> TGSegmentSpilled::sortBy(
+        std::vector<uint8_t> &fields) const {
+    return load()->sortBy(fields);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentSpilled::sortByProv(size_t ncols,
+        std::vector<size_t> &idxs,
+        std::vector<size_t> &nodes) const {
+    return load()->sortByProv(ncols, idxs, nodes);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentSpilled::sortByProv() const {
+    return load()->sortByProv();
+}
+
+std::shared_ptr<const TGSegment> TGSegmentSpilled::unique() const {
+    return load()->unique();
+}
+
+void TGSegmentSpilled::argunique(std::vector<size_t> &idxs) const {
+    load()->argunique(idxs);
+}
+
+void TGSegmentSpilled::projectTo(const std::vector<int> &posFields,
+        std::vector<std::shared_ptr<Column>> &out) const {
+    load()->projectTo(posFields, out);
+}
+
+size_t TGSegmentSpilled::countHits(const std::vector<Term_t> &terms,
+        int column) const {
+    return load()->countHits(terms, column);
+}
+
+size_t TGSegmentSpilled::countHits(const std::vector<
+        std::pair<Term_t,Term_t>> &terms,
+        int column1, int column2) const {
+    return load()->countHits(terms, column1, column2);
+}
+
+std::shared_ptr<TGSegment> TGSegmentSpilled::slice(const size_t nodeId,
+        const size_t start,
+        const size_t end) const {
+    return load()->slice(nodeId, start, end);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentSpilled::slice(const size_t start,
+        const size_t end) const {
+    return load()->slice(start, end);
+}
+
+std::vector<std::shared_ptr<const TGSegment>> TGSegmentSpilled::sliceByNodes(
+        size_t startNodeIdx,
+        std::vector<size_t> &provNodes) const {
+    return load()->sliceByNodes(startNodeIdx, provNodes);
+}
+
+std::shared_ptr<const TGSegment> TGSegmentSpilled::shuffle(
+        const std::vector<size_t> &idxs) const {
+    return load()->shuffle(idxs);
+}
+
+std::shared_ptr<TGSegment> TGSegmentSpilled::swap() const {
+    return load()->swap();
+}
+
+void TGSegmentSpilled::appendTo(uint8_t colPos,
+        std::vector<Term_t> &out) const {
+    load()->appendTo(colPos, out);
+}
+
+void TGSegmentSpilled::appendTo(uint8_t colPos,
+        std::vector<std::pair<Term_t, Term_t>> &out) const {
+    load()->appendTo(colPos, out);
+}
+
+void TGSegmentSpilled::appendTo(uint8_t colPos,
+        std::vector<UnWithFullProv> &out) const {
+    load()->appendTo(colPos, out);
+}
+
+void TGSegmentSpilled::appendTo(uint8_t colPos1, uint8_t colPos2,
+        std::vector<std::pair<Term_t,Term_t>> &out) const {
+    load()->appendTo(colPos1, colPos2, out);
+}
+
+void TGSegmentSpilled::appendTo(uint8_t colPos1, uint8_t colPos2,
+        std::vector<BinWithProv> &out) const {
+    load()->appendTo(colPos1, colPos2, out);
+}
+
+void TGSegmentSpilled::appendTo(uint8_t colPos1, uint8_t colPos2,
+        std::vector<BinWithFullProv> &out) const {
+    load()->appendTo(colPos1, colPos2, out);
+}
+
+void TGSegmentSpilled::appendTo(const std::vector<int> &posFields,
+        std::vector<std::vector<Term_t>> &out,
+        bool withProv) const {
+    load()->appendTo(posFields, out, withProv);
+}
+
+std::vector<Term_t> TGSegmentSpilled::getRow(size_t rowIdx,
+        bool addProv) const {
+    return load()->getRow(rowIdx, addProv);
+}
+
+Term_t TGSegmentSpilled::getOffsetAtRow(size_t rowIdx, size_t proofNr,
+        size_t offsetColumnIdx) const {
+    return load()->getOffsetAtRow(rowIdx, proofNr, offsetColumnIdx);
+}
+
+Term_t TGSegmentSpilled::getValueAtRow(size_t rowIdx, size_t colIdx) const {
+    return load()->getValueAtRow(rowIdx, colIdx);
+}
@@ -80,23 +80,16 @@ void ProbGBChase::prepareRuleExecutionPlans(
     }
 }
 
-bool ProbGBChase::executeRule(GBRuleInput &node, bool cleanDuplicates)
+bool ProbGBChase::commitRuleExecution(GBRuleInput &node,
+        GBRuleExecution &execution,
+        bool cleanDuplicates)
 {
     Rule &rule = rules[node.ruleIdx];
-//#ifdef DEBUG
     if (rule.isEGD()) {
         throw 10; //Not supported here
     }
-    LOG(DEBUGL) << "Executing rule " << node.ruleIdx << " "
-        << rule.tostring(program, &layer);
-//#endif
-
-    std::chrono::system_clock::time_point start =
-        std::chrono::system_clock::now();
-    auto outputsRule = executor->executeRule(rule, node);
-    std::chrono::duration<double, std::milli> execRuntime =
-        std::chrono::system_clock::now() - start;
-    durationRuleExec += execRuntime;
+    auto &outputsRule = execution.outputs;
+    durationRuleExec += execution.durationExec;
 
     std::chrono::system_clock::time_point starth =
         std::chrono::system_clock::now();
@@ -138,20 +131,14 @@ bool ProbGBChase::executeRule(GBRuleInput &node, bool cleanDuplicates)
         std::chrono::duration<double, std::milli> retainRuntime =
             std::chrono::system_clock::now() - starth;
         std::chrono::duration<double, std::milli> totalRuntime =
-            std::chrono::system_clock::now() - start;
+            execution.durationExec + retainRuntime;
 
         StatsRule stats;
-        stats.step = node.step;
-        stats.idRule = node.ruleIdx;
+        fillStatsRule(stats, node, execution, starth);
         stats.nderivations_final = nders;
         stats.nderivations_unfiltered = nders_un;
         stats.timems = totalRuntime.count();
-        stats.timems_first = executor->getDuration(DurationType::DUR_FIRST).count();
-        stats.timems_merge = executor->getDuration(DurationType::DUR_MERGE).count();
-        stats.timems_join = executor->getDuration(DurationType::DUR_JOIN).count();
-        stats.timems_createhead = executor->getDuration(DurationType::DUR_HEAD).count();
         stats.timems_retain = retainRuntime.count();
-        stats.nbdyatoms = executor->getStat(StatType::N_BDY_ATOMS);
         saveStatistics(stats);
     }
 
@@ -16,6 +16,8 @@
 
 #include <glog/gbchase.h>
 #include <glog/dfstandardchase.h>
+#include <glog/gbsegmentcache.h>
+#include <glog/gbsegmentspilled.h>
 
 #include <vlog/cycles/checker.h>
 
@@ -70,6 +72,7 @@ void printHelp(const char *programName, ProgramArgs &desc) {
     cout << "queryLiteral\t\t execute a Literal query." << endl;
     cout << "server\t\t starts in server mode." << endl;
     cout << "load\t\t load a Trident KB." << endl;
+    cout << "convert\t\t convert the CSV tables of the EDB layer in binary tables." << endl;
     cout << "gentq\t\t generate training queries from rules file." << endl;
     cout << "tat\t\t generate training queries and test them with a model." << endl;
     cout << "lookup\t\t lookup for values in the dictionary." << endl << endl;
@@ -99,7 +102,8 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv) {
             && cmd != "mat" && cmd != "mat_tg" && cmd != "rulesgraph" && cmd != "server" && cmd != "gentq" &&
             cmd != "tat" && cmd != "cycles" && cmd !="deps" && cmd != "trigger"
             && cmd != "gbchase" && cmd != "tgchase_static" && cmd != "tgchase"
-            && cmd != "tgchasefullprov" && cmd != "probtgchase") {
+            && cmd != "tgchasefullprov" && cmd != "probtgchase"
+            && cmd != "convert") {
         printErrorMsg("The command \"" + cmd + "\" is unknown.");
         return false;
     }
@@ -142,6 +146,11 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv) {
                 printErrorMsg("Both the -t and -n parameters are set, and this is ambiguous. Please choose either one or the other.");
                 return false;
             }
+        } else if (cmd == "convert") {
+            if (!vm.count("output")) {
+                printErrorMsg("The parameter -o (directory of the binary tables) is not set.");
+                return false;
+            }
         } else if (cmd == "load") {
             if (!vm.count("input") && !vm.count("comprinput")) {
                 printErrorMsg("The parameter -i (path to the triple files) is not set. Also --comprinput (file with the compressed triples) is not set.");
@@ -297,7 +306,7 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     query_options.add<string>("", "premat", "",
             "Pre-materialize the atoms in the file passed as argument. Default is '' (disabled).", false);
     query_options.add<bool>("","multithreaded", false,
-            "Run multithreaded (currently only supported for <mat>).", false);
+            "Run multithreaded (currently only supported for <mat> and the graph-based chases).", false);
     query_options.add<bool>("","restrictedChase", true,
             "Use the restricted chase if there are existential rules.", false);
     query_options.add<int>("", "nthreads", std::max((unsigned int)1, std::thread::hardware_concurrency() / 2),
@@ -320,11 +329,15 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     query_options.add<string>("","storemat_path", "",
             "Directory where to store all results of the materialization. Default is '' (disable).",false);
     query_options.add<string>("","storemat_format", "files",
-            "Format in which to dump the materialization. 'files' simply dumps the IDBs in files. 'csv' creates comma-separated files. 'db' creates a new RDF database. Default is 'files'.",false);
+            "Format in which to dump the materialization. 'files' simply dumps the IDBs in files. 'csv' creates comma-separated files. 'bin' stores the IDs in binary columnar files. 'db' creates a new RDF database. Default is 'files'.",false);
     query_options.add<bool>("","explain", false,
             "Explain the query instead of executing it. Default is false.",false);
     query_options.add<bool>("","decompressmat", false,
             "Decompress the results of the materialization when we write it to a file. Default is false.",false);
+    query_options.add<bool>("","gzipmat", false,
+            "Compress the files of the materialization with gzip (only for 'files', 'csv' and 'bin'). Default is false.",false);
+    query_options.add<bool>("","dedupmat", false,
+            "Remove the facts derived multiple times when the materialization of the trigger graph chase is stored on files. Default is false.",false);
 #if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
     query_options.add<bool>("","monitorThread", false,
             "Launch an additional thread which prints statistics about resource usage on the console. Uses the DEBUL level so logging must be properly instructed. Default is false.",false);
@@ -334,9 +347,12 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     query_options.add<bool>("","webinterface", false,
             "Start a web interface to monitor the execution. Default is false.",false);
     query_options.add<int>("","port", 8080, "Port to use for the web interface. Default is 8080",false);
+    query_options.add<int>("","webthreads", 1, "Number of threads that serve the requests to the web interface. Read-only queries run concurrently. Default is 1",false);
 #endif
 
     query_options.add<int>("","maxstep", -1, "Set the maximum step for the chase.", false);
+    query_options.add<string>("","storesnapshot", "", "Path of the file where to store the graph computed by tgchase. Default is '' (disabled).", false);
+    query_options.add<string>("","loadsnapshot", "", "Path of a file created with --storesnapshot. The graph is loaded and tgchase resumes from its last step. Default is '' (disabled).", false);
     query_options.add<bool>("","no-filtering", true, "Disable filter optimization.",false);
     query_options.add<bool>("","no-intersect", false, "Disable intersection optimization.",false);
     query_options.add<string>("","graphfile", "", "Path to store the rule dependency graph",false);
@@ -344,6 +360,11 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     query_options.add<bool>("","querycont", true, "Enable the optimization that performs query containment to reduce duplicates during the computation of tgchase.", true);
     query_options.add<bool>("","edbcheck", true, "Enable the optimization that check EDB relations to reduce duplicates during the computation of tgchase.", true);
     query_options.add<bool>("","rewritecliques", true, "Enable the optimization that rewrites transitive and reflexity equality rules.", true);
+    query_options.add<bool>("","compressnodes", false, "Store the nodes computed by tgchase in a compressed format once they are no longer used as delta. Default is false.", false);
+    query_options.add<int64_t>("","membudget", 0, "Memory budget (in MB) of tgchase. When it is exceeded, the segment cache is shrunk and the nodes are compressed. Default is 0 (no budget).", false);
+    query_options.add<string>("","spillfile", "", "Path of a temporary file where tgchase writes the nodes that are not used anymore. They are loaded again from the file if needed. Default is '' (disabled).", false);
+    query_options.add<int>("","spillsteps", SPILLSEGMENT_DEFAULT_COLDSTEPS, "Number of steps after which an unused node is written to the spill file.", false);
+    query_options.add<int64_t>("","segcachesize", SEGMENTCACHE_DEFAULT_SIZE, "Memory budget (in MB) of the cache of sorted segments used by tgchase. 0 means a quarter of the RAM.", false);
     query_options.add<bool>("","delProofs", true, "Enable the optimization that remove redundantProofs via static analysis.", true);
 
     query_options.add<string>("","sameasAlgo", "NOTHING", "Enable equality algorithm. Techniques: NOTHING (default), AXIOM (axiomatization), SING (singularisation).",false);
@@ -352,7 +373,7 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     load_options.add<string>("i","input", "",
             "Path to the files that contain the compressed triples. This parameter is REQUIRED if already compressed triples/dict are not provided.", false);
     load_options.add<string>("o","output", "",
-            "Path to the KB that should be created. This parameter is REQUIRED.", false);
+            "Path to the KB (or, with <convert>, the directory of the binary tables) that should be created. This parameter is REQUIRED.", false);
     load_options.add<int>("","maxThreads",
             Utils::getNumberPhysicalCores(),
             "Sets the maximum number of threads to use during the compression. Default is the number of physical cores",false);
@@ -391,7 +412,7 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
             "Set the log level (accepted values: trace, debug, info, warning, error, fatal). Default is info.", false);
 
     cmdline_options.add<string>("p","profiler", "",
-            "File to store useful information to profile the execution of the rules.", false);
+            "File to store useful information to profile the execution of the rules. With the trigger graph chases, a summary per rule (<arg>-summary.csv) and a trace in the Chrome format (<arg>-trace.json) are also stored.", false);
 
     cmdline_options.add<string>("e", "edb", "default",
             "Path to the edb conf file. Default is 'edb.conf' in the same directory as the exec file.",false);
@@ -512,9 +533,13 @@ static void store_mat(const std::string &path, ProgramArgs &vm,
 
     std::string storemat_format = vm["storemat_format"].as<std::string>();
 
-    if (storemat_format == "files" || storemat_format == "csv") {
+    if (storemat_format == "files" || storemat_format == "csv" ||
+            storemat_format == "bin") {
         exp.storeOnFiles(path,
-                vm["decompressmat"].as<bool>(), 0, storemat_format == "csv");
+                vm["decompressmat"].as<bool>(),
+                storemat_format == "csv" ? EXPORT_CSV :
+                storemat_format == "bin" ? EXPORT_BINARY : EXPORT_TSV,
+                vm["gzipmat"].as<bool>(), vm["nthreads"].as<int>());
     } else if (storemat_format == "db") {
         //I will store the details on a Trident index
         exp.generateTridentDiffIndex(path);
@@ -550,6 +575,21 @@ void launchProbTGChase(int argc,
     //Obtain the chase procedure
     std::shared_ptr<GBChase> sn = Reasoner::getProbTGChase(db, &p,
             vm["delProofs"].as<bool>());
+    if (vm["multithreaded"].as<bool>()) {
+        sn->setNThreads(vm["nthreads"].as<int>());
+    }
+    if (vm["segcachesize"].as<int64_t>() > 0) {
+        SegmentCache::getInstance().setMaxSize(
+                vm["segcachesize"].as<int64_t>() * 1024 * 1024);
+    }
+    sn->setCompressNodes(vm["compressnodes"].as<bool>());
+    if (vm["membudget"].as<int64_t>() > 0) {
+        sn->setMemoryBudget(vm["membudget"].as<int64_t>() * 1024 * 1024);
+    }
+    if (!vm["spillfile"].as<string>().empty()) {
+        sn->setSpill(vm["spillfile"].as<string>(),
+                vm["spillsteps"].as<int>());
+    }
 
     if (vm["profiler"].as<std::string>() != "") {
         sn->setPathStoreStatistics(vm["profiler"].as<std::string>());
@@ -620,9 +660,14 @@ void launchProbTGChase(int argc,
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
         Exporter exp(sn);
         std::string storemat_format = vm["storemat_format"].as<string>();
-        if (storemat_format == "files" || storemat_format == "csv") {
+        if (storemat_format == "files" || storemat_format == "csv" ||
+                storemat_format == "bin") {
             exp.storeOnFiles(vm["storemat_path"].as<string>(),
-                    vm["decompressmat"].as<bool>(), 0, storemat_format == "csv");
+                    vm["decompressmat"].as<bool>(),
+                    storemat_format == "csv" ? EXPORT_CSV :
+                    storemat_format == "bin" ? EXPORT_BINARY : EXPORT_TSV,
+                    vm["gzipmat"].as<bool>(), vm["nthreads"].as<int>(),
+                    vm["dedupmat"].as<bool>());
         } else if (storemat_format == "db") {
             //I will store the details on a Trident index
             exp.generateTridentDiffIndex(vm["storemat_path"].as<string>());
@@ -692,6 +737,21 @@ void launchGBChase(
             vm["edbcheck"].as<bool>(),
             rewrite,
             param1);
+    if (vm["multithreaded"].as<bool>()) {
+        sn->setNThreads(vm["nthreads"].as<int>());
+    }
+    if (vm["segcachesize"].as<int64_t>() > 0) {
+        SegmentCache::getInstance().setMaxSize(
+                vm["segcachesize"].as<int64_t>() * 1024 * 1024);
+    }
+    sn->setCompressNodes(vm["compressnodes"].as<bool>());
+    if (vm["membudget"].as<int64_t>() > 0) {
+        sn->setMemoryBudget(vm["membudget"].as<int64_t>() * 1024 * 1024);
+    }
+    if (!vm["spillfile"].as<string>().empty()) {
+        sn->setSpill(vm["spillfile"].as<string>(),
+                vm["spillsteps"].as<int>());
+    }
 
     if (vm["profiler"].as<std::string>() != "") {
         sn->setPathStoreStatistics(vm["profiler"].as<std::string>());
@@ -732,6 +792,13 @@ void launchGBChase(
     }
 #endif
 
+    if (!vm["loadsnapshot"].as<string>().empty()) {
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        sn->loadSnapshot(vm["loadsnapshot"].as<string>());
+        std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+        LOG(INFOL) << "Time to load the snapshot = " << sec.count() * 1000 << " milliseconds";
+    }
+
     LOG(INFOL) << "Starting graph-based chase (" << cmd << ")";
     std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
     sn->run();
@@ -750,13 +817,25 @@ void launchGBChase(
     }
 #endif
 
+    if (!vm["storesnapshot"].as<string>().empty()) {
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        sn->storeSnapshot(vm["storesnapshot"].as<string>());
+        std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+        LOG(INFOL) << "Time to store the snapshot = " << sec.count() * 1000 << " milliseconds";
+    }
+
     if (!vm["storemat_path"].as<string>().empty()) {
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
         Exporter exp(sn);
         std::string storemat_format = vm["storemat_format"].as<string>();
-        if (storemat_format == "files" || storemat_format == "csv") {
+        if (storemat_format == "files" || storemat_format == "csv" ||
+                storemat_format == "bin") {
             exp.storeOnFiles(vm["storemat_path"].as<string>(),
-                    vm["decompressmat"].as<bool>(), 0, storemat_format == "csv");
+                    vm["decompressmat"].as<bool>(),
+                    storemat_format == "csv" ? EXPORT_CSV :
+                    storemat_format == "bin" ? EXPORT_BINARY : EXPORT_TSV,
+                    vm["gzipmat"].as<bool>(), vm["nthreads"].as<int>(),
+                    vm["dedupmat"].as<bool>());
         } else if (storemat_format == "db") {
             //I will store the details on a Trident index
             exp.generateTridentDiffIndex(vm["storemat_path"].as<string>());
@@ -878,9 +957,13 @@ void launchTriggeredMat(int argc,
 
         std::string storemat_format = vm["storemat_format"].as<string>();
 
-        if (storemat_format == "files" || storemat_format == "csv") {
+        if (storemat_format == "files" || storemat_format == "csv" ||
+                storemat_format == "bin") {
             exp.storeOnFiles(vm["storemat_path"].as<string>(),
-                    vm["decompressmat"].as<bool>(), 0, storemat_format == "csv");
+                    vm["decompressmat"].as<bool>(),
+                    storemat_format == "csv" ? EXPORT_CSV :
+                    storemat_format == "bin" ? EXPORT_BINARY : EXPORT_TSV,
+                    vm["gzipmat"].as<bool>(), vm["nthreads"].as<int>());
         } else if (storemat_format == "db") {
             //I will store the details on a Trident index
             exp.generateTridentDiffIndex(vm["storemat_path"].as<string>());
@@ -1334,6 +1417,8 @@ void runLiteralQuery(EDBLayer &edb, Program &p, Literal &literal,
         cout.rdbuf(file.rdbuf());
         std::chrono::system_clock::time_point startQ = std::chrono::system_clock::now();
         for (int j = 0; j < times; j++) {
+            //Every repetition pays the cost of the magic sets rewriting
+            reasoner.clearMagicPrograms();
             TupleIterator *iter;
             if (algo == "edb") {
                 iter = reasoner.getEDBIterator(literal, NULL, NULL, edb, onlyVars, NULL);
@@ -1606,7 +1691,8 @@ int main(int argc, const char** argv) {
     } else if (cmd == "mat") {
         EDBConf conf(edbFile);
         conf.setRootPath(Utils::parentDir(edbFile));
-        EDBLayer *layer = new EDBLayer(conf, vm["multithreaded"].as<bool>());
+        EDBLayer *layer = new EDBLayer(conf, vm["multithreaded"].as<bool>(),
+                true, vm["nthreads"].as<int>());
         EDBRemoveLiterals *rm;
         if (! vm["rm"].empty()) {
             std::string path(vm["rm"].as<string>());
@@ -1638,7 +1724,8 @@ int main(int argc, const char** argv) {
     } else if (cmd == "mat_tg") {
         EDBConf conf(edbFile);
         conf.setRootPath(Utils::parentDir(edbFile));
-        EDBLayer *layer = new EDBLayer(conf, vm["multithreaded"].as<bool>());
+        EDBLayer *layer = new EDBLayer(conf, vm["multithreaded"].as<bool>(),
+                true, vm["nthreads"].as<int>());
         launchTriggeredMat(argc, argv, full_path, *layer, vm,
                 vm["rules"].as<string>(), vm["trigger_paths"].as<string>());
         delete layer;
@@ -1646,14 +1733,16 @@ int main(int argc, const char** argv) {
             cmd == "tgchase" || cmd == "tgchasefullprov") {
         EDBConf conf(edbFile);
         conf.setRootPath(Utils::parentDir(edbFile));
-        EDBLayer *layer = new EDBLayer(conf, ! vm["multithreaded"].empty());
+        EDBLayer *layer = new EDBLayer(conf, ! vm["multithreaded"].empty(),
+                true, vm["nthreads"].as<int>());
         launchGBChase(cmd, argc, argv, full_path, *layer, vm,
                 vm["rules"].as<string>());
         delete layer;
     } else if (cmd == "probtgchase") {
         EDBConf conf(edbFile);
         conf.setRootPath(Utils::parentDir(edbFile));
-        EDBLayer *layer = new EDBLayer(conf, ! vm["multithreaded"].empty());
+        EDBLayer *layer = new EDBLayer(conf, ! vm["multithreaded"].empty(),
+                true, vm["nthreads"].as<int>());
         launchProbTGChase(argc, argv, full_path, *layer, vm,
                 vm["rules"].as<string>());
         delete layer;
@@ -1671,6 +1760,14 @@ int main(int argc, const char** argv) {
         writeRuleDependencyGraph(*layer, vm["rules"].as<string>(),
                 vm["graphfile"].as<string>());
         delete layer;
+    } else if (cmd == "convert") {
+        EDBConf conf(edbFile);
+        conf.setRootPath(Utils::parentDir(edbFile));
+        int nthreads = vm["nthreads"].as<int>();
+        EDBLayer *layer = new EDBLayer(conf, nthreads > 1, true, nthreads);
+        BinaryTableFile::convert(conf, *layer, vm["output"].as<string>(),
+                nthreads);
+        delete layer;
     } else if (cmd == "load") {
         Loader *loader = new Loader();
         bool onlyCompress = false;
@@ -5,7 +5,6 @@
 #include <algorithm>
 
 Term_t const * const EMPTY_TUPLE = {0};
-BindingsRow EMPTY_ROW(0, EMPTY_TUPLE);
 
 bool BindingsRow::operator==(const BindingsRow &other) const {
     if (size == other.size) {
@@ -21,8 +20,9 @@ bool BindingsRow::operator==(const BindingsRow &other) const {
     return false;
 }
 
-BindingsTable::BindingsTable(uint8_t sizeAdornment, uint8_t adornment) {
-    uniqueElements.max_load_factor(0.75);
+BindingsTable::BindingsTable(uint8_t sizeAdornment, uint8_t adornment) :
+    uniqueElements(Predicate::getNFields(sizeAdornment < 8 ?
+                adornment & ((1 << sizeAdornment) - 1) : adornment)) {
     //Mark positions to copy
     std::vector<int> pc;
     for (int i = 0; i < sizeAdornment; ++i) {
@@ -39,60 +39,34 @@ BindingsTable::BindingsTable(uint8_t sizeAdornment, uint8_t adornment) {
         for (std::vector<int>::iterator itr = pc.begin(); itr != pc.end(); ++itr) {
             posToCopy[i++] = *itr;
         }
-        rawBindings = new RawBindings((uint8_t) nPosToCopy);
-        currentRow = rawBindings->newRow();
     } else {
         posToCopy = NULL;
-        rawBindings = NULL;
-        currentRow = NULL;
     }
 }
 
-BindingsTable::BindingsTable(size_t sizeTuple) {
-    uniqueElements.max_load_factor(0.75);
+BindingsTable::BindingsTable(size_t sizeTuple) :
+    uniqueElements((uint8_t) sizeTuple) {
     nPosToCopy = sizeTuple;
-    if (nPosToCopy > 0) {
-        rawBindings = new RawBindings((uint8_t) sizeTuple);
-        currentRow = rawBindings->newRow();
-    } else {
-        rawBindings = NULL;
-        currentRow = NULL;
-    }
     posToCopy = NULL;
 }
 
-BindingsTable::BindingsTable(uint8_t npc, std::vector<int> pc) {
-    uniqueElements.max_load_factor(0.75);
+BindingsTable::BindingsTable(uint8_t npc, std::vector<int> pc) :
+    uniqueElements(npc) {
     this->nPosToCopy = npc;
     if (nPosToCopy > 0) {
         this->posToCopy = new size_t[nPosToCopy];
         for (int i = 0; i < nPosToCopy; ++i) {
             posToCopy[i] = pc.at(i);
         }
-        rawBindings = new RawBindings((uint8_t) nPosToCopy);
-        currentRow = rawBindings->newRow();
     } else {
         this->posToCopy = NULL;
-        rawBindings = NULL;
-        currentRow = NULL;
     }
 }
 
 void BindingsTable::insertIfNotExists(Term_t const * const cr) {
-    if (cr == EMPTY_TUPLE) {
-        uniqueElements.insert(EMPTY_ROW);
-        return;
-    }
-    BindingsRow row((uint8_t) nPosToCopy, cr);
-    /*
-    std::unordered_set<BindingsRow, hash_BindingsRow>::iterator itr = uniqueElements.find(row);
-    if (itr == uniqueElements.end()) {
-        uniqueElements.insert(row);
-    */
-    std::pair<std::unordered_set<BindingsRow, hash_BindingsRow>::iterator, bool> result = uniqueElements.insert(row);
-    if (result.second) {
-        currentRow = rawBindings->newRow();
-    }
+    //The set copies the row, so currentRow can be reused
+    bool inserted;
+    uniqueElements.insert(cr, inserted);
 }
 
 void BindingsTable::addTuple(const Literal *t) {
@@ -170,16 +144,12 @@ void BindingsTable::addRawTuple(Term_t *r) {
 
 void BindingsTable::clear() {
     uniqueElements.clear();
-    if (nPosToCopy > 0) {
-        rawBindings->clear();
-        currentRow = rawBindings->newRow();
-    }
 }
 
 TupleTable *BindingsTable::sortBy(std::vector<uint8_t> &fields) {
     std::vector<BindingsRow> rowsToSort;
     for (size_t i = 0; i < uniqueElements.size(); ++i) {
-        BindingsRow row((uint8_t) nPosToCopy, rawBindings->getOffset(i * nPosToCopy));
+        BindingsRow row((uint8_t) nPosToCopy, uniqueElements.getRow(i));
         rowsToSort.push_back(row);
     }
     FieldsSorter sorter(fields);
@@ -214,7 +184,7 @@ TupleTable *BindingsTable::projectAndFilter(const Literal &l, const std::vector<
     bool warn_done = false;
 #endif
     for (size_t i = 0; i < uniqueElements.size(); ++i) {
-        Term_t *row = rawBindings->getOffset(i * nPosToCopy);
+        Term_t *row = uniqueElements.getRow(i);
         bool ok = true;
         for (int j = 0; j < nconsts; ++j) {
             if (row[consts[j]] != l.getTermAtPos(consts[j]).getValue()) {
@@ -291,7 +261,7 @@ TupleTable *BindingsTable::filter(const Literal &l, const std::vector<uint8_t> *
     bool warn_done = false;
 #endif
     for (size_t i = 0; i < uniqueElements.size(); ++i) {
-        Term_t *row = rawBindings->getOffset(i * nPosToCopy);
+        Term_t *row = uniqueElements.getRow(i);
 
         bool ok = true;
         for (int j = 0; j < nconsts; ++j) {
@@ -350,7 +320,7 @@ std::vector<Term_t> BindingsTable::getProjection(std::vector<uint8_t> pos) {
     size_t size = uniqueElements.size();
     std::vector<Term_t> outputVector;
     for (int i = 0; i < size; ++i) {
-        Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
+        Term_t *startTuple = uniqueElements.getRow(i);
         for (std::vector<uint8_t>::iterator itr = pos.begin(); itr != pos.end();
                 ++itr) {
             outputVector.push_back(*(startTuple + *itr));
@@ -367,7 +337,7 @@ std::vector<Term_t> BindingsTable::getUniqueSortedProjection(std::vector<uint8_t
     if (pos.size() == 1) {
         const uint8_t p = pos[0];
         for (int i = 0; i < size; ++i) {
-            Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
+            Term_t *startTuple = uniqueElements.getRow(i);
             outputVector.push_back(startTuple[p]);
         }
         sort(outputVector.begin(), outputVector.end());
@@ -377,7 +347,7 @@ std::vector<Term_t> BindingsTable::getUniqueSortedProjection(std::vector<uint8_t
         const uint8_t p1 = pos[0];
         const uint8_t p2 = pos[1];
         for (int i = 0; i < size; ++i) {
-            Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
+            Term_t *startTuple = uniqueElements.getRow(i);
             pairs.push_back(std::make_pair(startTuple[p1], startTuple[p2]));
         }
         sort(pairs.begin(), pairs.end());
@@ -392,7 +362,7 @@ std::vector<Term_t> BindingsTable::getUniqueSortedProjection(std::vector<uint8_t
     } else {
         //not yet supported. TODO
         for (int i = 0; i < size; ++i) {
-            Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
+            Term_t *startTuple = uniqueElements.getRow(i);
             for (std::vector<uint8_t>::iterator itr = pos.begin(); itr != pos.end();
                     ++itr) {
                 outputVector.push_back(*(startTuple + *itr));
@@ -406,10 +376,10 @@ std::vector<Term_t> BindingsTable::getUniqueSortedProjection(std::vector<uint8_t
 }
 
 const Term_t *BindingsTable::getTuple(size_t idx) {
-    if (rawBindings == NULL)
+    if (nPosToCopy == 0)
         return EMPTY_TUPLE;
     else
-        return rawBindings->getOffset(idx * nPosToCopy);
+        return uniqueElements.getRow(idx);
 }
 
 size_t BindingsTable::getNTuples() {
@@ -419,7 +389,7 @@ size_t BindingsTable::getNTuples() {
 void BindingsTable::print() {
     size_t size = uniqueElements.size();
     for (int i = 0; i < size; ++i) {
-        Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
+        Term_t *startTuple = uniqueElements.getRow(i);
         for (int j = 0; j < nPosToCopy; ++j)
             std::cout << startTuple[j] << " ";
         std::cout << std::endl;
@@ -440,6 +410,4 @@ void BindingsTable::statistics() {
 BindingsTable::~BindingsTable() {
     if (posToCopy != NULL)
         delete[] posToCopy;
-    if (rawBindings != NULL)
-        delete rawBindings;
 }
@@ -11,6 +11,7 @@
 #include <map>
 #include <stdlib.h>
 #include <fstream>
+#include <atomic>
 
 bool Literal::hasRepeatedVars() const {
     std::vector<Var_t> variables;
@@ -1175,6 +1176,11 @@ const std::vector<uint32_t> &Program::getRulesIDsByPredicate(PredId_t predid) co
     return rules[predid];
 }
 
+uint64_t ProgramGeneration::next() {
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
 Program::Program(EDBLayer *kb) : kb(kb),
     rewriteCounter(0),
     dictPredicates(kb->getPredDictionary()),
@@ -1531,10 +1537,12 @@ std::shared_ptr<Program> Program::cloneNew() const {
 void Program::cleanAllRules() {
     rules.clear();
     allrules.clear();
+    generation.increment();
 }
 
 void Program::addRule(Rule &rule) {
     assert(rule.getId() == allrules.size());
+    generation.increment();
     for (const auto &head : rule.getHeads()) {
         if (rules.size() <= head.getPredicate().getId()) {
             rules.resize(head.getPredicate().getId() + 1);
@@ -1720,6 +1728,7 @@ struct RuleSorter {
 };
 
 void Program::sortRulesByIDBPredicates() {
+    generation.increment();
     for (int i = 0; i < rules.size(); ++i) {
         if (rules[i].size() > 0) {
             std::vector<uint32_t> tmpC = rules[i];
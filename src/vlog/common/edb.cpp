@@ -31,11 +31,14 @@
 #include <vlog/incremental/edb-table-importer.h>
 
 #include <climits>
+#include <thread>
+#include <algorithm>
 #include <inttypes.h>
 
 EDBLayer::EDBLayer(EDBLayer &db, bool copyTables) :
     conf(db.conf),
     multithreaded(db.multithreaded),
+    nthreads(db.nthreads),
     edbconfpath(db.edbconfpath) {
         this->predDictionary = db.predDictionary;
         this->termsDictionary = db.termsDictionary;
@@ -140,6 +143,14 @@ void EDBLayer::addMDLiteTable(const EDBConf::Table &tableConf) {
 }
 #endif
 
+int EDBLayer::getNThreadsLoad() const {
+    if (!multithreaded)
+        return 1;
+    if (nthreads > 0)
+        return nthreads;
+    return std::max(1, (int) std::thread::hardware_concurrency());
+}
+
 void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
         std::string edbconfpath) {
     EDBInfoTable infot;
@@ -165,13 +176,15 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
         InmemoryTable *table;
         if (tableConf.params.size() == 2) {
             table = new InmemoryTable(repository,
-                    tableConf.params[1], infot.id, this);
+                    tableConf.params[1], infot.id, this, ',', true,
+                    getNThreadsLoad());
         } else {
             char sep = tableConf.params[2][0];
             if (sep == 't')
                 sep = '\t';
             table = new InmemoryTable(repository,
-                    tableConf.params[1], infot.id, this, sep, loadAllData);
+                    tableConf.params[1], infot.id, this, sep, loadAllData,
+                    getNThreadsLoad());
         }
         infot.manager = std::shared_ptr<EDBTable>(table);
         infot.arity = table->getArity();
@@ -184,6 +197,25 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
     }
 }
 
+    void EDBLayer::addBinaryTable(const EDBConf::Table &tableConf) {
+        EDBInfoTable infot;
+        const std::string pn = tableConf.predname;
+        infot.id = (PredId_t) predDictionary->getOrAdd(pn);
+        infot.type = tableConf.type;
+        std::string path = tableConf.params[0];
+        if (!Utils::isAbsolutePath(path)) {
+            path = Utils::join(rootPath, path);
+        }
+        std::shared_ptr<BinaryTableFile> file(new BinaryTableFile(path));
+        InmemoryTable *table = new InmemoryTable(infot.id, file, this,
+                getNThreadsLoad());
+        infot.manager = std::shared_ptr<EDBTable>(table);
+        infot.arity = table->getArity();
+        dbPredicates.insert(make_pair(infot.id, infot));
+        LOG(DEBUGL) << "Imported binary table " << pn << " id " << infot.id <<
+            " size " << table->getSize();
+    }
+
     void EDBLayer::addInmemoryTable(std::string predicate,
             std::vector<std::vector<std::string>> &rows) {
         PredId_t id = (PredId_t) predDictionary->getOrAdd(predicate);
@@ -243,6 +275,8 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
 #endif
         } else if (table.type == "CSV" || table.type == "INMEMORY") {
             addInmemoryTable(table, edbconfpath);
+        } else if (table.type == "BINARY") {
+            addBinaryTable(table);
 #ifdef SPARQL
         } else if (table.type == "SPARQL") {
             addSparqlTable(table);
@@ -1391,9 +1425,13 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
                 break;
             }
         }
-        if (!resp && termsDictionary.get()) {
-            std::string t(text, sz);
-            resp = termsDictionary->get(t, id);
+        if (!resp) {
+            auto dict = std::atomic_load(&termsDictionary);
+            if (dict.get()) {
+                Term_t t;
+                resp = dict->get(text, sz, t);
+                id = t;
+            }
         }
         return resp;
     }
@@ -1407,19 +1445,61 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
             if (sz > 43 && text[0] == '"' && ! strcmp(text + sz - 43, "^^<http://www.w3.org/2001/XMLSchema#string>")) {
                 sz -= 43;
             }
-            if (!termsDictionary.get()) {
-                LOG(DEBUGL) << "The additional terms will start from " << getNTerms();
-                termsDictionary = std::shared_ptr<Dictionary>(
-                        new Dictionary(getNTerms()));
-            }
-            std::string t(text, sz);
-            id = termsDictionary->getOrAdd(t);
-            LOG(TRACEL) << "getOrAddDictNumber \"" << t << "\" returns " << id;
+            id = getTermsDictionary()->getOrAdd(text, sz);
+            LOG(TRACEL) << "getOrAddDictNumber \"" << std::string(text, sz) <<
+                "\" returns " << id;
             resp = true;
         }
         return resp;
     }
 
+    std::shared_ptr<ConcurrentDictionary> EDBLayer::getTermsDictionary() {
+        auto dict = std::atomic_load(&termsDictionary);
+        if (!dict.get()) {
+            std::lock_guard<std::mutex> lock(termsDictionaryMutex);
+            dict = std::atomic_load(&termsDictionary);
+            if (!dict.get()) {
+                LOG(DEBUGL) << "The additional terms will start from " << getNTerms();
+                dict = std::shared_ptr<ConcurrentDictionary>(
+                        new ConcurrentDictionary(getNTerms()));
+                std::atomic_store(&termsDictionary, dict);
+            }
+        }
+        return dict;
+    }
+
+    void EDBLayer::getOrAddDictNumbers(const std::vector<std::string> &texts,
+            std::vector<uint64_t> &ids) {
+        ids.resize(texts.size());
+        std::vector<std::string> newTerms;
+        std::vector<size_t> newTermsIdx;
+        for (size_t i = 0; i < texts.size(); ++i) {
+            const std::string &text = texts[i];
+            bool resp = false;
+            for (auto &table : edbTablesWithDict) {
+                resp = table->getDictNumber(text.c_str(), text.size(), ids[i]);
+                if (resp) {
+                    break;
+                }
+            }
+            if (!resp) {
+                size_t sz = text.size();
+                if (sz > 43 && text[0] == '"' && ! strcmp(text.c_str() + sz - 43, "^^<http://www.w3.org/2001/XMLSchema#string>")) {
+                    sz -= 43;
+                }
+                newTerms.push_back(text.substr(0, sz));
+                newTermsIdx.push_back(i);
+            }
+        }
+        if (!newTerms.empty()) {
+            std::vector<Term_t> newIds;
+            getTermsDictionary()->getOrAdd(newTerms, newIds);
+            for (size_t i = 0; i < newIds.size(); ++i) {
+                ids[newTermsIdx[i]] = newIds[i];
+            }
+        }
+    }
+
     bool EDBLayer::getDictText(const uint64_t id, char *text) const {
         if (IS_NUMBER(id)) {
             if (IS_UINT(id)) {
@@ -1441,9 +1521,10 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
             if (resp)
                 break;
         }
-        if (!resp && termsDictionary.get()) {
-            std::string t = termsDictionary->getRawValue(id);
-            if (t != "") {
+        if (!resp) {
+            auto dict = std::atomic_load(&termsDictionary);
+            std::string t;
+            if (dict.get() && dict->getRawValue(id, t)) {
                 memcpy(text, t.c_str(), t.size());
                 text[t.size()] = '\0';
                 return true;
@@ -1473,8 +1554,11 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
             if (resp)
                 break;
         }
-        if (!resp && termsDictionary.get()) {
-            t = termsDictionary->getRawValue(id);
+        if (!resp) {
+            auto dict = std::atomic_load(&termsDictionary);
+            if (dict.get()) {
+                dict->getRawValue(id, t);
+            }
         }
         return t;
     }
@@ -1484,8 +1568,17 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf,
         for (auto &table : edbTablesWithDict) {
             size += table->getNTerms();
         }
-        if (termsDictionary.get()) {
-            size += termsDictionary->size();
+        auto dict = std::atomic_load(&termsDictionary);
+        if (dict.get()) {
+            size += dict->size();
+        }
+        return size;
+    }
+
+    uint64_t EDBLayer::getNTermsInTables() const {
+        uint64_t size = 0;
+        for (auto &table : edbTablesWithDict) {
+            size += table->getNTerms();
         }
         return size;
     }
@@ -2,6 +2,9 @@
 #include <vlog/seminaiver.h>
 #include <vlog/trident/tridenttable.h>
 #include <vlog/utils.h>
+#include <glog/gbchase.h>
+#include <glog/gbsegmentspilled.h>
+#include <glog/gbsegmentcompressed.h>
 
 #include <kognac/utils.h>
 #include <trident/tree/root.h>
@@ -11,7 +14,20 @@
 #include <inttypes.h>
 #include <vector>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <condition_variable>
 #include <zstr/zstr.hpp>
+#include <zlib.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#define EXPORTER_BINARY_MAGIC "VLOGCOL1"
 
 struct AggrIndex {
     uint64_t first, second;
@@ -354,20 +370,559 @@ void Exporter::generateNTTriples(std::string outputdir, bool decompress) {
 
 void Exporter::storeOnFiles(std::string path, const bool decompress,
         const int minLevel, const bool csv) {
-    char buffer[MAX_TERM_SIZE];
+    storeOnFiles(path, decompress, csv ? EXPORT_CSV : EXPORT_TSV, false, 1);
+}
+
+struct ExportFile {
+    int fd;
+    uint64_t offset;
+    size_t nextChunk;
+    bool failed;
+    //Chunks that are ready but cannot be written yet
+    std::map<size_t, std::string> pending;
+    std::mutex mutex;
+    std::condition_variable written;
+};
+
+struct ExportBlock {
+    size_t fileIdx;
+    size_t iteration;
+    size_t nrows;
+    uint8_t arity;
+    //The rows are either in columns (FCTable) or in segment (GBGraph node)
+    std::vector<std::shared_ptr<Column>> columns;
+    std::shared_ptr<const TGSegment> segment;
+};
+
+struct ExportChunk {
+    size_t blockIdx;
+    size_t chunkIdx; //Position of the chunk in the file
+    size_t begin, end;
+};
+
+//All the nodes of a predicate of GBChase, which are merged by one task to
+//remove the duplicates
+struct ExportMerge {
+    size_t fileIdx;
+    size_t firstChunkIdx;
+    uint8_t arity;
+    std::vector<std::shared_ptr<const TGSegment>> segments;
+    std::vector<size_t> steps;
+};
+
+//Rows of a chunk, column by column. The iterations are stored as runs of
+//(end row, iteration)
+struct ExportRows {
+    size_t nrows;
+    std::vector<std::vector<Term_t>> values;
+    std::vector<std::pair<size_t, size_t>> runs;
+
+    void clear(uint8_t arity) {
+        nrows = 0;
+        values.assign(arity, std::vector<Term_t>());
+        runs.clear();
+    }
+};
+
+static bool writeAll(int fd, const char *data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+//Append the chunk to the file if all the previous ones have been written,
+//otherwise leave it to the thread that writes the last missing one
+static bool writeChunk(ExportFile &file, size_t chunkIdx, std::string &data) {
+    std::lock_guard<std::mutex> lock(file.mutex);
+    file.pending[chunkIdx].swap(data);
+    auto itr = file.pending.begin();
+    while (itr != file.pending.end() && itr->first == file.nextChunk) {
+        if (!writeAll(file.fd, itr->second.c_str(), itr->second.size(),
+                    file.offset)) {
+            file.failed = true;
+            file.written.notify_all();
+            return false;
+        }
+        file.offset += itr->second.size();
+        file.nextChunk++;
+        itr = file.pending.erase(itr);
+    }
+    file.written.notify_all();
+    return true;
+}
+
+//Wait until the chunk is less than maxPending chunks ahead of the last one
+//written, so that the chunks waiting in memory are bounded. The chunks of a
+//file are handed out in order, so the first missing one never waits
+static bool waitChunk(ExportFile &file, size_t chunkIdx, size_t maxPending) {
+    std::unique_lock<std::mutex> lock(file.mutex);
+    file.written.wait(lock, [&]() {
+            return file.failed || chunkIdx < file.nextChunk + maxPending;
+            });
+    return !file.failed;
+}
+
+//Every chunk is a complete gzip member. A concatenation of members is a valid
+//gzip file, so the chunks can be compressed independently
+static bool gzipChunk(const std::string &in, std::string &out) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    out.resize(deflateBound(&zs, in.size()) + 32);
+    zs.next_in = (Bytef*) in.data();
+    zs.avail_in = in.size();
+    zs.next_out = (Bytef*) &out[0];
+    zs.avail_out = out.size();
+    const int ret = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+//Decode all the distinct terms of the chunk at once. The lookups in the
+//dictionary are serialized, because not all the EDB tables are thread-safe
+static void decodeTerms(EDBLayer &layer, std::mutex &layerMutex,
+        const std::vector<std::vector<Term_t>> &values, const bool csv,
+        std::vector<Term_t> &ids, std::vector<std::string> &texts) {
+    for (const auto &column : values) {
+        ids.insert(ids.end(), column.begin(), column.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    texts.resize(ids.size());
+    {
+        char buffer[MAX_TERM_SIZE];
+        std::lock_guard<std::mutex> lock(layerMutex);
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (layer.getDictText(ids[i], buffer)) {
+                texts[i] = std::string(buffer);
+            } else {
+                uint64_t v = ids[i];
+                texts[i] = "" + std::to_string(v >> 40) + "_"
+                    + std::to_string((v >> 32) & 0377) + "_"
+                    + std::to_string(v & 0xffffffff);
+            }
+        }
+    }
+    if (csv) {
+        for (auto &t : texts) {
+            t = VLogUtils::csvString(t);
+        }
+    }
+}
+
+static void readChunk(const ExportBlock &block, const ExportChunk &chunk,
+        ExportRows &rows) {
+    rows.clear(block.arity);
+    rows.nrows = chunk.end - chunk.begin;
+    rows.runs.push_back(std::make_pair(rows.nrows, block.iteration));
+    if (block.arity == 0) {
+        return;
+    }
+    if (block.segment != NULL) {
+        std::shared_ptr<const TGSegment> seg = block.segment;
+        if (chunk.begin > 0 || chunk.end < block.nrows) {
+            seg = seg->slice(chunk.begin, chunk.end);
+        }
+        auto itr = seg->iterator(seg);
+        while (itr->hasNext()) {
+            itr->next();
+            for (uint8_t m = 0; m < block.arity; ++m) {
+                rows.values[m].push_back(itr->get(m));
+            }
+        }
+        return;
+    }
+    for (uint8_t m = 0; m < block.arity; ++m) {
+        const auto &column = block.columns[m];
+        if (column->supportsDirectAccess()) {
+            rows.values[m].resize(rows.nrows);
+            for (size_t i = 0; i < rows.nrows; ++i) {
+                rows.values[m][i] = column->getValue(chunk.begin + i);
+            }
+        } else {
+            //The chunk covers the entire block
+            rows.values[m] = column->getReader()->asVector();
+        }
+    }
+}
+
+static void formatRows(const ExportRows &rows, const bool decompress,
+        const ExportFormat format, EDBLayer &layer, std::mutex &layerMutex,
+        std::string &out) {
+    const uint8_t arity = rows.values.size();
+    if (format == EXPORT_BINARY) {
+        //One block for every run of rows with the same iteration
+        size_t begin = 0;
+        for (const auto &run : rows.runs) {
+            const uint64_t header[2] = { run.first - begin, run.second };
+            out.append((const char*) header, sizeof(header));
+            for (const auto &column : rows.values) {
+                if (column.empty())
+                    continue;
+                out.append((const char*) (column.data() + begin),
+                        (run.first - begin) * sizeof(Term_t));
+            }
+            begin = run.first;
+        }
+        return;
+    }
+
+    const bool csv = format == EXPORT_CSV;
+    std::vector<Term_t> ids;
+    std::vector<std::string> texts;
+    if (decompress || csv) {
+        decodeTerms(layer, layerMutex, rows.values, csv, ids, texts);
+    }
+    auto run = rows.runs.begin();
+    std::string iteration;
+    if (run != rows.runs.end()) {
+        iteration = std::to_string(run->second);
+    }
+    for (size_t i = 0; i < rows.nrows; ++i) {
+        if (i == run->first) {
+            ++run;
+            iteration = std::to_string(run->second);
+        }
+        if (!csv) {
+            out += iteration;
+        }
+        for (uint8_t m = 0; m < arity; ++m) {
+            if (csv) {
+                if (m > 0) {
+                    out += ",";
+                }
+            } else {
+                out += "\t";
+            }
+            if (decompress || csv) {
+                const size_t idx = std::lower_bound(ids.begin(), ids.end(),
+                        rows.values[m][i]) - ids.begin();
+                out += texts[idx];
+            } else {
+                out += std::to_string(rows.values[m][i]);
+            }
+        }
+        out += "\n";
+    }
+}
+
+//Drop the copy that reading a spilled or compressed node keeps in memory
+static void releaseNodeData(const std::shared_ptr<const TGSegment> &seg) {
+    if (seg->getName() == "TGSegmentSpilled") {
+        std::static_pointer_cast<TGSegmentSpilled>(
+                std::const_pointer_cast<TGSegment>(seg))->release();
+    } else if (seg->getName() == "TGSegmentCompressed") {
+        std::static_pointer_cast<const TGSegmentCompressed>(
+                seg)->releaseDecompressed();
+    }
+}
 
+static bool storeRows(const ExportRows &rows, ExportFile &file,
+        size_t chunkIdx, const bool decompress, const ExportFormat format,
+        const bool gzip, EDBLayer &layer, std::mutex &layerMutex) {
+    std::string data;
+    formatRows(rows, decompress, format, layer, layerMutex, data);
+    if (gzip) {
+        std::string compressed;
+        if (!gzipChunk(data, compressed)) {
+            return false;
+        }
+        data.swap(compressed);
+    }
+    return writeChunk(file, chunkIdx, data);
+}
+
+//k-way merge of the sorted nodes. A row that appears in multiple nodes is
+//written once, with the lowest step
+static bool mergeNodes(const ExportMerge &merge, ExportFile &file,
+        const bool decompress, const ExportFormat format, const bool gzip,
+        EDBLayer &layer, std::mutex &layerMutex) {
+    //Only this task writes in the file, so every chunk is written right away
+    size_t chunkIdx = merge.firstChunkIdx;
+    ExportRows rows;
+    rows.clear(merge.arity);
+    if (merge.arity == 0) {
+        rows.nrows = 1;
+        rows.runs.push_back(std::make_pair(1, *std::min_element(
+                        merge.steps.begin(), merge.steps.end())));
+        return storeRows(rows, file, chunkIdx, decompress, format, gzip,
+                layer, layerMutex);
+    }
+
+    std::vector<std::shared_ptr<const TGSegment>> segments;
+    std::vector<std::unique_ptr<TGSegmentItr>> itrs;
+    std::vector<size_t> steps;
+    for (size_t i = 0; i < merge.segments.size(); ++i) {
+        auto seg = merge.segments[i];
+        if (!seg->isSorted()) {
+            seg = seg->sort();
+        }
+        auto itr = seg->iterator(seg);
+        if (itr->hasNext()) {
+            itr->next();
+            segments.push_back(seg);
+            itrs.push_back(std::move(itr));
+            steps.push_back(merge.steps[i]);
+        }
+    }
+    auto greater = [&](size_t a, size_t b) {
+        int r = TGSegmentItr::cmp(itrs[a].get(), itrs[b].get());
+        if (r != 0) {
+            return r > 0;
+        }
+        return steps[a] > steps[b];
+    };
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < itrs.size(); ++i) {
+        heap.push_back(i);
+    }
+    std::make_heap(heap.begin(), heap.end(), greater);
+
+    std::vector<Term_t> last(merge.arity);
+    bool first = true;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        const size_t i = heap.back();
+        TGSegmentItr *itr = itrs[i].get();
+        bool duplicate = !first;
+        for (uint8_t m = 0; m < merge.arity && duplicate; ++m) {
+            duplicate = itr->get(m) == last[m];
+        }
+        if (!duplicate) {
+            first = false;
+            for (uint8_t m = 0; m < merge.arity; ++m) {
+                last[m] = itr->get(m);
+                rows.values[m].push_back(last[m]);
+            }
+            rows.nrows++;
+            if (rows.runs.empty() || rows.runs.back().second != steps[i]) {
+                rows.runs.push_back(std::make_pair(rows.nrows, steps[i]));
+            } else {
+                rows.runs.back().first = rows.nrows;
+            }
+            if (rows.nrows == EXPORTER_CHUNK_ROWS) {
+                if (!storeRows(rows, file, chunkIdx++, decompress, format,
+                            gzip, layer, layerMutex)) {
+                    return false;
+                }
+                rows.clear(merge.arity);
+            }
+        }
+        if (itr->hasNext()) {
+            itr->next();
+            std::push_heap(heap.begin(), heap.end(), greater);
+        } else {
+            heap.pop_back();
+        }
+    }
+    if (rows.nrows > 0) {
+        return storeRows(rows, file, chunkIdx, decompress, format, gzip,
+                layer, layerMutex);
+    }
+    return true;
+}
+
+void Exporter::storeOnFiles(std::string path, const bool decompress,
+        const ExportFormat format, const bool gzip, int nthreads,
+        const bool mergeGBNodes) {
     Utils::create_directories(path);
     Program *program = sn->getProgram();
-
-    //I create a new file for every idb predicate
-    size_t npredicates = program->getNPredicates();
+    EDBLayer &layer = sn->getEDBLayer();
+    if (nthreads < 1) {
+        nthreads = 1;
+    }
+    //The nodes of GBChase are read directly, without creating FCTables
+    std::shared_ptr<GBChase> gbchase = std::dynamic_pointer_cast<GBChase>(sn);
+
+    //I create a new file for every idb predicate, and split its tables in
+    //chunks. The chunks are numbered in the order they appear in the file
+    std::vector<std::unique_ptr<ExportFile>> files;
+    std::vector<ExportBlock> blocks;
+    std::vector<ExportChunk> chunks;
+    std::vector<ExportMerge> merges;
     for (PredId_t predid : program->getAllPredicateIDs()) {
-        FCTable *table = sn->getTable(predid);
-        if (table != NULL && !table->isEmpty()) {
-            storeOnFile(path + "/" +
-                    generateFileName(program->getPredicateName(predid)),
-                    predid, decompress, minLevel, csv);
+        FCTable *table = NULL;
+        uint8_t arity;
+        if (gbchase != NULL) {
+            if (!gbchase->getGBGraph().areNodesWithPredicate(predid)) {
+                continue;
+            }
+            arity = program->getPredicateCard(predid);
+        } else {
+            table = sn->getTable(predid);
+            if (table == NULL || table->isEmpty()) {
+                continue;
+            }
+            arity = table->getSizeRow();
+        }
+        std::string filename = path + "/" +
+            generateFileName(program->getPredicateName(predid));
+        if (format == EXPORT_BINARY) {
+            filename += ".bin";
+        }
+        if (gzip) {
+            filename += ".gz";
         }
+        int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            throw("Could not open " + filename + " for writing");
+        }
+        files.push_back(std::unique_ptr<ExportFile>(new ExportFile()));
+        ExportFile &file = *files.back();
+        file.fd = fd;
+        file.offset = 0;
+        file.nextChunk = 0;
+        file.failed = false;
+        const size_t fileIdx = files.size() - 1;
+
+        size_t chunkIdx = 0;
+        if (format == EXPORT_BINARY) {
+            //The header is the first chunk
+            std::string header(EXPORTER_BINARY_MAGIC);
+            const uint64_t a = arity;
+            header.append((const char*) &a, sizeof(a));
+            if (gzip) {
+                std::string compressed;
+                gzipChunk(header, compressed);
+                header.swap(compressed);
+            }
+            writeChunk(file, chunkIdx++, header);
+        }
+
+        std::vector<ExportBlock> predBlocks;
+        if (gbchase != NULL) {
+            const GBGraph &g = gbchase->getGBGraph();
+            if (mergeGBNodes) {
+                ExportMerge merge;
+                merge.fileIdx = fileIdx;
+                merge.firstChunkIdx = chunkIdx;
+                merge.arity = arity;
+                for (auto nodeId : g.getNodeIDsWithPredicate(predid)) {
+                    merge.segments.push_back(g.getNodeData(nodeId));
+                    merge.steps.push_back(g.getNodeStep(nodeId));
+                }
+                merges.push_back(merge);
+                continue;
+            }
+            for (auto nodeId : g.getNodeIDsWithPredicate(predid)) {
+                ExportBlock block;
+                block.segment = g.getNodeData(nodeId);
+                block.iteration = nodeId;
+                block.nrows = arity == 0 ? 1 : block.segment->getNRows();
+                predBlocks.push_back(block);
+            }
+        } else {
+            FCIterator itr = table->read(0);
+            while (!itr.isEmpty()) {
+                std::shared_ptr<const FCInternalTable> t = itr.getCurrentTable();
+                ExportBlock block;
+                block.iteration = itr.getCurrentIteration();
+                block.nrows = t->getNRows();
+                for (uint8_t m = 0; m < arity; ++m) {
+                    block.columns.push_back(t->getColumn(m));
+                }
+                predBlocks.push_back(block);
+                itr.moveNextCount();
+            }
+        }
+        for (auto &block : predBlocks) {
+            block.fileIdx = fileIdx;
+            block.arity = arity;
+            bool directAccess = true;
+            for (const auto &column : block.columns) {
+                directAccess &= column->supportsDirectAccess();
+            }
+            const size_t chunkSize = directAccess ? EXPORTER_CHUNK_ROWS :
+                std::max(block.nrows, (size_t) 1);
+            for (size_t begin = 0; begin < block.nrows; begin += chunkSize) {
+                ExportChunk chunk;
+                chunk.blockIdx = blocks.size();
+                chunk.chunkIdx = chunkIdx++;
+                chunk.begin = begin;
+                chunk.end = std::min(block.nrows, begin + chunkSize);
+                chunks.push_back(chunk);
+            }
+            blocks.push_back(block);
+        }
+    }
+    LOG(INFOL) << "Exporting " << files.size() << " predicates in " <<
+        (chunks.size() + merges.size()) << " tasks with " << nthreads <<
+        " threads ...";
+
+    //The node of a block is released once all its chunks are written
+    std::unique_ptr<std::atomic<size_t>[]> remainingChunks(
+            new std::atomic<size_t>[blocks.size()]);
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        remainingChunks[i] = 0;
+    }
+    for (const auto &chunk : chunks) {
+        remainingChunks[chunk.blockIdx]++;
+    }
+
+    //The merges are the longest tasks, so they are started first
+    std::atomic<size_t> nextTask(0);
+    std::atomic<bool> failed(false);
+    std::mutex layerMutex;
+    auto worker = [&]() {
+        ExportRows rows;
+        while (!failed) {
+            const size_t i = nextTask++;
+            if (i < merges.size()) {
+                const ExportMerge &merge = merges[i];
+                if (!mergeNodes(merge, *files[merge.fileIdx], decompress,
+                            format, gzip, layer, layerMutex)) {
+                    failed = true;
+                }
+                for (const auto &seg : merge.segments) {
+                    releaseNodeData(seg);
+                }
+                continue;
+            }
+            if (i >= merges.size() + chunks.size()) {
+                break;
+            }
+            const ExportChunk &chunk = chunks[i - merges.size()];
+            const ExportBlock &block = blocks[chunk.blockIdx];
+            if (!waitChunk(*files[block.fileIdx], chunk.chunkIdx,
+                        2 * nthreads)) {
+                failed = true;
+                break;
+            }
+            readChunk(block, chunk, rows);
+            if (!storeRows(rows, *files[block.fileIdx], chunk.chunkIdx,
+                        decompress, format, gzip, layer, layerMutex)) {
+                failed = true;
+            }
+            if (block.segment != NULL && --remainingChunks[chunk.blockIdx] == 0) {
+                releaseNodeData(block.segment);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nthreads; ++i) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (auto &file : files) {
+        close(file->fd);
+    }
+    if (failed) {
+        LOG(ERRORL) << "Error while exporting the materialization in " << path;
+        throw 10;
     }
 }
 
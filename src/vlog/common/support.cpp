@@ -0,0 +1,205 @@
+#include <vlog/support.h>
+
+#include <cstring>
+
+#define DICT_INITIAL_SLOTS 16
+
+ConcurrentDictionary::Shard::Shard() : offsets(1, 0),
+    slots(DICT_INITIAL_SLOTS, 0) {
+}
+
+ConcurrentDictionary::ReverseShard::ReverseShard() {
+    map.set_empty_key((Term_t) -1);
+}
+
+ConcurrentDictionary::ConcurrentDictionary(uint64_t startingCounter) :
+    counter(startingCounter), nterms(0) {
+}
+
+uint64_t ConcurrentDictionary::hash(const char *text, size_t len) {
+    //FNV-1a
+    uint64_t h = 14695981039346656037ull;
+    for(size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char) text[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+int64_t ConcurrentDictionary::find(const Shard &shard, const char *text,
+        size_t len, uint64_t h, size_t &slot) {
+    const size_t mask = shard.slots.size() - 1;
+    //The lowest bits select the shard
+    slot = (h >> 6) & mask;
+    while (true) {
+        const uint32_t v = shard.slots[slot];
+        if (v == 0) {
+            return -1;
+        }
+        const uint64_t begin = shard.offsets[v - 1];
+        if (shard.offsets[v] - begin == len &&
+                memcmp(shard.arena.data() + begin, text, len) == 0) {
+            return v - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+void ConcurrentDictionary::grow(Shard &shard) {
+    std::vector<uint32_t> slots(shard.slots.size() * 2, 0);
+    const size_t mask = slots.size() - 1;
+    for(size_t i = 0; i < shard.ids.size(); ++i) {
+        const uint64_t begin = shard.offsets[i];
+        const uint64_t h = hash(shard.arena.data() + begin,
+                shard.offsets[i + 1] - begin);
+        size_t slot = (h >> 6) & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = i + 1;
+    }
+    shard.slots.swap(slots);
+}
+
+void ConcurrentDictionary::insert(size_t shardIdx, const char *text,
+        size_t len, uint64_t h, Term_t id) {
+    Shard &shard = shards[shardIdx];
+    //Keep the load factor below 3/4
+    if ((shard.ids.size() + 1) * 4 > shard.slots.size() * 3) {
+        grow(shard);
+    }
+    size_t slot;
+    find(shard, text, len, h, slot);
+    const uint64_t idx = shard.ids.size();
+    shard.arena.insert(shard.arena.end(), text, text + len);
+    shard.offsets.push_back(shard.arena.size());
+    shard.ids.push_back(id);
+    shard.slots[slot] = idx + 1;
+    nterms++;
+
+    ReverseShard &rshard = reverseShards[id % DICT_NSHARDS];
+    std::lock_guard<std::mutex> lock(rshard.mutex);
+    rshard.map.insert(std::make_pair(id, (shardIdx << 32) | idx));
+}
+
+bool ConcurrentDictionary::get(const char *text, size_t len,
+        Term_t &id) const {
+    const uint64_t h = hash(text, len);
+    const Shard &shard = shards[h % DICT_NSHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size_t slot;
+    const int64_t idx = find(shard, text, len, h, slot);
+    if (idx == -1) {
+        return false;
+    }
+    id = shard.ids[idx];
+    return true;
+}
+
+Term_t ConcurrentDictionary::getOrAdd(const char *text, size_t len) {
+    const uint64_t h = hash(text, len);
+    const size_t shardIdx = h % DICT_NSHARDS;
+    Shard &shard = shards[shardIdx];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size_t slot;
+    const int64_t idx = find(shard, text, len, h, slot);
+    if (idx != -1) {
+        return shard.ids[idx];
+    }
+    const Term_t id = counter++;
+    insert(shardIdx, text, len, h, id);
+    return id;
+}
+
+void ConcurrentDictionary::get(const std::vector<std::string> &rawValues,
+        std::vector<Term_t> &ids, std::vector<bool> &found) const {
+    ids.resize(rawValues.size());
+    found.resize(rawValues.size());
+    std::vector<uint64_t> hashes(rawValues.size());
+    std::vector<std::vector<size_t>> valuesPerShard(DICT_NSHARDS);
+    for(size_t i = 0; i < rawValues.size(); ++i) {
+        hashes[i] = hash(rawValues[i].c_str(), rawValues[i].size());
+        valuesPerShard[hashes[i] % DICT_NSHARDS].push_back(i);
+    }
+    for(size_t s = 0; s < DICT_NSHARDS; ++s) {
+        if (valuesPerShard[s].empty())
+            continue;
+        const Shard &shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for(auto i : valuesPerShard[s]) {
+            size_t slot;
+            const int64_t idx = find(shard, rawValues[i].c_str(),
+                    rawValues[i].size(), hashes[i], slot);
+            found[i] = idx != -1;
+            if (found[i])
+                ids[i] = shard.ids[idx];
+        }
+    }
+}
+
+void ConcurrentDictionary::getOrAdd(const std::vector<std::string> &rawValues,
+        std::vector<Term_t> &ids) {
+    ids.resize(rawValues.size());
+    //The new values get their IDs in the order of rawValues, as with one call
+    //of getOrAdd per value. Therefore, all the shards are locked at once
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for(size_t s = 0; s < DICT_NSHARDS; ++s) {
+        locks.push_back(std::unique_lock<std::mutex>(shards[s].mutex));
+    }
+    for(size_t i = 0; i < rawValues.size(); ++i) {
+        const std::string &v = rawValues[i];
+        const uint64_t h = hash(v.c_str(), v.size());
+        const size_t s = h % DICT_NSHARDS;
+        size_t slot;
+        const int64_t idx = find(shards[s], v.c_str(), v.size(), h, slot);
+        if (idx != -1) {
+            ids[i] = shards[s].ids[idx];
+        } else {
+            ids[i] = counter++;
+            insert(s, v.c_str(), v.size(), h, ids[i]);
+        }
+    }
+}
+
+bool ConcurrentDictionary::getRawValue(const Term_t id,
+        std::string &rawValue) const {
+    uint64_t ref;
+    {
+        const ReverseShard &rshard = reverseShards[id % DICT_NSHARDS];
+        std::lock_guard<std::mutex> lock(rshard.mutex);
+        auto itr = rshard.map.find(id);
+        if (itr == rshard.map.end()) {
+            return false;
+        }
+        ref = itr->second;
+    }
+    const Shard &shard = shards[ref >> 32];
+    const uint64_t idx = ref & 0xFFFFFFFFu;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const uint64_t begin = shard.offsets[idx];
+    rawValue.assign(shard.arena.data() + begin, shard.offsets[idx + 1] - begin);
+    return true;
+}
+
+bool ConcurrentDictionary::contains(const Term_t id) const {
+    const ReverseShard &rshard = reverseShards[id % DICT_NSHARDS];
+    std::lock_guard<std::mutex> lock(rshard.mutex);
+    return rshard.map.count(id);
+}
+
+size_t ConcurrentDictionary::getSizeInBytes() const {
+    size_t size = sizeof(ConcurrentDictionary);
+    for(size_t s = 0; s < DICT_NSHARDS; ++s) {
+        const Shard &shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.arena.capacity() +
+            shard.offsets.capacity() * sizeof(uint64_t) +
+            shard.ids.capacity() * sizeof(Term_t) +
+            shard.slots.capacity() * sizeof(uint32_t);
+        const ReverseShard &rshard = reverseShards[s];
+        std::lock_guard<std::mutex> rlock(rshard.mutex);
+        size += rshard.map.bucket_count() *
+            sizeof(std::pair<Term_t, uint64_t>);
+    }
+    return size;
+}
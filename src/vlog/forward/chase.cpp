@@ -1,6 +1,10 @@
 #include <vlog/chase.h>
 #include <vlog/ruleexecdetails.h>
 
+#include <fstream>
+#include <map>
+#include <algorithm>
+
 #ifdef WEBINTERFACE
 std::vector<std::pair<std::string, std::vector<StatsSizeIDB>>> Chase::getSizeIDBs() {
     std::vector<std::pair<std::string, std::vector<StatsSizeIDB>>> out;
@@ -53,6 +57,65 @@ void Chase::initRun() {
 #endif
     startTime = std::chrono::system_clock::now();
     statsRuleExecution.clear();
+    statsSpans.clear();
+}
+
+static void writeTraceEvent(std::ofstream &ofs, bool &first,
+        const std::string &name, const std::string &category,
+        double startms, double timems, int thread) {
+    if (!first) {
+        ofs << ",\n";
+    }
+    first = false;
+    //Chrome traces use microseconds
+    ofs << "{\"name\":\"" << name << "\",\"cat\":\"" << category <<
+        "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread <<
+        ",\"ts\":" << (uint64_t) (startms * 1000) <<
+        ",\"dur\":" << (uint64_t) (timems * 1000);
+}
+
+//Trace in the Chrome format (it can be opened with chrome://tracing or
+//Perfetto), with one event for every execution of a rule
+void Chase::writeTrace(const std::string &path) {
+    std::ofstream ofs(path);
+    ofs << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (auto &s : statsRuleExecution) {
+        if (s.startms < 0) {
+            continue;
+        }
+        writeTraceEvent(ofs, first, "rule " + std::to_string(s.idRule),
+                "rule", s.startms, s.timems - std::max(s.timems_retain, 0.0),
+                s.thread);
+        ofs << ",\"args\":{\"step\":" << s.step <<
+            ",\"rule\":" << s.idRule <<
+            ",\"input\":" << s.ninput <<
+            ",\"intermediate\":" << s.nintermediate <<
+            ",\"output\":" << s.nderivations_unfiltered <<
+            ",\"output_bytes\":" << s.outputbytes <<
+            ",\"merge_joins\":" << s.nmergejoins <<
+            ",\"hash_joins\":" << s.nhashjoins <<
+            ",\"sorts\":" << s.nsorts <<
+            ",\"cache_hits\":" << s.ncachehits <<
+            ",\"ms_first\":" << s.timems_first <<
+            ",\"ms_merge\":" << s.timems_merge <<
+            ",\"ms_join\":" << s.timems_join <<
+            ",\"ms_head\":" << s.timems_createhead <<
+            ",\"ms_restricted\":" << s.timems_restricted << "}}";
+        if (s.startms_retain >= 0) {
+            writeTraceEvent(ofs, first, "retain " + std::to_string(s.idRule),
+                    "retain", s.startms_retain, s.timems_retain, 0);
+            ofs << ",\"args\":{\"step\":" << s.step <<
+                ",\"rule\":" << s.idRule <<
+                ",\"new\":" << s.nderivations_final << "}}";
+        }
+    }
+    for (auto &s : statsSpans) {
+        writeTraceEvent(ofs, first, s.name, s.category, s.startms, s.timems,
+                s.thread);
+        ofs << "}";
+    }
+    ofs << "\n]}" << std::endl;
 }
 
 void Chase::stopRun() {
@@ -62,7 +125,8 @@ void Chase::stopRun() {
     if (shouldStoreStats()) {
         assert(profilerPath != "");
         std::ofstream ofs(profilerPath);
-        ofs << "STEP,RULEID,TIME_MS,TIME_MS_FIRST,TIME_MS_MERGE,TIME_MS_JOIN,TIME_MS_HEAD,TIME_MS_RETAIN,NDER_TOTAL,NDER_UNFIL,NDER_UNIQUE,N_BDY_ATOMS" << std::endl;
+        ofs << "IDX,STEP,RULEID,TIME_MS,TIME_MS_FIRST,TIME_MS_MERGE,TIME_MS_JOIN,TIME_MS_HEAD,TIME_MS_RETAIN,NDER_TOTAL,NDER_UNFIL,NDER_UNIQUE,N_BDY_ATOMS,"
+            "START_MS,THREAD,N_INPUT,N_INTERMEDIATE,N_MERGEJOINS,N_HASHJOINS,N_SORTS,N_CACHEHITS,OUTPUT_BYTES,TIME_MS_RESTRICTED" << std::endl;
         size_t idx = 0;
         for (auto &s : statsRuleExecution) {
             ofs << idx++ << ",";
@@ -77,9 +141,68 @@ void Chase::stopRun() {
             ofs << s.nderivations_final << ",";
             ofs << s.nderivations_unfiltered << ",";
             ofs << s.nderivations_unique << ",";
-            ofs << s.nbdyatoms << std::endl;
+            ofs << s.nbdyatoms << ",";
+            ofs << s.startms << ",";
+            ofs << s.thread << ",";
+            ofs << s.ninput << ",";
+            ofs << s.nintermediate << ",";
+            ofs << s.nmergejoins << ",";
+            ofs << s.nhashjoins << ",";
+            ofs << s.nsorts << ",";
+            ofs << s.ncachehits << ",";
+            ofs << s.outputbytes << ",";
+            ofs << s.timems_restricted << std::endl;
         }
         ofs.close();
+
+        //Summary with the total time of each rule, slowest first
+        std::map<int, StatsRule> rules;
+        std::map<int, size_t> nexecs;
+        for (auto &s : statsRuleExecution) {
+            if (!rules.count(s.idRule)) {
+                StatsRule r;
+                r.idRule = s.idRule;
+                r.timems = r.timems_retain = 0;
+                r.nderivations_final = r.nderivations_unfiltered = 0;
+                rules.insert(std::make_pair(s.idRule, r));
+            }
+            StatsRule &r = rules[s.idRule];
+            r.timems += s.timems;
+            r.timems_retain += std::max(s.timems_retain, 0.0);
+            r.nderivations_final += std::max(s.nderivations_final, 0l);
+            r.nderivations_unfiltered += std::max(s.nderivations_unfiltered, 0l);
+            nexecs[s.idRule]++;
+        }
+        std::vector<StatsRule> summary;
+        for (auto &p : rules) {
+            summary.push_back(p.second);
+        }
+        std::sort(summary.begin(), summary.end(),
+                [](const StatsRule &a, const StatsRule &b) {
+                return a.timems > b.timems;
+                });
+        std::ofstream ofss(profilerPath + "-summary.csv");
+        ofss << "RULEID,N_EXEC,TIME_MS,TIME_MS_RETAIN,NDER_TOTAL,NDER_UNFIL,RULE" << std::endl;
+        for (auto &r : summary) {
+            std::string rule = "";
+            if (r.idRule >= 0 && r.idRule < getProgram()->getNRules()) {
+                rule = getProgram()->getRule(r.idRule).tostring(
+                        getProgram(), &getEDBLayer());
+            }
+            std::string escaped = "\"";
+            for (char c : rule) {
+                if (c == '"')
+                    escaped += '"';
+                escaped += c;
+            }
+            escaped += "\"";
+            ofss << r.idRule << "," << nexecs[r.idRule] << "," << r.timems <<
+                "," << r.timems_retain << "," << r.nderivations_final << "," <<
+                r.nderivations_unfiltered << "," << escaped << std::endl;
+        }
+        ofss.close();
+
+        writeTrace(profilerPath + "-trace.json");
     }
 }
 
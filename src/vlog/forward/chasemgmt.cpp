@@ -3,22 +3,13 @@
 //************** ROWS ***************
 uint64_t ChaseMgmt::Rows::addRow(uint64_t* row) {
     // LOG(TRACEL) << "Addrow: " << row[0];
-    if (!currentblock || blockCounter >= SIZE_BLOCK) {
-        //Create a new block
-        std::unique_ptr<uint64_t[]> n =
-            std::unique_ptr<uint64_t[]>(
-                    new uint64_t[sizerow * SIZE_BLOCK]);
-        currentblock = n.get();
-        blocks.push_back(std::move(n));
-        blockCounter = 0;
-    }
-    for(uint8_t i = 0; i < sizerow; ++i) {
-        currentblock[i] = row[i];
+    bool inserted;
+    const size_t idx = rows.insert(row, inserted);
+    if (inserted) {
+        values.push_back(currentcounter);
+    } else {
+        values[idx] = currentcounter;
     }
-    ChaseRow r(sizerow, currentblock);
-    rows[r] = currentcounter;
-    currentblock += sizerow;
-    blockCounter++;
     if (((uint32_t)currentcounter) == UINT32_MAX) {
         LOG(ERRORL) << "I can assign at most 2^32 new IDs to an ext. variable... Stop!";
         throw 10;
@@ -39,20 +30,16 @@ uint64_t ChaseMgmt::Rows::addRow(uint64_t* row) {
 }
 
 bool ChaseMgmt::Rows::existingRow(uint64_t *row, uint64_t &value) {
-    ChaseRow r(sizerow, row);
-    auto search = rows.find(r);
-    if (search != rows.end()) {
-        value = search->second;
+    const int64_t idx = rows.find(row);
+    if (idx != -1) {
+        value = values[idx];
         return true;
     }
     return false;
 }
 
 uint64_t *ChaseMgmt::Rows::getRow(size_t id) {
-    uint64_t blocknr = id / SIZE_BLOCK;
-    uint64_t offset = id % SIZE_BLOCK;
-    auto &block_content = blocks[blocknr];
-    return block_content.get() + offset * sizerow;
+    return rows.getRow(id);
 }
 
 static bool checkValue(uint64_t target, uint64_t v, std::set<uint64_t> &toCheck) {
@@ -117,12 +104,9 @@ bool ChaseMgmt::Rows::checkRecursive(uint64_t target, uint64_t value, std::set<u
         }
     }
     else {
-        // Find the right block to check
-        size_t blockNo = value / SIZE_BLOCK;
-        size_t offset = (value % SIZE_BLOCK) * sizerow;
-        auto block = blocks[blockNo].get();
-        for (size_t i = offset; i < offset + sizerow; i++) {
-            if (checkValue(target, block[i], toCheck)) {
+        const uint64_t *row = rows.getRow(value);
+        for (size_t i = 0; i < sizerow; i++) {
+            if (checkValue(target, row[i], toCheck)) {
                 return true;
             }
         }
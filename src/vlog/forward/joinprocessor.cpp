@@ -2109,6 +2109,8 @@ void JoinExecutor::do_mergejoin(const FCInternalTable * filteredT1,
             t2Size = vectors2[0]->size();
         }
         assert(t2->getNRows() == t2Size);
+        const bool parallel = nthreads > 1 && totalsize1 > 1 &&
+            (totalsize1 + t2Size) > 4096;
         if (faster) {
             sortedItr2 = new VectorFCInternalTableItr(vectors2, 0, t2Size);
             LOG(TRACEL) << "Faster algo";
@@ -2122,12 +2124,17 @@ void JoinExecutor::do_mergejoin(const FCInternalTable * filteredT1,
         } else {
             LOG(TRACEL) << "Classical algo";
             LOG(TRACEL) << "totalsize1 = " << totalsize1 << ", t2Size = " << t2Size;
-            if (/* vectorSupported && */ nthreads > 1 && totalsize1 > 1 && (totalsize1 + t2Size) > 4096 /* ? */) {
+            if (/* vectorSupported && */ parallel) {
                 LOG(TRACEL) << "Chunk size = " << chunks << ", t2->getNRows() = " << t2Size;
-                if (vector2Supported) {
+                if (vector2Supported && vectors2.size() > 0) {
+                    //Each morsel looks up its range in vectors2 with a binary
+                    //search, so it can be small. Every task writes in its own
+                    //Output buffer, which is flushed into output
+                    const size_t morsel = std::min(chunks,
+                            (size_t) JOIN_MORSEL_SIZE);
                     //tbb::parallel_for(tbb::blocked_range<int>(0, totalsize1, chunks),
                     //        CreateParallelMergeJoinerVectors(vectors, vectors2, fields1, fields2, posBlocks, nValBlocks, valBlocks, output, &m));
-                    ParallelTasks::parallel_for(0, totalsize1, chunks,
+                    ParallelTasks::parallel_for(0, totalsize1, morsel,
                             CreateParallelMergeJoinerVectors(vectors, vectors2,
                                 fields1, fields2, posBlocks, nValBlocks,
                                 valBlocks, output, &m));
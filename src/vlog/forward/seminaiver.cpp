@@ -1709,7 +1709,7 @@ void SemiNaiver::printCountAllIDBs(std::string prefix) {
         }
     }
     LOG(DEBUGL) << prefix << "Predicates without derivation: " << emptyRel;
-    LOG(DEBUGL) << prefix << "Total # derivations: " << c;
+    LOG(INFOL) << prefix << "Total # derivations: " << c;
 }
 
 std::pair<uint8_t, uint8_t> SemiNaiver::removePosConstants(
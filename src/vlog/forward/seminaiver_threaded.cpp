@@ -22,17 +22,17 @@ bool SemiNaiverThreaded::executeUntilSaturation(
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
         //LOG(INFOL) << "Creating threads ...";
         //Create a shared datastructure to record the execution of the rules
-        StatusRuleExecution_ThreadSafe status(ruleset.size());
+        StatusRuleExecution_ThreadSafe status(ruleset.size(), interRuleThreads);
+        std::vector<SemiNaiver_Threadlocal> threadData(interRuleThreads);
 
         //Execute the rules on multiple threads
-        size_t iterationBeginBlock = iteration;
         for (int i = 0; i < interRuleThreads; ++i) {
             threads[i] = std::thread(&SemiNaiverThreaded::runThread,
                     this,
                     std::ref(ruleset),
                     &status,
-                    &costRules,
-                    iterationBeginBlock);
+                    &threadData[i],
+                    i);
         }
 
         //Wait until all threads are finished
@@ -40,6 +40,15 @@ bool SemiNaiverThreaded::executeUntilSaturation(
             threads[i].join();
         }
 
+        //Merge the data of the threads
+        for (auto &data : threadData) {
+            costRules.insert(costRules.end(), data.costRules.begin(),
+                    data.costRules.end());
+            for (auto predId : data.derivedPredicates) {
+                newMarked[predId] = true;
+            }
+        }
+
         //Copy all the derivations produced by the rules in the KB
         anotherRound = false;
         // anotherRound = doGlobalConsolidation(status);
@@ -142,105 +151,78 @@ bool SemiNaiverThreaded::doGlobalConsolidation(
     return response;
 }
 
+void SemiNaiverThreaded::getRulePredicates(RuleExecutionDetails &rule,
+        std::vector<PredId_t> &predicates) {
+    predicates.clear();
+    predicates.push_back(rule.rule.getFirstHead().getPredicate().getId());
+    for (const auto &literal : rule.rule.getBody()) {
+        if (literal.getPredicate().getType() == IDB) {
+            predicates.push_back(literal.getPredicate().getId());
+        }
+    }
+    // Sort predicates, to avoid deadlock
+    std::sort(predicates.begin(), predicates.end());
+}
+
 void SemiNaiverThreaded::runThread(
         std::vector<RuleExecutionDetails> &ruleset,
         StatusRuleExecution_ThreadSafe *status,
-        std::vector<StatIteration> *costRules,
-        size_t lastExec) {
-
-    int ruleToExecute = status->getRuleIDToExecute();
-    SemiNaiver_Threadlocal *data = new SemiNaiver_Threadlocal();
-    thread_data.reset(data);
-
-    std::vector<ResultJoinProcessor*> res;
-
-    while (ruleToExecute != -1) {
-
-        //Get atomic iteration
-        data->iteration = getAtomicIteration();
-        Literal headLiteral = ruleset[ruleToExecute].rule.getFirstHead();
-        PredId_t idHeadPredicate = headLiteral.getPredicate().getId();
-        std::vector<PredId_t> predicates;
-        predicates.push_back(idHeadPredicate);
-        std::vector<Literal> body = ruleset[ruleToExecute].rule.getBody();
-        for (std::vector<Literal>::const_iterator itr = body.begin(); itr != body.end(); ++itr) {
-            if (itr->getPredicate().getType() == IDB) {
-                predicates.push_back(itr->getPredicate().getId());
-            }
+        SemiNaiver_Threadlocal *data,
+        const int threadIdx) {
+
+    //Rules whose predicates were locked by other threads. They are executed
+    //once there are no other rules to take
+    std::vector<int> postponedRules;
+    std::vector<PredId_t> predicates;
+    int ruleToExecute = status->getRuleIDToExecute(threadIdx);
+
+    while (ruleToExecute != -1 || !postponedRules.empty()) {
+        bool canWait = false;
+        if (ruleToExecute == -1) {
+            ruleToExecute = postponedRules.back();
+            postponedRules.pop_back();
+            canWait = true;
+        }
+        PredId_t idHeadPredicate = ruleset[ruleToExecute].rule.getFirstHead().
+            getPredicate().getId();
+        getRulePredicates(ruleset[ruleToExecute], predicates);
+        if (canWait) {
+            lock(predicates, idHeadPredicate);
+        } else if (!tryLock(predicates, idHeadPredicate)) {
+            postponedRules.push_back(ruleToExecute);
+            ruleToExecute = status->getRuleIDToExecute(threadIdx);
+            continue;
         }
-        // Sort predicates, to avoid deadlock
-        std::sort(predicates.begin(), predicates.end());
-
-        lock(predicates, idHeadPredicate);
 
-        //Execute the rule
-        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-        bool response = executeRule(ruleset[ruleToExecute],
-                data->iteration,
-		0,
-                // &res);
-        NULL);
-        std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
-        StatIteration stat;
-        stat.iteration = data->iteration;
-        stat.rule = &ruleset[ruleToExecute].rule;
-        stat.time = sec.count() * 1000;
-        stat.derived = response;
-
-        //Add statistics
-        mutexInsert.lock();
-        costRules->push_back(stat);
-        mutexInsert.unlock();
-
-        //Change it to "lastExecution"
-        // ruleset[ruleToExecute].lastExecution = lastExec;
-        ruleset[ruleToExecute].lastExecution = data->iteration;
-
-        if (response) {
-            newMarked[idHeadPredicate] = true;
-            marked[idHeadPredicate] = true;
-            if (ruleset[ruleToExecute].rule.isRecursive()) {
-                int recursiveIterations = 0;
-                do {
-                    // LOG(INFOL) << "Iteration " << iteration;
-                    data->iteration = getAtomicIteration();
-                    start = std::chrono::system_clock::now();
-                    recursiveIterations++;
-                    response = executeRule(ruleset[ruleToExecute],
-                            data->iteration,
-			    0,
-                            // &res);
+        //Execute the rule. If it is recursive, execute it until it does not
+        //derive anything new
+        bool response;
+        int recursiveIterations = 0;
+        do {
+            data->iteration = getAtomicIteration();
+            std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+            response = executeRule(ruleset[ruleToExecute],
+                    data->iteration,
+                    0,
                     NULL);
-
-                    ruleset[ruleToExecute].lastExecution = data->iteration;
-                    sec = std::chrono::system_clock::now() - start;
-                    ++recursiveIterations;
-                    stat.iteration = data->iteration;
-                    stat.rule = &ruleset[ruleToExecute].rule;
-                    stat.time = sec.count() * 1000;
-                    stat.derived = response;
-                    mutexInsert.lock();
-                    costRules->push_back(stat);
-                    mutexInsert.unlock();
-                    /*if (++recursiveIterations % 10 == 0) {
-                      LOG(INFOL) << "Saturating rule " <<
-                      ruleset[currentRule].rule.tostring(program, dict) <<
-                      " " << recursiveIterations;
-                      }*/
-                } while (response);
-                    LOG(DEBUGL) << "Rule required " << recursiveIterations << " to saturate";
+            std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+            StatIteration stat;
+            stat.iteration = data->iteration;
+            stat.rule = &ruleset[ruleToExecute].rule;
+            stat.time = sec.count() * 1000;
+            stat.derived = response;
+            data->costRules.push_back(stat);
+            ruleset[ruleToExecute].lastExecution = data->iteration;
+            if (response && recursiveIterations == 0) {
+                data->derivedPredicates.push_back(idHeadPredicate);
             }
-        }
+            recursiveIterations++;
+        } while (response && ruleset[ruleToExecute].rule.isRecursive());
+        LOG(DEBUGL) << "Rule required " << recursiveIterations << " to saturate";
 
         unlock(predicates, idHeadPredicate);
 
-        ruleToExecute = status->getRuleIDToExecute();
-    }
-
-    //Register the derivations
-    if (!res.empty()) {
-        for (auto &el : res)
-            status->registerDerivations(el);
+        ruleToExecute = status->getRuleIDToExecute(threadIdx);
     }
 }
 
@@ -259,20 +241,33 @@ void SemiNaiverThreaded::saveStatistics(StatsRule &stats) {
     SemiNaiver::saveStatistics(stats);
 }
 
-StatusRuleExecution_ThreadSafe::StatusRuleExecution_ThreadSafe(const int nrules)
-    : rulecount(0), nrules(nrules) {
+StatusRuleExecution_ThreadSafe::StatusRuleExecution_ThreadSafe(const int nrules,
+        const int nqueues)
+    : nrules(nrules), nqueues(nqueues > 0 ? nqueues : 1),
+    nextRule(new std::atomic<int>[nqueues > 0 ? nqueues : 1]) {
+        //Each queue gets a contiguous range of rules
+        for (int i = 0; i < this->nqueues; ++i) {
+            nextRule[i] = (int64_t)nrules * i / this->nqueues;
+            endRule.push_back((int64_t)nrules * (i + 1) / this->nqueues);
+        }
     }
 
-
-int StatusRuleExecution_ThreadSafe::getRuleIDToExecute() {
+int StatusRuleExecution_ThreadSafe::getRuleIDToExecute(const int queueIdx) {
     //Return -1 if no rule is available. Otherwise return the ID of the rule to
-    //execute.
-    std::lock_guard<std::mutex> lock(mutexRules);
-    if (rulecount == nrules) {
-        return -1;
+    //execute. First take the rules of the own queue, then the ones left in
+    //the others
+    for (int i = 0; i < nqueues; ++i) {
+        const int q = (queueIdx + i) % nqueues;
+        if (nextRule[q].load(std::memory_order_relaxed) >= endRule[q]) {
+            continue;
+        }
+        int rule = nextRule[q].fetch_add(1);
+        if (rule < endRule[q]) {
+            LOG(DEBUGL) << "Got rule " << rule;
+            return rule;
+        }
     }
-    LOG(DEBUGL) << "Got rule " << rulecount;
-    return rulecount++;
+    return -1;
 }
 
 void StatusRuleExecution_ThreadSafe::registerDerivations(
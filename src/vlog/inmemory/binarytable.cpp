@@ -0,0 +1,307 @@
+#include <vlog/inmemory/binarytable.h>
+#include <vlog/inmemory/inmemorytable.h>
+#include <vlog/segment.h>
+#include <vlog/edb.h>
+
+#include <kognac/utils.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <cstring>
+#include <climits>
+
+#define BINARYTABLE_MAGIC "VLOGBIN1"
+#define BINARYTABLE_VERSION 1
+#define BINARYTABLE_HEADER_WORDS 6
+
+static void writeWord(std::ostream &out, uint64_t v) {
+    out.write((const char*)&v, sizeof(uint64_t));
+}
+
+static std::vector<std::vector<uint8_t>> getSortOrders(uint8_t arity) {
+    std::vector<std::vector<uint8_t>> orders;
+    std::vector<uint8_t> fields;
+    for(uint8_t i = 0; i < arity; ++i) {
+        fields.push_back(i);
+    }
+    if (arity <= BINARYTABLE_MAX_ARITY_ALLPERMS) {
+        //next_permutation starts from the identity, which must be the first
+        do {
+            orders.push_back(fields);
+        } while (std::next_permutation(fields.begin(), fields.end()));
+    } else {
+        orders.push_back(fields);
+        for(uint8_t i = 1; i < arity; ++i) {
+            std::vector<uint8_t> order;
+            order.push_back(i);
+            for(uint8_t j = 0; j < arity; ++j) {
+                if (j != i)
+                    order.push_back(j);
+            }
+            orders.push_back(order);
+        }
+    }
+    return orders;
+}
+
+static uint64_t packOrder(const std::vector<uint8_t> &order) {
+    uint64_t v = 0;
+    for(size_t i = 0; i < order.size() && i < 8; ++i) {
+        v |= (uint64_t)order[i] << (i * 8);
+    }
+    return v;
+}
+
+//Throws if count values of the given size starting at offset do not fit in
+//the file. Every offset read from the file is checked before it is used
+static void checkInFile(const std::string &path, size_t fileSize,
+        uint64_t offset, uint64_t count, uint64_t size) {
+    if (offset > fileSize || (size > 0 && count > (fileSize - offset) / size)) {
+        LOG(ERRORL) << "The binary table " << path << " is corrupted";
+        throw 10;
+    }
+}
+
+BinaryTableFile::BinaryTableFile(const std::string &path) : path(path),
+    fd(-1), mapped(NULL), mappedSize(0), arity(0), nrows(0), nterms(0),
+    termIds(NULL), termOffsets(NULL), terms(NULL) {
+    //The destructor is not called if the constructor throws
+    try {
+        load();
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+void BinaryTableFile::load() {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        LOG(ERRORL) << "Cannot open the binary table " << path;
+        throw 10;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+            st.st_size < (BINARYTABLE_HEADER_WORDS + 1) * 8) {
+        LOG(ERRORL) << "The file " << path << " is not a binary table";
+        throw 10;
+    }
+    mappedSize = st.st_size;
+    void *addr = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        LOG(ERRORL) << "Cannot map the binary table " << path;
+        throw 10;
+    }
+    mapped = (char*)addr;
+    if (memcmp(mapped, BINARYTABLE_MAGIC, 8) != 0) {
+        LOG(ERRORL) << "The file " << path << " is not a binary table";
+        throw 10;
+    }
+
+    const uint64_t *header = (const uint64_t*)(mapped + 8);
+    if (header[0] != BINARYTABLE_VERSION) {
+        LOG(ERRORL) << "Version " << header[0] << " of the binary table is "
+            "not supported";
+        throw 10;
+    }
+    if (header[1] > 8) {
+        LOG(ERRORL) << "The binary table " << path << " is corrupted";
+        throw 10;
+    }
+    arity = header[1];
+    nrows = header[2];
+    nterms = header[3];
+    const size_t norders = header[4];
+
+    uint64_t offset = 8 + (BINARYTABLE_HEADER_WORDS - 1) * 8;
+    checkInFile(path, mappedSize, offset, nterms, 8);
+    termIds = (const Term_t*)(mapped + offset);
+    offset += nterms * 8;
+    checkInFile(path, mappedSize, offset, nterms + 1, 8);
+    termOffsets = (const uint64_t*)(mapped + offset);
+    offset += (nterms + 1) * 8;
+    const uint64_t stringsLen = termOffsets[nterms];
+    checkInFile(path, mappedSize, offset, stringsLen, 1);
+    for(size_t i = 0; i < nterms; ++i) {
+        if (termOffsets[i] > termOffsets[i + 1]) {
+            LOG(ERRORL) << "The binary table " << path << " is corrupted";
+            throw 10;
+        }
+    }
+    terms = mapped + offset;
+    const size_t stringsSize = (stringsLen + 7) / 8 * 8;
+    checkInFile(path, mappedSize, offset, stringsSize, 1);
+    offset += stringsSize;
+    for(size_t i = 0; i < norders; ++i) {
+        checkInFile(path, mappedSize, offset, 1, 8);
+        const uint64_t *p = (const uint64_t*)(mapped + offset);
+        offset += 8;
+        std::vector<uint8_t> order;
+        for(uint8_t j = 0; j < arity; ++j) {
+            order.push_back((*p >> (j * 8)) & 0xFF);
+        }
+        checkInFile(path, mappedSize, offset, nrows, (uint64_t)arity * 8);
+        orders.push_back(order);
+        orderColumns.push_back(p + 1);
+        offset += (uint64_t)arity * 8 * nrows;
+    }
+    if (offset != mappedSize) {
+        LOG(ERRORL) << "The binary table " << path << " is corrupted";
+        throw 10;
+    }
+}
+
+void BinaryTableFile::unmap() {
+    if (mapped != NULL) {
+        munmap(mapped, mappedSize);
+        mapped = NULL;
+    }
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+BinaryTableFile::~BinaryTableFile() {
+    unmap();
+}
+
+void BinaryTableFile::create(const std::string &path, uint8_t arity,
+        std::shared_ptr<const Segment> segment, EDBLayer &layer,
+        int nthreads) {
+    if (arity > 8) {
+        LOG(ERRORL) << "Binary tables support at most 8 columns";
+        throw 10;
+    }
+    const size_t nrows = segment == NULL ? 0 : segment->getNRows();
+
+    //Collect the terms used in the table. Numbers are not in the dictionary
+    std::vector<Term_t> ids;
+    for(uint8_t i = 0; i < arity && nrows > 0; ++i) {
+        auto values = segment->getColumn(i)->getReader()->asVector();
+        for(auto v : values) {
+            if (!IS_NUMBER(v))
+                ids.push_back(v);
+        }
+    }
+    if (nthreads > 1)
+        ParallelTasks::sort_int(ids.begin(), ids.end());
+    else
+        std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::ofstream out(path, std::ios_base::binary | std::ios_base::trunc);
+    if (!out) {
+        LOG(ERRORL) << "Cannot create the binary table " << path;
+        throw 10;
+    }
+    auto orders = getSortOrders(arity);
+    out.write(BINARYTABLE_MAGIC, 8);
+    writeWord(out, BINARYTABLE_VERSION);
+    writeWord(out, arity);
+    writeWord(out, nrows);
+    writeWord(out, ids.size());
+    writeWord(out, orders.size());
+
+    //Dictionary
+    std::string strings;
+    std::vector<uint64_t> offsets;
+    for(auto id : ids) {
+        writeWord(out, id);
+        offsets.push_back(strings.size());
+        strings += layer.getDictText(id);
+    }
+    offsets.push_back(strings.size());
+    for(auto o : offsets) {
+        writeWord(out, o);
+    }
+    strings.resize((strings.size() + 7) / 8 * 8, '\0');
+    out.write(strings.c_str(), strings.size());
+
+    //Sort orders
+    for(const auto &order : orders) {
+        writeWord(out, packOrder(order));
+        if (nrows == 0)
+            continue;
+        std::shared_ptr<const Segment> sorted = segment;
+        if (&order != &orders[0]) {
+            sorted = segment->sortBy(&order, nthreads, false);
+        }
+        for(uint8_t i = 0; i < arity; ++i) {
+            auto values = sorted->getColumn(i)->getReader()->asVector();
+            out.write((const char*)values.data(),
+                    values.size() * sizeof(Term_t));
+        }
+    }
+    if (!out) {
+        LOG(ERRORL) << "Error while writing the binary table " << path;
+        throw 10;
+    }
+    LOG(INFOL) << "Written " << nrows << " rows, " << orders.size() <<
+        " orders and " << ids.size() << " terms in " << path;
+}
+
+//The params of the tables that are not converted are copied in a new
+//edb.conf, so relative paths must not depend on the original directory
+static std::string getAbsoluteParam(const std::string &rootPath,
+        const std::string &param) {
+    if (param.empty() || Utils::isAbsolutePath(param) ||
+            !Utils::exists(Utils::join(rootPath, param))) {
+        //Not a path (e.g., a separator or a URL)
+        return param;
+    }
+    std::string path = Utils::join(rootPath, param);
+    if (!Utils::isAbsolutePath(path)) {
+        char cwd[PATH_MAX];
+        if (getcwd(cwd, sizeof(cwd)) == NULL) {
+            LOG(ERRORL) << "Cannot get the current directory";
+            throw 10;
+        }
+        path = Utils::join(std::string(cwd), path);
+    }
+    return path;
+}
+
+void BinaryTableFile::convert(const EDBConf &conf, EDBLayer &layer,
+        const std::string &outputDir, int nthreads) {
+    Utils::create_directories(outputDir);
+    std::ofstream edbconf(outputDir + DIR_SEP + "edb.conf");
+    if (!edbconf) {
+        LOG(ERRORL) << "Cannot create the file edb.conf in " << outputDir;
+        throw 10;
+    }
+    //Tables must be converted in the same order in which they are loaded, so
+    //that the IDs in the files match those assigned when they are loaded
+    const auto &tables = conf.getTables();
+    for(size_t i = 0; i < tables.size(); ++i) {
+        const auto &table = tables[i];
+        const std::string prefix = "EDB" + std::to_string(i) + "_";
+        edbconf << prefix << "predname=" << table.predname << std::endl;
+        if (table.type != "CSV" && table.type != "INMEMORY") {
+            //Other tables are copied as they are
+            edbconf << prefix << "type=" << table.type << std::endl;
+            for(size_t j = 0; j < table.params.size(); ++j) {
+                edbconf << prefix << "param" << j << "=" <<
+                    getAbsoluteParam(conf.getRootPath(), table.params[j]) <<
+                    std::endl;
+            }
+            continue;
+        }
+        auto predId = layer.getPredID(table.predname);
+        auto inmemory = std::dynamic_pointer_cast<InmemoryTable>(
+                layer.getEDBTable(predId));
+        if (inmemory == NULL) {
+            LOG(ERRORL) << "The table " << table.predname << " is not loaded";
+            throw 10;
+        }
+        const std::string filename = table.predname + ".vbin";
+        create(outputDir + DIR_SEP + filename, inmemory->getArity(),
+                inmemory->getSegment(), layer, nthreads);
+        edbconf << prefix << "type=BINARY" << std::endl;
+        edbconf << prefix << "param0=" << filename << std::endl;
+    }
+}
@@ -7,9 +7,254 @@
 
 #include <zstr/zstr.hpp>
 
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+//Files are split in (n. threads * INMEMORY_CHUNKS_PER_THREAD) chunks
+#define INMEMORY_CHUNKS_PER_THREAD 4
+#define INMEMORY_READ_BLOCK (64 * 1024 * 1024)
+
 void dump() {
 }
 
+//Field of a CSV file, which points to the buffer that contains the file
+struct CSVField {
+    const char *s;
+    size_t len;
+
+    bool operator ==(const CSVField &other) const {
+        return len == other.len && memcmp(s, other.s, len) == 0;
+    }
+};
+
+struct CSVFieldHasher {
+    size_t operator ()(const CSVField &f) const {
+        //FNV-1a
+        uint64_t h = 14695981039346656037ull;
+        for(size_t i = 0; i < f.len; ++i) {
+            h = (h ^ (uint8_t)f.s[i]) * 1099511628211ull;
+        }
+        return h;
+    }
+};
+
+//Rows of a chunk, encoded with the IDs of a local dictionary
+struct CSVChunk {
+    const char *begin;
+    const char *end;
+    std::vector<CSVField> terms; //In order of first appearance
+    std::vector<uint32_t> rows;
+    size_t nrows;
+    bool wrongArity;
+
+    CSVChunk() : begin(NULL), end(NULL), nrows(0), wrongArity(false) {}
+};
+
+struct CSVBuffer : public std::streambuf {
+    CSVBuffer(char *begin, char *end) {
+        setg(begin, begin, end);
+    }
+};
+
+static std::string readAll(istream &ifs) {
+    std::string content;
+    size_t size = 0;
+    while (ifs) {
+        content.resize(size + INMEMORY_READ_BLOCK);
+        ifs.read(&content[size], INMEMORY_READ_BLOCK);
+        size += ifs.gcount();
+    }
+    content.resize(size);
+    return content;
+}
+
+//Append to batch (which starts with the incomplete line of the previous
+//batch) the next block of the file, up to the last complete line. The rest
+//is left in rest. At the end of the file, batch contains all the remaining
+//data
+static void readBatch(istream &ifs, std::string &batch, std::string &rest) {
+    batch.swap(rest);
+    rest.clear();
+    while (true) {
+        const size_t size = batch.size();
+        batch.resize(size + INMEMORY_READ_BLOCK);
+        ifs.read(&batch[size], INMEMORY_READ_BLOCK);
+        batch.resize(size + ifs.gcount());
+        if (!ifs) {
+            return;
+        }
+        const size_t eol = batch.rfind('\n');
+        if (eol != std::string::npos) {
+            rest.assign(batch, eol + 1, std::string::npos);
+            batch.resize(eol + 1);
+            return;
+        }
+    }
+}
+
+static void parseCSVChunk(CSVChunk &chunk, char sep, uint8_t arity) {
+    static const char *empty = "<EMPTY>";
+    std::unordered_map<CSVField, uint32_t, CSVFieldHasher> localDict;
+    const char *p = chunk.begin;
+    while (p < chunk.end) {
+        //memchr is vectorized, so the delimiters are found quickly
+        const char *eol = (const char*)memchr(p, '\n', chunk.end - p);
+        if (eol == NULL)
+            eol = chunk.end;
+        uint8_t nfields = 0;
+        while (true) {
+            const char *e = (const char*)memchr(p, sep, eol - p);
+            if (e == NULL)
+                e = eol;
+            if (nfields == arity) {
+                chunk.wrongArity = true;
+                return;
+            }
+            CSVField f;
+            f.s = p;
+            f.len = e - p;
+            if (f.len == 0) {
+                f.s = empty;
+                f.len = strlen(empty);
+            }
+            auto itr = localDict.find(f);
+            if (itr == localDict.end()) {
+                itr = localDict.insert(std::make_pair(f,
+                            (uint32_t)chunk.terms.size())).first;
+                chunk.terms.push_back(f);
+            }
+            chunk.rows.push_back(itr->second);
+            nfields++;
+            if (e == eol)
+                break;
+            p = e + 1;
+        }
+        if (nfields != arity) {
+            chunk.wrongArity = true;
+            return;
+        }
+        chunk.nrows++;
+        p = eol + 1;
+    }
+}
+
+//Parse a batch of complete lines with multiple threads and append its rows
+//to values. The terms of the batch are added to the dictionary with one call,
+//in order of first appearance
+static void loadCSVBatch(const std::string &batch, char sep, EDBLayer *layer,
+        int nthreads, const std::string &tablefile, uint8_t arity,
+        std::vector<std::vector<Term_t>> &values) {
+    const char *begin = batch.c_str();
+    const char *end = begin + batch.size();
+
+    //Split the batch on line boundaries
+    const size_t nchunks = nthreads * INMEMORY_CHUNKS_PER_THREAD;
+    const size_t chunkSize = batch.size() / nchunks + 1;
+    std::vector<CSVChunk> chunks;
+    const char *p = begin;
+    while (p < end) {
+        chunks.emplace_back();
+        chunks.back().begin = p;
+        const char *e = p + std::min(chunkSize, (size_t)(end - p));
+        if (e < end) {
+            e = (const char*)memchr(e, '\n', end - e);
+            e = e == NULL ? end : e + 1;
+        }
+        chunks.back().end = e;
+        p = e;
+    }
+
+    ParallelTasks::parallel_for(0, chunks.size(), 1,
+            [&](const ParallelRange &r) {
+        for(size_t i = r.begin(); i < r.end(); ++i) {
+            parseCSVChunk(chunks[i], sep, arity);
+        }
+    });
+
+    //Merge the local dictionaries following the order of the chunks
+    std::unordered_map<CSVField, size_t, CSVFieldHasher> batchDict;
+    std::vector<std::string> texts;
+    std::vector<std::vector<size_t>> localToBatch(chunks.size());
+    std::vector<size_t> startRows(chunks.size());
+    size_t nrows = values[0].size();
+    for(size_t i = 0; i < chunks.size(); ++i) {
+        const auto &chunk = chunks[i];
+        if (chunk.wrongArity) {
+            LOG(ERRORL) << "Multiple arities";
+            throw ("Multiple arities in file " + tablefile);
+        }
+        startRows[i] = nrows;
+        nrows += chunk.nrows;
+        auto &l2b = localToBatch[i];
+        l2b.resize(chunk.terms.size());
+        for(size_t j = 0; j < chunk.terms.size(); ++j) {
+            auto itr = batchDict.find(chunk.terms[j]);
+            if (itr == batchDict.end()) {
+                itr = batchDict.insert(std::make_pair(chunk.terms[j],
+                            texts.size())).first;
+                texts.push_back(std::string(chunk.terms[j].s,
+                            chunk.terms[j].len));
+            }
+            l2b[j] = itr->second;
+        }
+    }
+    std::vector<uint64_t> ids;
+    layer->getOrAddDictNumbers(texts, ids);
+
+    //Fill the columns with the global IDs
+    for(auto &v : values) {
+        v.resize(nrows);
+    }
+    ParallelTasks::parallel_for(0, chunks.size(), 1,
+            [&](const ParallelRange &r) {
+        for(size_t i = r.begin(); i < r.end(); ++i) {
+            const auto &chunk = chunks[i];
+            const auto &l2b = localToBatch[i];
+            for(size_t row = 0; row < chunk.nrows; ++row) {
+                for(uint8_t c = 0; c < arity; ++c) {
+                    values[c][startRows[i] + row] =
+                        ids[l2b[chunk.rows[row * arity + c]]];
+                }
+            }
+        }
+    });
+}
+
+//Load a CSV file without quoted fields with multiple threads. The file is
+//read in batches of INMEMORY_READ_BLOCK bytes, so that only one batch of
+//text is in memory. Like readRow, all the '\r' are ignored, and the terms
+//get the same IDs that readRow would produce. If a batch contains a quote,
+//the remaining data is returned in tail, to be parsed sequentially
+static void loadCSVParallel(istream &ifs, char sep, EDBLayer *layer,
+        int nthreads, const std::string &tablefile, uint8_t &arity,
+        std::vector<std::vector<Term_t>> &values, std::string &tail) {
+    std::string batch, rest;
+    while (true) {
+        readBatch(ifs, batch, rest);
+        if (batch.empty()) {
+            return;
+        }
+        if (batch.find('"') != std::string::npos) {
+            //Quoted fields can contain separators and newlines
+            tail = batch + rest + readAll(ifs);
+            return;
+        }
+        batch.erase(std::remove(batch.begin(), batch.end(), '\r'),
+                batch.end());
+        if (arity == 0) {
+            //The arity is determined by the first row
+            arity = 1;
+            for(size_t i = 0; i < batch.size() && batch[i] != '\n'; ++i) {
+                if (batch[i] == sep)
+                    arity++;
+            }
+            values.resize(arity);
+        }
+        loadCSVBatch(batch, sep, layer, nthreads, tablefile, arity, values);
+    }
+}
+
 std::vector<std::string> readRow(istream &ifs, char separator) {
     char buffer[65536];
     bool insideEscaped = false;
@@ -86,7 +331,8 @@ std::string convertString(const char *s, int len) {
 }
 
 InmemoryTable::InmemoryTable(std::string repository, std::string tablename,
-        PredId_t predid, EDBLayer *layer, char sep, bool loadData) {
+        PredId_t predid, EDBLayer *layer, char sep, bool loadData,
+        int nthreads) {
     this->layer = layer;
     arity = 0;
     this->predid = predid;
@@ -114,6 +360,47 @@ InmemoryTable::InmemoryTable(std::string repository, std::string tablename,
             throw (e);
         }
     }
+    std::string content;
+    std::unique_ptr<CSVBuffer> contentBuffer;
+    if (ifs != NULL && loadData && nthreads > 1) {
+        LOG(DEBUGL) << "Reading " << tablefile << " with " << nthreads <<
+            " threads";
+        std::vector<std::vector<Term_t>> values;
+        loadCSVParallel(*ifs, sep, layer, nthreads, tablefile, arity, values,
+                content);
+        delete ifs;
+        ifs = NULL;
+        const size_t nrows = values.empty() ? 0 : values[0].size();
+        if (content.empty()) {
+            if (nrows == 0) {
+                segment = NULL;
+                return;
+            }
+            std::vector<std::shared_ptr<Column>> columns;
+            for(auto &v : values) {
+                columns.push_back(std::shared_ptr<Column>(
+                            new InmemoryColumn(v, true)));
+            }
+            std::shared_ptr<const Segment> seg(new Segment(arity, columns));
+            segment = seg->sortBy(NULL, nthreads, true);
+            return;
+        }
+        //The rest of the file contains quoted fields, which are parsed
+        //sequentially after the rows already loaded
+        if (nrows > 0) {
+            inserter = new SegmentInserter(arity);
+            Term_t rowc[256];
+            for(size_t i = 0; i < nrows; ++i) {
+                for(uint8_t c = 0; c < arity; ++c) {
+                    rowc[c] = values[c][i];
+                }
+                inserter->addRow(rowc);
+            }
+        }
+        contentBuffer = std::unique_ptr<CSVBuffer>(new CSVBuffer(
+                    &content[0], &content[0] + content.size()));
+        ifs = new istream(contentBuffer.get());
+    }
     if (ifs != NULL) {
         LOG(DEBUGL) << "Reading " << tablefile;
         while (! ifs->eof()) {
@@ -296,6 +583,74 @@ InmemoryTable::InmemoryTable(PredId_t predid,
     delete inserter;
 }
 
+static uint64_t __getKeyFromFields(const std::vector<uint8_t> &fields,
+        uint8_t sz);
+
+InmemoryTable::InmemoryTable(PredId_t predid,
+        std::shared_ptr<BinaryTableFile> file,
+        EDBLayer *layer,
+        int nthreads) {
+    this->arity = file->getArity();
+    this->predid = predid;
+    this->layer = layer;
+    const size_t nrows = file->getNRows();
+
+    //Add the terms to the dictionary. If they get the same IDs they had when
+    //the file was created, then the columns can be used as they are
+    std::vector<Term_t> ids(file->getNTerms());
+    bool sameIds = true;
+    for(size_t i = 0; i < ids.size(); ++i) {
+        size_t len;
+        const char *text = file->getTerm(i, len);
+        uint64_t id;
+        layer->getOrAddDictNumber(text, len, id);
+        ids[i] = id;
+        sameIds = sameIds && id == file->getTermId(i);
+    }
+    if (nrows == 0) {
+        segment = NULL;
+    } else if (sameIds) {
+        for(size_t o = 0; o < file->getNOrders(); ++o) {
+            std::vector<std::shared_ptr<Column>> columns;
+            for(uint8_t i = 0; i < arity; ++i) {
+                columns.push_back(std::shared_ptr<Column>(new MappedColumn(
+                                file, file->getColumn(o, i), nrows)));
+            }
+            std::shared_ptr<const Segment> seg(new Segment(arity, columns));
+            if (o == 0) {
+                segment = seg;
+            } else {
+                const auto &order = file->getOrder(o);
+                for(uint8_t i = 0; i < arity; ++i) {
+                    auto key = __getKeyFromFields(order, i + 1);
+                    if (!cachedSortedSegments.count(key))
+                        cachedSortedSegments[key] = seg;
+                }
+            }
+        }
+    } else {
+        //The dictionary has changed: translate the IDs and sort again
+        LOG(WARNL) << "The IDs of the terms in the binary table of " <<
+            layer->getPredName(predid) << " have changed. The table must be "
+            "sorted again";
+        const Term_t *begin = file->getTermIds();
+        const Term_t *end = begin + ids.size();
+        std::vector<std::shared_ptr<Column>> columns;
+        for(uint8_t i = 0; i < arity; ++i) {
+            const Term_t *values = file->getColumn(0, i);
+            std::vector<Term_t> column(nrows);
+            for(size_t j = 0; j < nrows; ++j) {
+                auto itr = std::lower_bound(begin, end, values[j]);
+                column[j] = (itr != end && *itr == values[j]) ?
+                    ids[itr - begin] : values[j];
+            }
+            columns.push_back(std::shared_ptr<Column>(
+                        new InmemoryColumn(column, true)));
+        }
+        segment = Segment(arity, columns).sortBy(NULL, nthreads, true);
+    }
+}
+
 struct VSorter {
     unsigned sz;
 
@@ -1,5 +1,7 @@
 package karmaresearch.vlog;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.Iterator;
 import java.util.NoSuchElementException;
 
@@ -85,6 +87,89 @@ public class QueryResultIterator implements Iterator<long[]>, AutoCloseable {
         return retval;
     }
 
+    /**
+     * Returns the number of terms in each result.
+     *
+     * @return the number of terms in each result.
+     */
+    public int getTupleSize() {
+        if (cleaned) {
+            throw new IllegalStateException("Iterator already closed");
+        }
+        return getTupleSize(handle);
+    }
+
+    // Moves the result read by hasNext, if any, into buffer
+    private int takeSaved(long[] buffer, int offset) {
+        hasNextCalled = false;
+        if (saved == null) {
+            return 0;
+        }
+        System.arraycopy(saved, 0, buffer, offset, saved.length);
+        saved = null;
+        return 1;
+    }
+
+    /**
+     * Copies as many results as fit in the buffer, one after the other,
+     * starting at the beginning of the buffer. This avoids a call to native
+     * code for each result.
+     *
+     * @param buffer
+     *            the buffer; it must have room for at least one result.
+     * @return the number of results copied, 0 if there are no more results.
+     */
+    public int next(long[] buffer) {
+        if (cleaned) {
+            throw new IllegalStateException("Iterator already closed");
+        }
+        int tupleSize = getTupleSize(handle);
+        if (buffer.length < tupleSize) {
+            throw new IllegalArgumentException("The buffer is too small");
+        }
+        int n = takeSaved(buffer, 0);
+        return n + nextBlock(handle, buffer, n * tupleSize, filterBlanks);
+    }
+
+    /**
+     * Copies as many results as fit in the buffer, one after the other,
+     * starting at its position. The terms are written as longs in the native
+     * byte order (see {@link ByteBuffer#asLongBuffer()}) and the position is
+     * moved after the last result. This avoids a call to native code for each
+     * result and, with a direct buffer, any copy on the Java side.
+     *
+     * @param buffer
+     *            the buffer; it must be direct, in the native byte order,
+     *            and have room for at least one result.
+     * @return the number of results copied, 0 if there are no more results.
+     */
+    public int next(ByteBuffer buffer) {
+        if (cleaned) {
+            throw new IllegalStateException("Iterator already closed");
+        }
+        if (!buffer.isDirect() || buffer.order() != ByteOrder.nativeOrder()) {
+            throw new IllegalArgumentException(
+                    "The buffer must be direct and in the native byte order");
+        }
+        int tupleSize = getTupleSize(handle);
+        if (buffer.remaining() < tupleSize * 8) {
+            throw new IllegalArgumentException("The buffer is too small");
+        }
+        int n = 0;
+        hasNextCalled = false;
+        if (saved != null) {
+            for (long v : saved) {
+                buffer.putLong(v);
+            }
+            saved = null;
+            n = 1;
+        }
+        int block = nextBlockDirect(handle, buffer, buffer.position(),
+                buffer.remaining(), filterBlanks);
+        buffer.position(buffer.position() + block * tupleSize * 8);
+        return n + block;
+    }
+
     /**
      * Cleans up the underlying VLog iterator, if not done before.
      */
@@ -107,6 +192,14 @@ public class QueryResultIterator implements Iterator<long[]>, AutoCloseable {
 
     private native boolean hasBlanks(long[] v);
 
+    private native int getTupleSize(long handle);
+
+    private native int nextBlock(long handle, long[] buffer, int offset,
+            boolean filterBlanks);
+
+    private native int nextBlockDirect(long handle, ByteBuffer buffer,
+            int offset, int length, boolean filterBlanks);
+
     @Override
     public void close() {
         if (!cleaned) {
@@ -4,6 +4,7 @@ import java.io.BufferedInputStream;
 import java.io.File;
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.ByteBuffer;
 import java.nio.file.Files;
 import java.nio.file.StandardCopyOption;
 import java.util.ArrayList;
@@ -186,6 +187,69 @@ public class VLog {
     public native void addData(String predicate, String[][] contents)
             throws EDBConfigurationException;
 
+    /**
+     * Adds the data for the specified predicate to the database, like
+     * {@link #addData(String, String[][])}, but the terms are given as
+     * constant ids (see {@link #getOrAddConstantId(String)}). The rows are
+     * stored one after the other, so <code>contents</code> contains
+     * <code>arity</code> values for each row.
+     *
+     * @param predicate
+     *            the predicate
+     * @param arity
+     *            the arity of the predicate
+     * @param contents
+     *            the data
+     * @exception EDBConfigurationException
+     *                is thrown when the length of <code>contents</code> is
+     *                not a multiple of the arity.
+     */
+    public native void addDataIds(String predicate, int arity, long[] contents)
+            throws EDBConfigurationException;
+
+    /**
+     * Adds the data for the specified predicate to the database, like
+     * {@link #addData(String, String[][])}, but the terms are read from a
+     * buffer, between its position and its limit. Each term is encoded in
+     * UTF-8 and terminated by a 0 byte, and the rows are stored one after the
+     * other. Direct buffers are read without copying them. The position of
+     * the buffer is set to its limit.
+     *
+     * @param predicate
+     *            the predicate
+     * @param arity
+     *            the arity of the predicate
+     * @param contents
+     *            the data
+     * @exception EDBConfigurationException
+     *                is thrown when the number of terms is not a multiple of
+     *                the arity, or when the last term is not terminated.
+     */
+    public void addData(String predicate, int arity, ByteBuffer contents)
+            throws EDBConfigurationException {
+        int offset = contents.position();
+        int length = contents.remaining();
+        if (contents.isDirect()) {
+            addDataBuffer(predicate, arity, contents, offset, length);
+        } else if (contents.hasArray()) {
+            addDataBytes(predicate, arity, contents.array(),
+                    contents.arrayOffset() + offset, length);
+        } else {
+            byte[] copy = new byte[length];
+            contents.duplicate().get(copy);
+            addDataBytes(predicate, arity, copy, 0, length);
+        }
+        contents.position(contents.limit());
+    }
+
+    private native void addDataBuffer(String predicate, int arity,
+            ByteBuffer contents, int offset, int length)
+            throws EDBConfigurationException;
+
+    private native void addDataBytes(String predicate, int arity,
+            byte[] contents, int offset, int length)
+            throws EDBConfigurationException;
+
     /**
      * Stops and de-allocates the reasoner. If vlog is not started yet, this
      * call does nothing, so it does no harm to call it more than once.
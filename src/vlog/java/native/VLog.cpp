@@ -214,6 +214,104 @@ std::vector<Literal> getVectorLiteral(JNIEnv *env, VLogInfo *f, jobjectArray h,
 	return result;
 }
 
+// Prepares VLog to receive data with addData. If VLog is not started yet, it
+// is started with an empty configuration. Returns NULL if an exception was thrown.
+VLogInfo *getVLogInfoForData(JNIEnv *env, jobject obj) {
+	jint id = getVLogId(env, obj);
+	VLogInfo *f = getVLogInfo(id);
+	if (f == NULL) {
+		f = new VLogInfo();
+		vlogMap[id] = f;
+	}
+
+	if (! logLevelSet) {
+		Logger::setMinLevel(INFOL);
+	}
+
+	if (f->layer == NULL) {
+		EDBConf conf("", false);
+		f->layer = new EDBLayer(conf, false);
+	}
+
+	if (f->program != NULL) {
+		if (f->program->getNRules() > 0) {
+			throwEDBConfigurationException(env, "Cannot add data if there already are rules");
+			return NULL;
+		}
+		delete f->program;
+		f->program = NULL;
+	}
+	return f;
+}
+
+// Adds a table with the rows (already encoded, one after the other) to the database.
+void addDataIds(JNIEnv *env, VLogInfo *f, const std::string &pred, jint arity,
+		std::vector<uint64_t> &rows) {
+	if (arity < 1 || arity != (uint8_t) arity) {
+		throwIllegalArgumentException(env, ("Invalid arity of " + pred + " (" + std::to_string(arity) + ")").c_str());
+	} else if (rows.size() % arity != 0) {
+		throwEDBConfigurationException(env, ("The number of terms of " + pred + " is not a multiple of its arity").c_str());
+	} else {
+		PredId_t predId = f->layer->addEDBPredicate(pred);
+		f->layer->addInmemoryTable(predId, (uint8_t) arity, rows);
+	}
+	// Restore the program also after an error
+	f->program = new Program(f->layer);
+}
+
+// Splits data, a sequence of UTF-8 terms each terminated by a 0 byte.
+// Returns false if the last term is not terminated.
+bool splitTerms(const char *data, size_t len, std::vector<std::string> &terms) {
+	size_t start = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (data[i] == '\0') {
+			terms.push_back(std::string(data + start, i - start));
+			start = i + 1;
+		}
+	}
+	return start == len;
+}
+
+// Adds a table with the terms in data (see splitTerms) to the database.
+void addDataUTF8(JNIEnv *env, VLogInfo *f, const std::string &pred, jint arity,
+		std::vector<std::string> &terms) {
+	std::vector<uint64_t> rows;
+	f->layer->getOrAddDictNumbers(terms, rows);
+	addDataIds(env, f, pred, arity, rows);
+}
+
+// Copies the next tuples of iter in out, which has room for capacity values.
+// Tuples with blanks are skipped if filterBlanks is set. Returns the number of
+// tuples copied.
+size_t fillBlock(TupleIterator *iter, char *out, size_t capacity, bool filterBlanks) {
+	const size_t sz = iter->getTupleSize();
+	if (sz == 0) {
+		// Each result is an empty tuple
+		if (capacity == 0 || !iter->hasNext()) {
+			return 0;
+		}
+		iter->next();
+		return 1;
+	}
+	size_t n = 0;
+	jlong row[256];
+	while ((n + 1) * sz <= capacity && iter->hasNext()) {
+		iter->next();
+		bool blank = false;
+		for (size_t i = 0; i < sz; i++) {
+			row[i] = iter->getElementAt(i);
+			blank = blank || IS_BLANK(row[i]);
+		}
+		if (filterBlanks && blank) {
+			continue;
+		}
+		// The output may not be aligned
+		memcpy(out + n * sz * sizeof(jlong), row, sz * sizeof(jlong));
+		n++;
+	}
+	return n;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -331,33 +429,13 @@ extern "C" {
 	 * Signature: (Ljava/lang/String;[[Ljava/lang/String;)V
 	 */
 	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_addData(JNIEnv *env, jobject obj, jstring jpred, jobjectArray data) {
-		jint id = getVLogId(env, obj);
-		VLogInfo *f = getVLogInfo(id);
+		VLogInfo *f = getVLogInfoForData(env, obj);
 		if (f == NULL) {
-			f = new VLogInfo();
-			vlogMap[id] = f;
-		}
-
-		if (! logLevelSet) {
-			Logger::setMinLevel(INFOL);
-		}
-
-		if (f->layer == NULL) {
-			EDBConf conf("", false);
-			f->layer = new EDBLayer(conf, false);
+			return;
 		}
 
 		std::string pred = jstring2string(env, jpred);
 
-		if (f->program != NULL) {
-			if (f->program->getNRules() > 0) {
-				throwEDBConfigurationException(env, "Cannot add data if there already are rules");
-				return;
-			}
-			delete f->program;
-			f->program = NULL;
-		}
-
 		if (data == NULL) {
 			throwEDBConfigurationException(env, "null data");
 			return;
@@ -404,6 +482,79 @@ extern "C" {
 	}
 
 
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    addDataIds
+	 * Signature: (Ljava/lang/String;I[J)V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_addDataIds(JNIEnv *env, jobject obj, jstring jpred, jint arity, jlongArray data) {
+		if (data == NULL) {
+			throwEDBConfigurationException(env, "null data");
+			return;
+		}
+		VLogInfo *f = getVLogInfoForData(env, obj);
+		if (f == NULL) {
+			return;
+		}
+		std::string pred = jstring2string(env, jpred);
+		std::vector<uint64_t> rows(env->GetArrayLength(data));
+		env->GetLongArrayRegion(data, 0, rows.size(), (jlong *) rows.data());
+		addDataIds(env, f, pred, arity, rows);
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    addDataBytes
+	 * Signature: (Ljava/lang/String;I[BII)V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_addDataBytes(JNIEnv *env, jobject obj, jstring jpred, jint arity, jbyteArray data, jint offset, jint length) {
+		if (data == NULL) {
+			throwEDBConfigurationException(env, "null data");
+			return;
+		}
+		VLogInfo *f = getVLogInfoForData(env, obj);
+		if (f == NULL) {
+			return;
+		}
+		std::string pred = jstring2string(env, jpred);
+		std::vector<std::string> terms;
+		// No JNI calls are allowed until the array is released
+		char *bytes = (char *) env->GetPrimitiveArrayCritical(data, NULL);
+		bool ok = splitTerms(bytes + offset, length, terms);
+		env->ReleasePrimitiveArrayCritical(data, bytes, JNI_ABORT);
+		if (!ok) {
+			f->program = new Program(f->layer);
+			throwEDBConfigurationException(env, "The last term is not terminated");
+			return;
+		}
+		addDataUTF8(env, f, pred, arity, terms);
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    addDataBuffer
+	 * Signature: (Ljava/lang/String;ILjava/nio/ByteBuffer;II)V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_addDataBuffer(JNIEnv *env, jobject obj, jstring jpred, jint arity, jobject data, jint offset, jint length) {
+		char *bytes = data == NULL ? NULL : (char *) env->GetDirectBufferAddress(data);
+		if (bytes == NULL) {
+			throwIllegalArgumentException(env, "The buffer is not direct");
+			return;
+		}
+		VLogInfo *f = getVLogInfoForData(env, obj);
+		if (f == NULL) {
+			return;
+		}
+		std::string pred = jstring2string(env, jpred);
+		std::vector<std::string> terms;
+		if (!splitTerms(bytes + offset, length, terms)) {
+			f->program = new Program(f->layer);
+			throwEDBConfigurationException(env, "The last term is not terminated");
+			return;
+		}
+		addDataUTF8(env, f, pred, arity, terms);
+	}
+
 	/*
 	 * Class:     karmaresearch_vlog_VLog
 	 * Method:    getPredicateId
@@ -961,6 +1112,60 @@ JNIEXPORT jlong JNICALL Java_karmaresearch_vlog_VLog_nativeQuerySize(JNIEnv * en
 		return outJNIArray;
 	}
 
+	/*
+	 * Class:     karmaresearch_vlog_QueryResultIterator
+	 * Method:    nextBlock
+	 * Signature: (J[JIZ)I
+	 */
+	JNIEXPORT jint JNICALL Java_karmaresearch_vlog_QueryResultIterator_nextBlock(JNIEnv *env, jobject obj, jlong ref, jlongArray buffer, jint offset, jboolean filterBlanks) {
+		TupleIterator *iter = (TupleIterator *) ref;
+		if (iter == NULL) {
+			return 0;
+		}
+		jsize length = env->GetArrayLength(buffer);
+		if (offset < 0 || offset > length) {
+			throwIllegalArgumentException(env, "Invalid offset");
+			return 0;
+		}
+		// The iterator may take long, so the tuples are collected in a native
+		// buffer instead of holding the Java array
+		std::vector<jlong> out(length - offset);
+		size_t n = fillBlock(iter, (char *) out.data(), out.size(), filterBlanks);
+		env->SetLongArrayRegion(buffer, offset, n * iter->getTupleSize(), out.data());
+		return (jint) n;
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_QueryResultIterator
+	 * Method:    nextBlockDirect
+	 * Signature: (JLjava/nio/ByteBuffer;IIZ)I
+	 */
+	JNIEXPORT jint JNICALL Java_karmaresearch_vlog_QueryResultIterator_nextBlockDirect(JNIEnv *env, jobject obj, jlong ref, jobject buffer, jint offset, jint length, jboolean filterBlanks) {
+		TupleIterator *iter = (TupleIterator *) ref;
+		if (iter == NULL) {
+			return 0;
+		}
+		char *out = (char *) env->GetDirectBufferAddress(buffer);
+		if (out == NULL) {
+			throwIllegalArgumentException(env, "The buffer is not direct");
+			return 0;
+		}
+		return (jint) fillBlock(iter, out + offset, length / sizeof(jlong), filterBlanks);
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_QueryResultIterator
+	 * Method:    getTupleSize
+	 * Signature: (J)I
+	 */
+	JNIEXPORT jint JNICALL Java_karmaresearch_vlog_QueryResultIterator_getTupleSize(JNIEnv *env, jobject obj, jlong ref) {
+		TupleIterator *iter = (TupleIterator *) ref;
+		if (iter == NULL) {
+			return 0;
+		}
+		return (jint) iter->getTupleSize();
+	}
+
 	/*
 	 * Class:     karmaresearch_vlog_QueryResultIterator
 	 * Method:    cleanup
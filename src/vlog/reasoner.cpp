@@ -377,6 +377,74 @@ TupleIterator *Reasoner::getIncrReasoningIterator(Literal &query,
     }
 }
 
+MagicProgram Reasoner::getMagicProgram(Literal &query, EDBLayer &edb,
+        Program &program) {
+    auto key = std::make_tuple(program.getGeneration(),
+            query.getPredicate().getId(), query.getPredicate().getAdornment());
+    MagicProgram magic;
+    {
+        std::lock_guard<std::mutex> lock(mtxMagicPrograms);
+        auto gen = magicGenerations.find(&program);
+        if (gen != magicGenerations.end() &&
+                gen->second != program.getGeneration()) {
+            //The program has changed since the last query
+            auto itr = magicPrograms.begin();
+            while (itr != magicPrograms.end()) {
+                if (std::get<0>(itr->first) == gen->second) {
+                    itr = magicPrograms.erase(itr);
+                } else {
+                    itr++;
+                }
+            }
+        }
+        magicGenerations[&program] = program.getGeneration();
+        auto itr = magicPrograms.find(key);
+        if (itr != magicPrograms.end()) {
+            magic = itr->second;
+        }
+    }
+    if (!magic.program) {
+        //Get all adorned rules
+        std::unique_ptr<Wizard> wizard = std::unique_ptr<Wizard>(new Wizard());
+        std::shared_ptr<Program> adornedProgram = wizard->getAdornedProgram(query, program);
+        //Print all rules
+#if DEBUG
+        LOG(DEBUGL) << "Adorned program:";
+        std::vector<Rule> newRules = adornedProgram->getAllRules();
+        for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
+            LOG(DEBUGL) << itr->tostring(adornedProgram.get(), &edb);
+        }
+#endif
+
+        //Rewrite and add the rules
+        magic.program = wizard->doMagic(query, adornedProgram,
+                magic.inputOutputRelIDs);
+
+#if DEBUG
+        LOG(DEBUGL) << "Magic program:";
+        newRules = magic.program->getAllRules();
+        for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
+            LOG(DEBUGL) << itr->tostring(magic.program.get(), &edb);
+        }
+#endif
+        std::lock_guard<std::mutex> lock(mtxMagicPrograms);
+        magicPrograms.insert(std::make_pair(key, magic));
+    } else {
+        LOG(DEBUGL) << "Reusing the magic program for the predicate " <<
+            query.getPredicate().getId() << " with adornment " <<
+            (int) query.getPredicate().getAdornment();
+    }
+    //The chases can modify their program (e.g., GBChase rewrites the cliques)
+    magic.program = std::shared_ptr<Program>(new Program(*magic.program));
+    return magic;
+}
+
+void Reasoner::clearMagicPrograms() {
+    std::lock_guard<std::mutex> lock(mtxMagicPrograms);
+    magicPrograms.clear();
+    magicGenerations.clear();
+}
+
 TupleIterator *Reasoner::getTGMagicIterator(Literal &query,
         EDBLayer &edb, Program &program, bool returnOnlyVars,
         std::string profilerPath,
@@ -400,30 +468,10 @@ TupleIterator *Reasoner::getTGMagicIterator(Literal &query,
     Predicate pred1(query.getPredicate(), Predicate::calculateAdornment(boundTuple));
     Literal query1(pred1, boundTuple);
 
-    //Get all adorned rules
-    std::unique_ptr<Wizard> wizard = std::unique_ptr<Wizard>(new Wizard());
-    std::shared_ptr<Program> adornedProgram = wizard->getAdornedProgram(query1, program);
-    //Print all rules
-#if DEBUG
-    LOG(DEBUGL) << "Adorned program:";
-    std::vector<Rule> newRules = adornedProgram->getAllRules();
-    for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
-        LOG(DEBUGL) << itr->tostring(adornedProgram.get(), &edb);
-    }
-#endif
-
-    //Rewrite and add the rules
-    std::pair<PredId_t, PredId_t> inputOutputRelIDs;
-    std::shared_ptr<Program> magicProgram = wizard->doMagic(query1, adornedProgram,
-            inputOutputRelIDs);
-
-#if DEBUG
-    LOG(DEBUGL) << "Magic program:";
-    newRules = magicProgram->getAllRules();
-    for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
-        LOG(DEBUGL) << itr->tostring(magicProgram.get(), &edb);
-    }
-#endif
+    MagicProgram magic = getMagicProgram(query1, edb, program);
+    std::shared_ptr<Program> magicProgram = magic.program;
+    const std::pair<PredId_t, PredId_t> &inputOutputRelIDs =
+        magic.inputOutputRelIDs;
 
     if (profilerPath != "") {
         std::string sout = profilerPath + "-rules";
@@ -534,30 +582,10 @@ TupleIterator *Reasoner::getProbMagicIterator(Literal &query,
     Predicate pred1(query.getPredicate(), Predicate::calculateAdornment(boundTuple));
     Literal query1(pred1, boundTuple);
 
-    //Get all adorned rules
-    std::unique_ptr<Wizard> wizard = std::unique_ptr<Wizard>(new Wizard());
-    std::shared_ptr<Program> adornedProgram = wizard->getAdornedProgram(query1, program);
-    //Print all rules
-#if DEBUG
-    LOG(DEBUGL) << "Adorned program:";
-    std::vector<Rule> newRules = adornedProgram->getAllRules();
-    for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
-        LOG(DEBUGL) << itr->tostring(adornedProgram.get(), &edb);
-    }
-#endif
-
-    //Rewrite and add the rules
-    std::pair<PredId_t, PredId_t> inputOutputRelIDs;
-    std::shared_ptr<Program> magicProgram = wizard->doMagic(query1, adornedProgram,
-            inputOutputRelIDs);
-
-#if DEBUG
-    LOG(DEBUGL) << "Magic program:";
-    newRules = magicProgram->getAllRules();
-    for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
-        LOG(DEBUGL) << itr->tostring(magicProgram.get(), &edb);
-    }
-#endif
+    MagicProgram magic = getMagicProgram(query1, edb, program);
+    std::shared_ptr<Program> magicProgram = magic.program;
+    const std::pair<PredId_t, PredId_t> &inputOutputRelIDs =
+        magic.inputOutputRelIDs;
 
     if (profilerPath != "") {
         std::string sout = profilerPath + "-rules";
@@ -705,30 +733,10 @@ TupleIterator *Reasoner::getMagicIterator(Literal &query,
     Predicate pred1(query.getPredicate(), Predicate::calculateAdornment(boundTuple));
     Literal query1(pred1, boundTuple);
 
-    //Get all adorned rules
-    std::unique_ptr<Wizard> wizard = std::unique_ptr<Wizard>(new Wizard());
-    std::shared_ptr<Program> adornedProgram = wizard->getAdornedProgram(query1, program);
-    //Print all rules
-#if DEBUG
-    LOG(DEBUGL) << "Adorned program:";
-    std::vector<Rule> newRules = adornedProgram->getAllRules();
-    for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
-        LOG(DEBUGL) << itr->tostring(adornedProgram.get(), &edb);
-    }
-#endif
-
-    //Rewrite and add the rules
-    std::pair<PredId_t, PredId_t> inputOutputRelIDs;
-    std::shared_ptr<Program> magicProgram = wizard->doMagic(query1, adornedProgram,
-            inputOutputRelIDs);
-
-#if DEBUG
-    LOG(DEBUGL) << "Magic program:";
-    newRules = magicProgram->getAllRules();
-    for (std::vector<Rule>::iterator itr = newRules.begin(); itr != newRules.end(); ++itr) {
-        LOG(DEBUGL) << itr->tostring(magicProgram.get(), &edb);
-    }
-#endif
+    MagicProgram magic = getMagicProgram(query1, edb, program);
+    std::shared_ptr<Program> magicProgram = magic.program;
+    const std::pair<PredId_t, PredId_t> &inputOutputRelIDs =
+        magic.inputOutputRelIDs;
 
     SemiNaiver *naiver = new SemiNaiver(
             edb, magicProgram.get(), true, false, false, -1, false, false) ;
@@ -110,6 +110,48 @@ uint64_t StringTable::getSize() {
     throw 10;
 }
 
+void StringTable::builtinFunctionBlock(Term_t *rows, size_t rowSize,
+        uint8_t *pos, std::vector<uint32_t> &selection) {
+    //The terms repeat in the output of a join. Each distinct term (or pair)
+    //is decoded and checked only once per block
+    size_t nselected = 0;
+    if (getArity() == 1) {
+        std::unordered_map<uint64_t, bool> outcomes;
+        for(size_t i = 0; i < selection.size(); ++i) {
+            const uint64_t t1 = rows[selection[i] * rowSize + pos[0]];
+            auto itr = outcomes.find(t1);
+            bool outcome;
+            if (itr == outcomes.end()) {
+                outcome = execFunction(t1);
+                outcomes.insert(std::make_pair(t1, outcome));
+            } else {
+                outcome = itr->second;
+            }
+            if (outcome) {
+                selection[nselected++] = selection[i];
+            }
+        }
+    } else {
+        std::unordered_map<std::pair<Term_t, Term_t>, bool> outcomes;
+        for(size_t i = 0; i < selection.size(); ++i) {
+            const Term_t *row = rows + selection[i] * rowSize;
+            const auto key = std::make_pair(row[pos[0]], row[pos[1]]);
+            auto itr = outcomes.find(key);
+            bool outcome;
+            if (itr == outcomes.end()) {
+                outcome = execFunction(key.first, key.second);
+                outcomes.insert(std::make_pair(key, outcome));
+            } else {
+                outcome = itr->second;
+            }
+            if (outcome) {
+                selection[nselected++] = selection[i];
+            }
+        }
+    }
+    selection.resize(nselected);
+}
+
 void StringTable::releaseIterator(EDBIterator *itr) {
     delete itr;
 }
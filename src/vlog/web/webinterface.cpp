@@ -27,14 +27,20 @@
 #include <thread>
 #include <regex>
 #include <csignal>
+#include <algorithm>
 
 WebInterface::WebInterface(
         ProgramArgs &vm, std::shared_ptr<Chase> sn, std::string htmlfiles,
         std::string cmdArgs, std::string edbfile) : vm(vm), sn(sn),
+    matPending(false),
     dirhtmlfiles(htmlfiles), cmdArgs(cmdArgs),
-    isActive(false),
+    activeRequests(0),
     edbFile(edbfile),
-    nthreads(1) {
+    nthreads(vm["webthreads"].as<int>()) {
+        if (nthreads < 1) {
+            LOG(ERRORL) << "The web interface needs at least one thread";
+            throw 10;
+        }
         //Setup the EDB layer
         EDBConf conf(edbFile, true);
         edb = std::unique_ptr<EDBLayer>(new EDBLayer(conf, false));
@@ -58,16 +64,99 @@ void WebInterface::setupTridentLayer() {
     }
 }
 
+void WebKBLock::lock(bool exclusive) {
+    std::unique_lock<std::mutex> lck(mtx);
+    if (exclusive) {
+        writersWaiting++;
+        cv.wait(lck, [this] { return !writer && readers == 0; });
+        writersWaiting--;
+        writer = true;
+    } else {
+        cv.wait(lck, [this] { return !writer && writersWaiting == 0; });
+        readers++;
+    }
+}
+
+void WebKBLock::unlock(bool exclusive) {
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        if (exclusive) {
+            writer = false;
+        } else {
+            readers--;
+        }
+    }
+    cv.notify_all();
+}
+
+void WebLatencyStats::add(double wait, double total) {
+    std::lock_guard<std::mutex> lck(mtx);
+    if (waitms.size() < WEB_LATENCY_SAMPLES) {
+        waitms.push_back(wait);
+        totalms.push_back(total);
+    } else {
+        waitms[count % WEB_LATENCY_SAMPLES] = wait;
+        totalms[count % WEB_LATENCY_SAMPLES] = total;
+    }
+    count++;
+}
+
+void WebLatencyStats::percentiles(std::vector<double> samples, JSON &out) {
+    if (samples.empty()) {
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](double p) {
+        return samples[(size_t)(p * (samples.size() - 1))];
+    };
+    out.put("p50", std::to_string(at(0.5)));
+    out.put("p95", std::to_string(at(0.95)));
+    out.put("p99", std::to_string(at(0.99)));
+    out.put("max", std::to_string(samples.back()));
+}
+
+void WebLatencyStats::toJSON(JSON &out) {
+    std::vector<double> w, t;
+    {
+        std::lock_guard<std::mutex> lck(mtx);
+        out.put("count", std::to_string(count));
+        w = waitms;
+        t = totalms;
+    }
+    JSON jwait, jtotal;
+    percentiles(w, jwait);
+    percentiles(t, jtotal);
+    out.add_child("waitms", jwait);
+    out.add_child("totalms", jtotal);
+}
+
 void WebInterface::processMaterialization() {
-    std::unique_lock<std::mutex> lck(mtxMatRunner);
     while (true) {
-        cvMatRunner.wait(lck);
-        if (!sn)
+        std::shared_ptr<Chase> s;
+        {
+            std::unique_lock<std::mutex> lck(mtxMatRunner);
+            cvMatRunner.wait(lck, [this] { return matPending; });
+            s = getChase();
+        }
+        if (s) {
+            s->run();
+            //From now on, queries are answered with the new materialization
+            std::atomic_store(&snFinished, s);
+        }
+        {
+            std::lock_guard<std::mutex> lck(mtxMatRunner);
+            matPending = false;
+        }
+        if (!s)
             break;
-        sn->run();
     }
 }
 
+bool WebInterface::isMatPending() {
+    std::lock_guard<std::mutex> lck(mtxMatRunner);
+    return matPending;
+}
+
 void WebInterface::startThread(int port) {
     this->webport = port;
     server->start();
@@ -86,14 +175,14 @@ void WebInterface::start(int port) {
 
 void WebInterface::stop() {
     LOG(INFOL) << "Stopping server ...";
-    while (isActive) {
+    while (activeRequests > 0) {
         std::this_thread::sleep_for(chrono::milliseconds(100));
     }
     LOG(INFOL) << "Done";
 }
 
 long WebInterface::getDurationExecMs() {
-    std::chrono::system_clock::time_point start = sn->getStartingTimeMs();
+    std::chrono::system_clock::time_point start = getChase()->getStartingTimeMs();
     std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
     return std::chrono::duration_cast<std::chrono::milliseconds>(sec).count();
 }
@@ -220,7 +309,8 @@ void WebInterface::processQueryLiteralRequest(
                 getResultsQueryLiteral(sn, program, predicate, limit, pt);
             }
         } else {
-            getResultsQueryLiteral(sn, program, predicate, limit, pt);
+            getResultsQueryLiteral(std::atomic_load(&snFinished), program,
+                    predicate, limit, pt);
         }
         std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
         pt.put("runtime", std::to_string(sec.count()));
@@ -236,8 +326,71 @@ void WebInterface::processQueryLiteralRequest(
     }
 }
 
+bool WebInterface::isExclusiveRequest(const std::string &req,
+        const std::string &path) {
+    if (!Utils::starts_with(req, "POST"))
+        return false;
+    //The other POST requests either replace the KB or compute a new
+    //materialization with the EDB layer
+    return path != "/sparql" && path != "/lookup" &&
+        (path != "/queryliteral" ||
+         _getValueParam(req, "rewriteProgram") == "true");
+}
+
+void WebInterface::addLatency(const std::string &path, double wait,
+        double total) {
+    WebLatencyStats *stats;
+    {
+        std::lock_guard<std::mutex> lck(mtxLatencies);
+        auto &el = latencies[path];
+        if (!el)
+            el = std::unique_ptr<WebLatencyStats>(new WebLatencyStats());
+        stats = el.get();
+    }
+    stats->add(wait, total);
+}
+
+void WebInterface::getStats(JSON &out) {
+    out.put("threads", std::to_string(nthreads));
+    //Includes the request that asks for the statistics
+    out.put("activeRequests", std::to_string(activeRequests.load()));
+    JSON endpoints;
+    std::lock_guard<std::mutex> lck(mtxLatencies);
+    for (auto &el : latencies) {
+        JSON child;
+        el.second->toJSON(child);
+        endpoints.add_child(el.first, child);
+    }
+    out.add_child("endpoints", endpoints);
+}
+
 void WebInterface::processRequest(std::string req, std::string &resp) {
     setActive();
+    auto start = std::chrono::steady_clock::now();
+    std::string path;
+    size_t pos = req.find("HTTP");
+    size_t posPath = req.find(' ');
+    if (pos != std::string::npos && posPath != std::string::npos &&
+            posPath + 1 < pos) {
+        path = req.substr(posPath + 1, pos - posPath - 2);
+    }
+    const bool exclusive = isExclusiveRequest(req, path);
+    std::chrono::duration<double, std::milli> wait;
+    {
+        WebKBLock::Guard guard(kbLock, exclusive);
+        wait = std::chrono::steady_clock::now() - start;
+        executeRequest(req, resp);
+    }
+    std::chrono::duration<double, std::milli> total =
+        std::chrono::steady_clock::now() - start;
+    //Pages are served from the cache, only the API calls are recorded
+    if (path.find('.') == std::string::npos && path.size() > 1) {
+        addLatency(path, wait.count(), total.count());
+    }
+    setInactive();
+}
+
+void WebInterface::executeRequest(std::string &req, std::string &resp) {
     //Get the page
     std::string page;
     bool isjson = false;
@@ -469,7 +622,13 @@ void WebInterface::processRequest(std::string req, std::string &resp) {
         } else if (path == "/queryliteral") {
             processQueryLiteralRequest(req, page, error);
             isjson = true;
+        } else if (path == "/setup" && isMatPending()) {
+            //The materialization reads the EDB layer and the program
+            error = 1;
+            page = "Cannot change the KB while a materialization is running!";
         } else if (path == "/setup") {
+            //The last materialization refers to the old program
+            std::atomic_store(&snFinished, std::shared_ptr<Chase>());
             std::string form = req.substr(req.find("application/x-www-form-urlencoded"));
             std::string srules = _getValueParam(form, "rules");
             std::string spremat = _getValueParam(form, "queries");
@@ -681,10 +840,11 @@ void WebInterface::processRequest(std::string req, std::string &resp) {
 
         } else if (path == "/launchMat") {
             //Start a materialization
+            std::lock_guard<std::mutex> lck(mtxMatRunner);
             if (program) {
-                if (!sn || !sn->isRunning()) {
+                if (!matPending) {
                     bool multithreaded = vm["multithreaded"].as<bool>();
-                    sn = Reasoner::getSemiNaiver(*edb.get(),
+                    std::shared_ptr<Chase> newsn = Reasoner::getSemiNaiver(*edb.get(),
                             program.get(), ! vm["no-intersect"].as<bool>(),
                             ! vm["no-filtering"].as<bool>(),
                             multithreaded,
@@ -693,6 +853,9 @@ void WebInterface::processRequest(std::string req, std::string &resp) {
                             multithreaded ? vm["nthreads"].as<int>() : -1,
                             multithreaded ? vm["interRuleThreads"].as<int>() : 0,
                             vm["shufflerules"].as<bool>());
+                    //Queries keep reading the previous materialization
+                    std::atomic_store(&sn, newsn);
+                    matPending = true;
                     cvMatRunner.notify_one(); //start the computation
                     page = getPage("/mat/infobox.html");
                 } else {
@@ -704,6 +867,15 @@ void WebInterface::processRequest(std::string req, std::string &resp) {
                 page = "You first need to load the rules!";
             }
 
+        } else if (path == "/stats") {
+            //Latencies of the requests, to monitor the query service
+            JSON pt;
+            getStats(pt);
+            std::ostringstream buf;
+            JSON::write(buf, pt);
+            page = buf.str();
+            isjson = true;
+
         } else if (path == "/sizeidbs") {
             JSON pt;
             std::vector<std::pair<string, std::vector<StatsSizeIDB>>> sizeIDBs = getChase()->getSizeIDBs();
@@ -749,7 +921,6 @@ void WebInterface::processRequest(std::string req, std::string &resp) {
     } else {
         resp = "HTTP/1.1 " + code + "\r\nContent-Length: " + to_string(page.size()) + "\r\n\r\n" + page;
     }
-    setInactive();
 }
 
 std::string WebInterface::getDefaultPage() {
@@ -757,6 +928,7 @@ std::string WebInterface::getDefaultPage() {
 }
 
 std::string WebInterface::getPage(std::string f) {
+    std::lock_guard<std::mutex> lck(mtxCache);
     if (cachehtml.count(f)) {
         return cachehtml.find(f)->second;
     }